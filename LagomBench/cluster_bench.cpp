@@ -0,0 +1,132 @@
+#include "cluster_bench.h"
+#include "clustered_lighting.h"
+#include "renderer.h"
+#include "shared.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+typedef std::chrono::steady_clock BenchClock;
+
+static double seconds_since(BenchClock::time_point start)
+{
+    return std::chrono::duration<double>(BenchClock::now() - start).count();
+}
+
+int clusters_command(int argc, char** argv)
+{
+    if (argc != 0) {
+        std::cout << "Usage: LagomBench clusters" << std::endl;
+        return 1;
+    }
+
+    Renderer renderer;
+    VkDevice device = renderer.get_vulkan_device();
+    VkQueue queue = renderer.get_vulkan_queue();
+    const VkPhysicalDeviceProperties& properties = renderer.get_vulkan_physical_device_properties();
+    bool timestamps_supported = properties.limits.timestampComputeAndGraphics == VK_TRUE;
+
+    VkCommandPoolCreateInfo pool_create_info{};
+    pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    pool_create_info.queueFamilyIndex = renderer.get_vulkan_graphics_family_index();
+    VkCommandPool command_pool = VK_NULL_HANDLE;
+    error_check(vkCreateCommandPool(device, &pool_create_info, nullptr, &command_pool));
+
+    VkCommandBufferAllocateInfo command_buffer_allocate_info{};
+    command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    command_buffer_allocate_info.commandPool = command_pool;
+    command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    command_buffer_allocate_info.commandBufferCount = 1;
+    VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+    error_check(vkAllocateCommandBuffers(device, &command_buffer_allocate_info, &command_buffer));
+
+    VkQueryPool query_pool = VK_NULL_HANDLE;
+    if (timestamps_supported) {
+        VkQueryPoolCreateInfo query_pool_create_info{};
+        query_pool_create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        query_pool_create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        query_pool_create_info.queryCount = 2;
+        error_check(vkCreateQueryPool(device, &query_pool_create_info, nullptr, &query_pool));
+    } else {
+        std::cout << "Timestamps not supported, GPU times are not measured." << std::endl;
+    }
+
+    // Camera at the origin looking down -z, lights scattered through the visible depth range.
+    const float vertical_fov = 1.0f;
+    const float aspect = 16.0f / 9.0f;
+    const float near_plane = 0.1f;
+    const float far_plane = 200.0f;
+    float view[16] = {};
+    view[0] = view[5] = view[10] = view[15] = 1.0f;
+    const float tan_half_y = std::tan(vertical_fov * 0.5f);
+
+    const uint32_t frames = 100;
+    const uint32_t light_counts[] = { 16, 256, 4096, 16384 };
+    for (uint32_t light_count : light_counts) {
+        ClusteredLighting lighting(&renderer, light_count);
+        ClusterLight* lights = lighting.get_lights();
+        uint32_t state = 12345;
+        auto next_random = [&state]() {
+            state = state * 1664525u + 1013904223u;
+            return (float)(state >> 8) / (float)(1 << 24);
+        };
+        for (uint32_t i = 0; i < light_count; ++i) {
+            float depth = 1.0f + next_random() * (far_plane * 0.5f - 1.0f);
+            lights[i].position[0] = (next_random() * 2.0f - 1.0f) * depth * tan_half_y * aspect;
+            lights[i].position[1] = (next_random() * 2.0f - 1.0f) * depth * tan_half_y;
+            lights[i].position[2] = -depth;
+            lights[i].radius = 1.0f + next_random() * 4.0f;
+            lights[i].color[0] = lights[i].color[1] = lights[i].color[2] = lights[i].color[3] = 1.0f;
+        }
+        lighting.set_light_count(light_count);
+        lighting.set_view(view, vertical_fov, aspect, near_plane, far_plane);
+
+        double record_seconds = 0.0;
+        double gpu_ms = 0.0;
+        for (uint32_t frame = 0; frame < frames; ++frame) {
+            VkCommandBufferBeginInfo command_buffer_begin_info{};
+            command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            error_check(vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info));
+            if (timestamps_supported) {
+                vkCmdResetQueryPool(command_buffer, query_pool, 0, 2);
+                vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, query_pool, 0);
+            }
+            BenchClock::time_point start = BenchClock::now();
+            lighting.record_binning(command_buffer);
+            record_seconds += seconds_since(start);
+            if (timestamps_supported) {
+                vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, query_pool, 1);
+            }
+            error_check(vkEndCommandBuffer(command_buffer));
+
+            VkSubmitInfo submit_info{};
+            submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submit_info.commandBufferCount = 1;
+            submit_info.pCommandBuffers = &command_buffer;
+            error_check(vkQueueSubmit(queue, 1, &submit_info, VK_NULL_HANDLE));
+            error_check(vkQueueWaitIdle(queue));
+
+            if (timestamps_supported) {
+                uint64_t timestamps[2] = {};
+                error_check(vkGetQueryPoolResults(device, query_pool, 0, 2,
+                    sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+                gpu_ms += (double)(timestamps[1] - timestamps[0]) * properties.limits.timestampPeriod / 1000000.0;
+            }
+        }
+
+        std::cout << light_count << " lights: record " << record_seconds * 1e6 / frames << " us";
+        if (timestamps_supported) {
+            std::cout << ", GPU " << gpu_ms / frames << " ms";
+        }
+        std::cout << std::endl;
+    }
+
+    if (query_pool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(device, query_pool, nullptr);
+    }
+    vkDestroyCommandPool(device, command_pool, nullptr);
+    return 0;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+// LagomBench clusters
+// Bins 16, 256, 4096 and 16384 lights scattered through the view frustum
+// with ClusteredLighting on the first Vulkan device, 100 submissions each,
+// and prints the CPU time of record_binning and the GPU time of the pass.
+int clusters_command(int argc, char** argv);
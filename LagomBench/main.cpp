@@ -0,0 +1,90 @@
+#include "cluster_bench.h"
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#if defined( _WIN32 )
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
+// Probed to tell whether a directory is the one the engine loads shaders from.
+static const char* SHADER_PROBE = "shaders/cluster_lights.comp.spv";
+
+static void print_usage()
+{
+    std::cout << "Usage: LagomBench <benchmark> [arguments]" << std::endl;
+    std::cout << "  clusters" << std::endl;
+}
+
+static bool file_exists(const std::string& filename)
+{
+    return std::ifstream(filename, std::ios::binary).is_open();
+}
+
+static std::string get_executable_directory()
+{
+    char path[4096] = {};
+#if defined( _WIN32 )
+    DWORD length = GetModuleFileNameA(nullptr, path, sizeof(path));
+#else
+    ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+#endif
+    if (length <= 0) {
+        return std::string();
+    }
+    std::string directory(path, (size_t)length);
+    size_t slash = directory.find_last_of("/\\");
+    return slash != std::string::npos ? directory.substr(0, slash) : std::string();
+}
+
+static bool change_directory(const std::string& directory)
+{
+#if defined( _WIN32 )
+    return SetCurrentDirectoryA(directory.c_str()) != 0;
+#else
+    return chdir(directory.c_str()) == 0;
+#endif
+}
+
+// The engine loads shaders relative to the working directory. Unless that
+// already works, walk up from the executable (Debug/, x64/Release/ and so
+// on) to the LagomVulkan directory, so the benchmarks run from anywhere.
+static bool enter_shader_directory()
+{
+    if (file_exists(SHADER_PROBE)) {
+        return true;
+    }
+    std::string directory = get_executable_directory();
+    for (uint32_t depth = 0; depth < 4 && !directory.empty(); ++depth) {
+        std::string candidate = directory + "/LagomVulkan";
+        if (file_exists(candidate + "/" + SHADER_PROBE)) {
+            return change_directory(candidate);
+        }
+        size_t slash = directory.find_last_of("/\\");
+        directory = slash != std::string::npos ? directory.substr(0, slash) : std::string();
+    }
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        print_usage();
+        return 1;
+    }
+    if (!enter_shader_directory()) {
+        std::cout << "Compiled shaders not found, build LagomVulkan first" << std::endl;
+        return 1;
+    }
+
+    std::string benchmark = argv[1];
+    if (benchmark == "clusters") {
+        return clusters_command(argc - 2, argv + 2);
+    }
+    print_usage();
+    return 1;
+}
@@ -0,0 +1,194 @@
+#include "asset_packer.h"
+#include "asset_pack.h"
+#include "audio_import.h"
+#include "mapped_file.h"
+#include "wave_file.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct PackedEntry {
+    std::string name;
+    AssetPackEntry entry{};
+};
+
+static bool ends_with(const std::string& text, const std::string& suffix)
+{
+    if (text.size() < suffix.size()) {
+        return false;
+    }
+    return std::equal(suffix.rbegin(), suffix.rend(), text.rbegin(), [](char a, char b) {
+        return (a >= 'A' && a <= 'Z' ? a - 'A' + 'a' : a) == b;
+    });
+}
+
+static void pad_to(std::ofstream& output, uint64_t alignment)
+{
+    static const char zeros[ASSET_PACK_ALIGNMENT] = {};
+    uint64_t position = (uint64_t)output.tellp();
+    uint64_t padding = (alignment - position % alignment) % alignment;
+    output.write(zeros, (std::streamsize)padding);
+}
+
+// Writes the blob for one source file, returns its type or false on failure.
+static bool write_blob(std::ofstream& output, const std::string& path, AssetType* type)
+{
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cout << "Unable to open: " << path << std::endl;
+        return false;
+    }
+
+    if (ends_with(path, ".spv")) {
+        if (file.get_size() % 4 != 0) {
+            std::cout << "SPIR-V size is not a multiple of 4: " << path << std::endl;
+            return false;
+        }
+        *type = ASSET_TYPE_SPIRV;
+    }
+    else if (ends_with(path, ".wav")) {
+        // Sounds are stored canonical so the runtime never converts.
+        WaveFile wave;
+        ImportedSound sound;
+        if (!parse_wave(file.get_data(), file.get_size(), &wave) || !import_wave(wave, &sound)) {
+            std::cout << "Unsupported WAVE file: " << path << std::endl;
+            return false;
+        }
+        AssetSoundHeader header{};
+        header.channels = sound.channels;
+        header.frame_count = sound.frame_count;
+        header.sample_rate = CANONICAL_SAMPLE_RATE;
+        output.write((const char*)&header, sizeof(header));
+        output.write((const char*)sound.get_samples(), sound.get_byte_size());
+        *type = ASSET_TYPE_SOUND;
+        return true;
+    }
+    else if (ends_with(path, ".ktx2")) {
+        *type = ASSET_TYPE_TEXTURE;
+    }
+    else if (ends_with(path, ".lmesh")) {
+        *type = ASSET_TYPE_MESH;
+    }
+    else {
+        *type = ASSET_TYPE_RAW;
+    }
+
+    output.write((const char*)file.get_data(), (std::streamsize)file.get_size());
+    return true;
+}
+
+int pack_command(int argc, char** argv)
+{
+    if (argc != 3) {
+        std::cout << "Usage: LagomTools pack <output.pak> <root directory> <manifest>" << std::endl;
+        return 1;
+    }
+    std::string output_path = argv[0];
+    std::string root = argv[1];
+    if (!root.empty() && root.back() != '/' && root.back() != '\\') {
+        root += '/';
+    }
+
+    std::ifstream manifest(argv[2]);
+    if (!manifest.is_open()) {
+        std::cout << "Unable to open manifest: " << argv[2] << std::endl;
+        return 1;
+    }
+    std::vector<PackedEntry> entries;
+    std::string line;
+    while (std::getline(manifest, line)) {
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t')) {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        PackedEntry packed;
+        packed.name = line;
+        std::replace(packed.name.begin(), packed.name.end(), '\\', '/');
+        packed.entry.name_hash = hash_asset_name(packed.name);
+        entries.push_back(packed);
+    }
+
+    std::ofstream output(output_path, std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) {
+        std::cout << "Unable to create: " << output_path << std::endl;
+        return 1;
+    }
+    AssetPackHeader header{};
+    output.write((const char*)&header, sizeof(header));
+
+    // Blobs go in manifest order so a level load reads the file front to back.
+    for (auto& packed : entries) {
+        pad_to(output, ASSET_PACK_ALIGNMENT);
+        packed.entry.offset = (uint64_t)output.tellp();
+        AssetType type = ASSET_TYPE_RAW;
+        if (!write_blob(output, root + packed.name, &type)) {
+            return 1;
+        }
+        packed.entry.size = (uint64_t)output.tellp() - packed.entry.offset;
+        packed.entry.type = type;
+    }
+
+    std::vector<char> names;
+    for (auto& packed : entries) {
+        packed.entry.name_offset = (uint32_t)names.size();
+        names.insert(names.end(), packed.name.begin(), packed.name.end());
+        names.push_back('\0');
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const PackedEntry& a, const PackedEntry& b) {
+        return a.entry.name_hash < b.entry.name_hash;
+    });
+    for (size_t i = 1; i < entries.size(); ++i) {
+        if (entries[i].entry.name_hash == entries[i - 1].entry.name_hash) {
+            std::cout << "Duplicate or colliding names: " << entries[i - 1].name << ", " << entries[i].name << std::endl;
+            return 1;
+        }
+    }
+
+    pad_to(output, alignof(AssetPackEntry));
+    header.toc_offset = (uint64_t)output.tellp();
+    for (auto& packed : entries) {
+        output.write((const char*)&packed.entry, sizeof(packed.entry));
+    }
+    header.names_offset = (uint64_t)output.tellp();
+    output.write(names.data(), (std::streamsize)names.size());
+
+    header.magic = ASSET_PACK_MAGIC;
+    header.version = ASSET_PACK_VERSION;
+    header.entry_count = (uint32_t)entries.size();
+    header.alignment = ASSET_PACK_ALIGNMENT;
+    output.seekp(0);
+    output.write((const char*)&header, sizeof(header));
+
+    if (!output.good()) {
+        std::cout << "Unable to write: " << output_path << std::endl;
+        return 1;
+    }
+    std::cout << "Packed " << entries.size() << " assets into " << output_path << std::endl;
+    return 0;
+}
+
+int list_command(int argc, char** argv)
+{
+    if (argc != 1) {
+        std::cout << "Usage: LagomTools list <pack>" << std::endl;
+        return 1;
+    }
+    AssetPack pack;
+    if (!pack.open(argv[0])) {
+        return 1;
+    }
+
+    static const char* type_names[] = { "raw", "spirv", "sound", "texture", "mesh" };
+    for (uint32_t i = 0; i < pack.get_entry_count(); ++i) {
+        const AssetPackEntry& entry = pack.get_entry(i);
+        const char* type_name = entry.type < 5 ? type_names[entry.type] : "unknown";
+        std::cout << type_name << "\t" << entry.size << "\t" << pack.get_entry_name(i) << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+// LagomTools pack <output.pak> <root directory> <manifest>
+// The manifest lists one asset name per line, relative to the root
+// directory, in the order the game loads them. Blank lines and lines
+// starting with # are skipped.
+int pack_command(int argc, char** argv);
+
+// LagomTools list <pack>
+int list_command(int argc, char** argv);
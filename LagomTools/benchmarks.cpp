@@ -0,0 +1,297 @@
+#include "benchmarks.h"
+#include "audio_import.h"
+#include "audio_mixer.h"
+#include "mapped_file.h"
+#include "simd_math.h"
+#include "wave_file.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined( _WIN32 )
+#include <Windows.h>
+#else
+#include <dirent.h>
+#endif
+
+typedef std::chrono::steady_clock BenchClock;
+
+// Results are summed in here so the optimizer keeps the measured work.
+static volatile int64_t bench_sink = 0;
+
+static double seconds_since(BenchClock::time_point start)
+{
+    return std::chrono::duration<double>(BenchClock::now() - start).count();
+}
+
+static void print_bench_usage()
+{
+    std::cout << "Usage: LagomTools bench wave <directory> [--passes <count>]" << std::endl;
+    std::cout << "       LagomTools bench mix <sound.wav>" << std::endl;
+    std::cout << "       LagomTools bench simd" << std::endl;
+}
+
+// Names of the files in directory ending in extension, case insensitive, sorted.
+static bool list_files(const std::string& directory, const std::string& extension, std::vector<std::string>* names)
+{
+    names->clear();
+#if defined( _WIN32 )
+    WIN32_FIND_DATAA find_data;
+    HANDLE find = FindFirstFileA((directory + "\\*").c_str(), &find_data);
+    if (find == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    do {
+        if (!(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+            names->push_back(find_data.cFileName);
+        }
+    } while (FindNextFileA(find, &find_data));
+    FindClose(find);
+#else
+    DIR* dir = opendir(directory.c_str());
+    if (dir == nullptr) {
+        return false;
+    }
+    while (dirent* entry = readdir(dir)) {
+        names->push_back(entry->d_name);
+    }
+    closedir(dir);
+#endif
+    names->erase(std::remove_if(names->begin(), names->end(), [&extension](const std::string& name) {
+        if (name.size() <= extension.size()) {
+            return true;
+        }
+        return !std::equal(extension.begin(), extension.end(), name.end() - extension.size(), [](char a, char b) {
+            return a == (b >= 'A' && b <= 'Z' ? b - 'A' + 'a' : b);
+        });
+    }), names->end());
+    std::sort(names->begin(), names->end());
+    return true;
+}
+
+static int bench_wave(int argc, char** argv)
+{
+    if (argc < 1) {
+        print_bench_usage();
+        return 1;
+    }
+    std::string directory = argv[0];
+    uint32_t pass_count = 3;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--passes") == 0 && i + 1 < argc) {
+            pass_count = (uint32_t)std::max(std::atoi(argv[++i]), 1);
+        }
+        else {
+            print_bench_usage();
+            return 1;
+        }
+    }
+
+    std::vector<std::string> names;
+    if (!list_files(directory, ".wav", &names)) {
+        std::cout << "Unable to open directory: " << directory << std::endl;
+        return 1;
+    }
+    if (names.empty()) {
+        std::cout << "No .wav files in: " << directory << std::endl;
+        return 1;
+    }
+
+    for (uint32_t pass = 0; pass < pass_count; ++pass) {
+        uint64_t total_bytes = 0;
+        uint32_t failed = 0;
+        BenchClock::time_point start = BenchClock::now();
+        for (const std::string& name : names) {
+            MappedFile file;
+            WaveFile wave;
+            ImportedSound sound;
+            if (!file.open(directory + "/" + name) ||
+                !parse_wave(file.get_data(), file.get_size(), &wave) ||
+                !import_wave(wave, &sound)) {
+                ++failed;
+                continue;
+            }
+            // Canonical sounds are not copied by the import, touch them like playback would.
+            const int16_t* samples = sound.get_samples();
+            uint32_t sample_count = sound.frame_count * sound.channels;
+            int64_t sum = 0;
+            for (uint32_t i = 0; i < sample_count; i += 2048 / sizeof(int16_t)) {
+                sum += samples[i];
+            }
+            bench_sink = bench_sink + sum;
+            total_bytes += file.get_size();
+        }
+        double seconds = seconds_since(start);
+        std::cout << "Pass " << pass + 1 << ": " << names.size() - failed << " files, "
+            << total_bytes / (1024.0 * 1024.0) << " MB in " << seconds * 1000.0 << " ms, "
+            << total_bytes / (1024.0 * 1024.0) / std::max(seconds, 1e-9) << " MB/s";
+        if (failed > 0) {
+            std::cout << " (" << failed << " failed)";
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
+
+static int bench_mix(int argc, char** argv)
+{
+    if (argc != 1) {
+        print_bench_usage();
+        return 1;
+    }
+
+    // The mixer only writes its file in update(), which is never called here.
+    const char* output_filename = "bench_mix_output.wav";
+    {
+        AudioMixer mixer(output_filename);
+        int sound = mixer.load_sound(argv[0]);
+        if (sound < 0) {
+            return 1;
+        }
+
+        const uint32_t voice_counts[] = { 64, 256, 1024 };
+        const uint32_t block_count = 200;
+        std::vector<float> output(MIXER_BLOCK_FRAMES * 2);
+        for (uint32_t voice_count : voice_counts) {
+            std::vector<SoundHandle> voices(voice_count);
+            double seconds = 0.0;
+            // One untimed block first, so every sweep starts warm.
+            for (uint32_t block = 0; block <= block_count; ++block) {
+                // Voices that reached the end start over, outside of the timing.
+                for (uint32_t i = 0; i < voice_count; ++i) {
+                    if (!mixer.is_sound_playing(voices[i])) {
+                        voices[i] = mixer.play_sound(sound, 0.5f, 0);
+                        mixer.set_sound_pan(voices[i], (float)(i % 17) / 8.0f - 1.0f);
+                    }
+                }
+                BenchClock::time_point start = BenchClock::now();
+                mixer.mix(output.data(), MIXER_BLOCK_FRAMES);
+                if (block > 0) {
+                    seconds += seconds_since(start);
+                }
+                bench_sink = bench_sink + (int64_t)output[0];
+            }
+            for (SoundHandle voice : voices) {
+                mixer.stop_sound(voice);
+            }
+
+            double frames = (double)block_count * MIXER_BLOCK_FRAMES;
+            std::cout << voice_count << " voices: "
+                << seconds * 1e9 / (frames * voice_count) << " ns per voice per frame, "
+                << seconds / (frames / MIXER_SAMPLE_RATE) * 100.0 << "% of real time" << std::endl;
+        }
+    }
+    std::remove(output_filename);
+    return 0;
+}
+
+// Best of a few runs of kernel over the same data, in ns per element.
+template<typename Kernel>
+static double time_kernel(Kernel kernel, uint32_t count)
+{
+    double best = 1e30;
+    for (uint32_t run = 0; run < 10; ++run) {
+        BenchClock::time_point start = BenchClock::now();
+        kernel();
+        best = std::min(best, seconds_since(start));
+    }
+    return best * 1e9 / count;
+}
+
+static void print_speedup(const char* name, double simd_ns, double reference_ns)
+{
+    std::cout << name << ": " << simd_ns << " ns, reference " << reference_ns << " ns per element, "
+        << reference_ns / simd_ns << "x" << std::endl;
+}
+
+static int bench_simd(int argc, char** argv)
+{
+    if (argc != 0) {
+        print_bench_usage();
+        return 1;
+    }
+
+    // Enough to leave L1 but stay in cache, like a scene's worth of transforms.
+    const uint32_t count = 16384;
+    std::vector<Mat4> a(count);
+    std::vector<Mat4> b(count);
+    std::vector<Mat4> out(count);
+    std::vector<float> components(count * 14);
+    for (size_t i = 0; i < components.size(); ++i) {
+        components[i] = (float)((i * 2654435761u) % 1000) / 500.0f - 1.0f;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        for (uint32_t j = 0; j < 16; ++j) {
+            a[i].m[j] = components[(i * 16 + j) % components.size()];
+            b[i].m[j] = components[(i * 16 + j + 7) % components.size()];
+        }
+    }
+
+    TransformArrays transforms;
+    for (uint32_t j = 0; j < 3; ++j) {
+        transforms.position[j] = &components[count * j];
+    }
+    for (uint32_t j = 0; j < 4; ++j) {
+        transforms.rotation[j] = &components[count * (3 + j)];
+    }
+    transforms.scale = &components[count * 7];
+    for (uint32_t i = 0; i < count; ++i) {
+        float x = transforms.rotation[0][i];
+        float y = transforms.rotation[1][i];
+        float z = transforms.rotation[2][i];
+        float w = transforms.rotation[3][i];
+        float length = std::sqrt(x * x + y * y + z * z + w * w);
+        for (uint32_t j = 0; j < 4; ++j) {
+            transforms.rotation[j][i] = length > 0.0f ? transforms.rotation[j][i] / length : (j == 3 ? 1.0f : 0.0f);
+        }
+    }
+
+    std::vector<float> box_components(count * 12);
+    BoxArrays boxes;
+    BoxArrays out_boxes;
+    for (uint32_t j = 0; j < 3; ++j) {
+        boxes.center[j] = &components[count * (8 + j)];
+        boxes.extent[j] = &components[count * (11 + j)];
+        out_boxes.center[j] = &box_components[count * j];
+        out_boxes.extent[j] = &box_components[count * (3 + j)];
+    }
+
+    print_speedup("multiply_matrices",
+        time_kernel([&]() { multiply_matrices(out.data(), a.data(), b.data(), count); }, count),
+        time_kernel([&]() { multiply_matrices_reference(out.data(), a.data(), b.data(), count); }, count));
+    print_speedup("compose_matrices",
+        time_kernel([&]() { compose_matrices(out.data(), transforms, count); }, count),
+        time_kernel([&]() { compose_matrices_reference(out.data(), transforms, count); }, count));
+    print_speedup("transform_boxes",
+        time_kernel([&]() { transform_boxes(out_boxes, a.data(), boxes, count); }, count),
+        time_kernel([&]() { transform_boxes_reference(out_boxes, a.data(), boxes, count); }, count));
+    bench_sink = bench_sink + (int64_t)(out[count - 1].m[0] + out_boxes.extent[0][count - 1]);
+    return 0;
+}
+
+int bench_command(int argc, char** argv)
+{
+    if (argc < 1) {
+        print_bench_usage();
+        return 1;
+    }
+    std::string benchmark = argv[0];
+    if (benchmark == "wave") {
+        return bench_wave(argc - 1, argv + 1);
+    }
+    if (benchmark == "mix") {
+        return bench_mix(argc - 1, argv + 1);
+    }
+    if (benchmark == "simd") {
+        return bench_simd(argc - 1, argv + 1);
+    }
+    print_bench_usage();
+    return 1;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+// LagomTools bench wave <directory> [--passes <count>]
+// Maps, parses and imports every .wav file in the directory, the same
+// work the runtime does when it loads a sound, and prints MB/s for each
+// pass. The first pass usually reads from disk, later ones from the file
+// cache.
+//
+// LagomTools bench mix <sound.wav>
+// Plays the sound on 64, 256 and 1024 voices of a headless AudioMixer and
+// times mix() over 200 blocks, voices that end are restarted untimed.
+// Prints ns per voice per output frame and the share of real time.
+//
+// LagomTools bench simd
+// Times each simd_math kernel against its _reference version on 16k
+// elements, best of ten runs, and prints the speedup.
+int bench_command(int argc, char** argv);
@@ -0,0 +1,47 @@
+#include "asset_packer.h"
+#include "benchmarks.h"
+#include "mesh_baker.h"
+#include "texture_baker.h"
+
+#include <iostream>
+#include <string>
+
+static void print_usage()
+{
+    std::cout << "Usage: LagomTools <command> [arguments]" << std::endl;
+    std::cout << "  pack <output.pak> <root directory> <manifest>" << std::endl;
+    std::cout << "  list <pack>" << std::endl;
+    std::cout << "  bake <input.tga> <output.ktx2> <rgba8|bc1|bc3|bc4|bc5> [--srgb] [--no-mips]" << std::endl;
+    std::cout << "  mesh <input.obj> <output.lmesh> [--lods <count>]" << std::endl;
+    std::cout << "  bench wave <directory> [--passes <count>]" << std::endl;
+    std::cout << "  bench mix <sound.wav>" << std::endl;
+    std::cout << "  bench simd" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        print_usage();
+        return 1;
+    }
+
+    std::string command = argv[1];
+    if (command == "pack") {
+        return pack_command(argc - 2, argv + 2);
+    }
+    if (command == "list") {
+        return list_command(argc - 2, argv + 2);
+    }
+    if (command == "bake") {
+        return bake_command(argc - 2, argv + 2);
+    }
+    if (command == "mesh") {
+        return mesh_command(argc - 2, argv + 2);
+    }
+    if (command == "bench") {
+        return bench_command(argc - 2, argv + 2);
+    }
+
+    print_usage();
+    return 1;
+}
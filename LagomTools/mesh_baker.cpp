@@ -0,0 +1,322 @@
+#include "mesh_baker.h"
+#include "mesh_file.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Position, normal and UV of the source, 32 bytes per vertex.
+struct SourceVertex {
+    float position[3];
+    float normal[3];
+    float uv[2];
+};
+
+struct SourceMesh {
+    std::vector<SourceVertex> vertices;
+    std::vector<uint32_t> indices;
+};
+
+// OBJ indices are 1-based and negative ones count back from the end.
+static int resolve_index(const std::string& text, size_t count)
+{
+    if (text.empty()) {
+        return -1;
+    }
+    int index = std::atoi(text.c_str());
+    if (index < 0) {
+        index += (int)count;
+    }
+    else {
+        index -= 1;
+    }
+    return index >= 0 && index < (int)count ? index : -1;
+}
+
+static bool load_obj(const std::string& path, SourceMesh* mesh)
+{
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cout << "Unable to open: " << path << std::endl;
+        return false;
+    }
+
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<float> uvs;
+    // position, uv, normal -> welded vertex
+    std::map<std::tuple<int, int, int>, uint32_t> welded;
+    bool missing_normals = false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream stream(line);
+        std::string type;
+        stream >> type;
+        if (type == "v") {
+            float x = 0.0f, y = 0.0f, z = 0.0f;
+            stream >> x >> y >> z;
+            positions.insert(positions.end(), { x, y, z });
+        }
+        else if (type == "vn") {
+            float x = 0.0f, y = 0.0f, z = 0.0f;
+            stream >> x >> y >> z;
+            normals.insert(normals.end(), { x, y, z });
+        }
+        else if (type == "vt") {
+            float u = 0.0f, v = 0.0f;
+            stream >> u >> v;
+            // OBJ has v going up, Vulkan samples top down.
+            uvs.insert(uvs.end(), { u, 1.0f - v });
+        }
+        else if (type == "f") {
+            std::vector<uint32_t> polygon;
+            std::string corner;
+            while (stream >> corner) {
+                std::string parts[3];
+                size_t part = 0;
+                for (char c : corner) {
+                    if (c == '/') {
+                        if (++part > 2) {
+                            break;
+                        }
+                    }
+                    else {
+                        parts[part] += c;
+                    }
+                }
+                int position = resolve_index(parts[0], positions.size() / 3);
+                int uv = resolve_index(parts[1], uvs.size() / 2);
+                int normal = resolve_index(parts[2], normals.size() / 3);
+                if (position < 0) {
+                    std::cout << "Bad face index in: " << path << std::endl;
+                    return false;
+                }
+                missing_normals |= normal < 0;
+
+                auto key = std::make_tuple(position, uv, normal);
+                auto found = welded.find(key);
+                if (found == welded.end()) {
+                    SourceVertex vertex{};
+                    for (int i = 0; i < 3; ++i) {
+                        vertex.position[i] = positions[position * 3 + i];
+                        vertex.normal[i] = normal >= 0 ? normals[normal * 3 + i] : 0.0f;
+                    }
+                    if (uv >= 0) {
+                        vertex.uv[0] = uvs[uv * 2];
+                        vertex.uv[1] = uvs[uv * 2 + 1];
+                    }
+                    found = welded.emplace(key, (uint32_t)mesh->vertices.size()).first;
+                    mesh->vertices.push_back(vertex);
+                }
+                polygon.push_back(found->second);
+            }
+            for (size_t i = 2; i < polygon.size(); ++i) {
+                mesh->indices.insert(mesh->indices.end(), { polygon[0], polygon[i - 1], polygon[i] });
+            }
+        }
+    }
+
+    if (mesh->indices.empty()) {
+        std::cout << "No triangles in: " << path << std::endl;
+        return false;
+    }
+
+    // Area weighted face normals, summed per vertex.
+    if (missing_normals) {
+        for (auto& vertex : mesh->vertices) {
+            vertex.normal[0] = vertex.normal[1] = vertex.normal[2] = 0.0f;
+        }
+        for (size_t i = 0; i < mesh->indices.size(); i += 3) {
+            const float* a = mesh->vertices[mesh->indices[i]].position;
+            const float* b = mesh->vertices[mesh->indices[i + 1]].position;
+            const float* c = mesh->vertices[mesh->indices[i + 2]].position;
+            float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+            float face[3] = { ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0] };
+            for (size_t corner = 0; corner < 3; ++corner) {
+                float* normal = mesh->vertices[mesh->indices[i + corner]].normal;
+                normal[0] += face[0];
+                normal[1] += face[1];
+                normal[2] += face[2];
+            }
+        }
+    }
+    for (auto& vertex : mesh->vertices) {
+        float length = std::sqrt(vertex.normal[0] * vertex.normal[0] + vertex.normal[1] * vertex.normal[1] + vertex.normal[2] * vertex.normal[2]);
+        if (length > 0.0f) {
+            vertex.normal[0] /= length;
+            vertex.normal[1] /= length;
+            vertex.normal[2] /= length;
+        }
+        else {
+            vertex.normal[2] = 1.0f;
+        }
+    }
+    return true;
+}
+
+static void quantize_vertices(const std::vector<SourceVertex>& source, MeshFileHeader* header, std::vector<MeshVertex>* output)
+{
+    float low[3] = { INFINITY, INFINITY, INFINITY };
+    float high[3] = { -INFINITY, -INFINITY, -INFINITY };
+    for (const auto& vertex : source) {
+        for (int i = 0; i < 3; ++i) {
+            low[i] = vertex.position[i] < low[i] ? vertex.position[i] : low[i];
+            high[i] = vertex.position[i] > high[i] ? vertex.position[i] : high[i];
+        }
+    }
+    for (int i = 0; i < 3; ++i) {
+        header->position_center[i] = (low[i] + high[i]) * 0.5f;
+        header->position_extent[i] = (high[i] - low[i]) * 0.5f;
+    }
+
+    output->resize(source.size());
+    for (size_t v = 0; v < source.size(); ++v) {
+        MeshVertex& vertex = (*output)[v];
+        for (int i = 0; i < 3; ++i) {
+            float extent = header->position_extent[i];
+            float value = extent > 0.0f ? (source[v].position[i] - header->position_center[i]) / extent : 0.0f;
+            value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+            vertex.position[i] = (int16_t)std::lround(value * 32767.0f);
+        }
+        vertex.position[3] = 0;
+        encode_octahedral(source[v].normal, vertex.normal);
+        vertex.uv[0] = float_to_half(source[v].uv[0]);
+        vertex.uv[1] = float_to_half(source[v].uv[1]);
+    }
+}
+
+static bool write_mesh(const std::string& path, const MeshFileHeader& header, const std::vector<MeshFileLod>& lods,
+    const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices)
+{
+    std::ofstream output(path, std::ios::binary);
+    if (!output.is_open()) {
+        std::cout << "Unable to create: " << path << std::endl;
+        return false;
+    }
+    output.write((const char*)&header, sizeof(header));
+    output.write((const char*)lods.data(), (std::streamsize)(lods.size() * sizeof(MeshFileLod)));
+    static const char zeros[16] = {};
+    size_t padding = get_mesh_vertex_offset((uint32_t)lods.size()) - sizeof(header) - lods.size() * sizeof(MeshFileLod);
+    output.write(zeros, (std::streamsize)padding);
+    output.write((const char*)vertices.data(), (std::streamsize)(vertices.size() * sizeof(MeshVertex)));
+    if (header.index_size == 2) {
+        std::vector<uint16_t> short_indices(indices.begin(), indices.end());
+        output.write((const char*)short_indices.data(), (std::streamsize)(short_indices.size() * sizeof(uint16_t)));
+    }
+    else {
+        output.write((const char*)indices.data(), (std::streamsize)(indices.size() * sizeof(uint32_t)));
+    }
+    return true;
+}
+
+// A level that removes less than this share of the previous one is not worth its indices.
+constexpr float LOD_MIN_REDUCTION = 0.2f;
+constexpr size_t LOD_MIN_INDEX_COUNT = 3 * 32;
+
+int mesh_command(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::cout << "Usage: LagomTools mesh <input.obj> <output.lmesh> [--lods <count>]" << std::endl;
+        return 1;
+    }
+    uint32_t max_lods = 4;
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "--lods") == 0 && i + 1 < argc) {
+            max_lods = (uint32_t)std::atoi(argv[++i]);
+        }
+        else {
+            std::cout << "Unknown option: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+    if (max_lods < 1 || max_lods > MESH_MAX_LODS) {
+        std::cout << "Level count must be 1 to " << MESH_MAX_LODS << std::endl;
+        return 1;
+    }
+
+    SourceMesh mesh;
+    if (!load_obj(argv[0], &mesh)) {
+        return 1;
+    }
+    uint32_t vertex_count = (uint32_t)mesh.vertices.size();
+    float acmr_before = compute_acmr(mesh.indices, vertex_count, MESH_REPORT_CACHE_SIZE);
+
+    // Each level halves the previous one and indexes the same vertices.
+    std::vector<float> positions(vertex_count * 3);
+    for (uint32_t vertex = 0; vertex < vertex_count; ++vertex) {
+        memcpy(&positions[vertex * 3], mesh.vertices[vertex].position, sizeof(float) * 3);
+    }
+    std::vector<std::vector<uint32_t>> lod_indices(1, mesh.indices);
+    std::vector<float> lod_errors(1, 0.0f);
+    while (lod_indices.size() < max_lods) {
+        const std::vector<uint32_t>& previous = lod_indices.back();
+        size_t target = previous.size() / 6 * 3;
+        if (target < LOD_MIN_INDEX_COUNT) {
+            break;
+        }
+        std::vector<uint32_t> simplified;
+        float error = simplify_mesh(previous, positions.data(), vertex_count, target, &simplified);
+        if (simplified.empty() || (float)simplified.size() > (float)previous.size() * (1.0f - LOD_MIN_REDUCTION)) {
+            break;
+        }
+        // Errors only grow down the chain so selection can stop at the first level that fails.
+        lod_errors.push_back(error > lod_errors.back() ? error : lod_errors.back());
+        lod_indices.push_back(simplified);
+    }
+
+    std::vector<MeshFileLod> lods(lod_indices.size());
+    std::vector<uint32_t> indices;
+    for (size_t lod = 0; lod < lod_indices.size(); ++lod) {
+        optimize_vertex_cache(lod_indices[lod], vertex_count);
+        lods[lod].first_index = (uint32_t)indices.size();
+        lods[lod].index_count = (uint32_t)lod_indices[lod].size();
+        lods[lod].error = lod_errors[lod];
+        indices.insert(indices.end(), lod_indices[lod].begin(), lod_indices[lod].end());
+    }
+    float acmr_after = compute_acmr(lod_indices[0], vertex_count, MESH_REPORT_CACHE_SIZE);
+
+    // Coarser levels only use vertices of the first, so fetch order follows it.
+    std::vector<uint32_t> remap;
+    uint32_t used_count = optimize_vertex_fetch(indices, vertex_count, &remap);
+    std::vector<SourceVertex> ordered(used_count);
+    for (uint32_t vertex = 0; vertex < vertex_count; ++vertex) {
+        if (remap[vertex] != UINT32_MAX) {
+            ordered[remap[vertex]] = mesh.vertices[vertex];
+        }
+    }
+
+    MeshFileHeader header{};
+    header.magic = MESH_FILE_MAGIC;
+    header.version = MESH_FILE_VERSION;
+    header.vertex_count = used_count;
+    header.index_count = (uint32_t)indices.size();
+    header.index_size = used_count <= 0xFFFF ? 2 : 4;
+    header.lod_count = (uint32_t)lods.size();
+
+    std::vector<MeshVertex> vertices;
+    quantize_vertices(ordered, &header, &vertices);
+    if (!write_mesh(argv[1], header, lods, vertices, indices)) {
+        return 1;
+    }
+
+    std::cout << "Baked " << used_count << " vertices, " << lods.size() << " levels" << std::endl;
+    std::cout << "  ACMR (FIFO " << MESH_REPORT_CACHE_SIZE << "): " << acmr_before << " -> " << acmr_after << std::endl;
+    for (size_t lod = 0; lod < lods.size(); ++lod) {
+        std::cout << "  LOD " << lod << ": " << lods[lod].index_count / 3 << " triangles, error " << lods[lod].error
+            << ", ACMR " << compute_acmr(lod_indices[lod], vertex_count, MESH_REPORT_CACHE_SIZE) << std::endl;
+    }
+    std::cout << "  Bytes per vertex: " << sizeof(SourceVertex) << " -> " << sizeof(MeshVertex)
+        << ", " << header.index_size << " byte indices" << std::endl;
+    return 0;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+// LagomTools mesh <input.obj> <output.lmesh> [--lods <count>]
+// Reads positions, UVs and normals from an OBJ file (polygons are fanned
+// into triangles, missing normals are generated), welds identical
+// vertices and builds up to count levels of detail (4 by default), each
+// simplified to half the triangles of the one before. Orders every
+// level's triangles for the vertex cache and the shared vertices for
+// fetch locality, then writes quantized MeshVertex data. Prints ACMR and
+// the error of each level, and the bytes per vertex against a float
+// layout.
+int mesh_command(int argc, char** argv);
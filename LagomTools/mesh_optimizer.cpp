@@ -0,0 +1,176 @@
+#include "mesh_optimizer.h"
+
+#include <cmath>
+
+constexpr int32_t CACHE_SIZE = 32;
+constexpr float CACHE_DECAY_POWER = 1.5f;
+constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+constexpr float VALENCE_BOOST_SCALE = 2.0f;
+constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+static float score_vertex(int32_t cache_position, uint32_t remaining_triangles)
+{
+    if (remaining_triangles == 0) {
+        return -1.0f;
+    }
+    float score = 0.0f;
+    if (cache_position >= 0) {
+        // The last triangle's vertices get a fixed score so they aren't picked right away again.
+        if (cache_position < 3) {
+            score = LAST_TRIANGLE_SCORE;
+        }
+        else {
+            float scaled = 1.0f - (float)(cache_position - 3) / (CACHE_SIZE - 3);
+            score = std::pow(scaled, CACHE_DECAY_POWER);
+        }
+    }
+    // Vertices with few triangles left are finished off first.
+    score += VALENCE_BOOST_SCALE * std::pow((float)remaining_triangles, -VALENCE_BOOST_POWER);
+    return score;
+}
+
+void optimize_vertex_cache(std::vector<uint32_t>& indices, uint32_t vertex_count)
+{
+    uint32_t triangle_count = (uint32_t)(indices.size() / 3);
+    if (triangle_count == 0) {
+        return;
+    }
+
+    // Triangle adjacency per vertex, packed.
+    std::vector<uint32_t> remaining(vertex_count, 0);
+    for (uint32_t index : indices) {
+        ++remaining[index];
+    }
+    std::vector<uint32_t> adjacency_offset(vertex_count + 1, 0);
+    for (uint32_t vertex = 0; vertex < vertex_count; ++vertex) {
+        adjacency_offset[vertex + 1] = adjacency_offset[vertex] + remaining[vertex];
+    }
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(adjacency_offset.begin(), adjacency_offset.end() - 1);
+    for (uint32_t triangle = 0; triangle < triangle_count; ++triangle) {
+        for (int corner = 0; corner < 3; ++corner) {
+            uint32_t vertex = indices[triangle * 3 + corner];
+            adjacency[fill[vertex]++] = triangle;
+        }
+    }
+
+    std::vector<int32_t> cache_position(vertex_count, -1);
+    std::vector<float> vertex_score(vertex_count);
+    for (uint32_t vertex = 0; vertex < vertex_count; ++vertex) {
+        vertex_score[vertex] = score_vertex(-1, remaining[vertex]);
+    }
+    std::vector<float> triangle_score(triangle_count);
+    std::vector<bool> emitted(triangle_count, false);
+    for (uint32_t triangle = 0; triangle < triangle_count; ++triangle) {
+        triangle_score[triangle] = vertex_score[indices[triangle * 3]] + vertex_score[indices[triangle * 3 + 1]] + vertex_score[indices[triangle * 3 + 2]];
+    }
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> next_cache;
+    cache.reserve(CACHE_SIZE + 3);
+    next_cache.reserve(CACHE_SIZE + 3);
+    uint32_t scan_cursor = 0;
+    int64_t best_triangle = -1;
+
+    for (uint32_t emitted_count = 0; emitted_count < triangle_count; ++emitted_count) {
+        if (best_triangle < 0) {
+            // Nothing in the cache has triangles left, take the best remaining one.
+            float best_score = -1.0f;
+            for (uint32_t triangle = scan_cursor; triangle < triangle_count; ++triangle) {
+                if (!emitted[triangle] && triangle_score[triangle] > best_score) {
+                    best_score = triangle_score[triangle];
+                    best_triangle = triangle;
+                }
+            }
+        }
+
+        uint32_t triangle = (uint32_t)best_triangle;
+        emitted[triangle] = true;
+        while (scan_cursor < triangle_count && emitted[scan_cursor]) {
+            ++scan_cursor;
+        }
+
+        // The triangle's vertices move to the front of the LRU cache.
+        next_cache.clear();
+        for (int corner = 0; corner < 3; ++corner) {
+            uint32_t vertex = indices[triangle * 3 + corner];
+            output.push_back(vertex);
+            next_cache.push_back(vertex);
+
+            uint32_t* begin = adjacency.data() + adjacency_offset[vertex];
+            uint32_t* end = begin + remaining[vertex];
+            for (uint32_t* it = begin; it != end; ++it) {
+                if (*it == triangle) {
+                    *it = *(end - 1);
+                    break;
+                }
+            }
+            --remaining[vertex];
+        }
+        for (uint32_t vertex : cache) {
+            if (vertex != next_cache[0] && vertex != next_cache[1] && vertex != next_cache[2]) {
+                next_cache.push_back(vertex);
+            }
+        }
+        cache.swap(next_cache);
+
+        // Rescore everything that was in the cache, including vertices that just fell out.
+        for (uint32_t position = 0; position < cache.size(); ++position) {
+            uint32_t vertex = cache[position];
+            cache_position[vertex] = position < (uint32_t)CACHE_SIZE ? (int32_t)position : -1;
+            vertex_score[vertex] = score_vertex(cache_position[vertex], remaining[vertex]);
+        }
+
+        best_triangle = -1;
+        float best_score = -1.0f;
+        for (uint32_t vertex : cache) {
+            uint32_t* begin = adjacency.data() + adjacency_offset[vertex];
+            for (uint32_t i = 0; i < remaining[vertex]; ++i) {
+                uint32_t candidate = begin[i];
+                float score = vertex_score[indices[candidate * 3]] + vertex_score[indices[candidate * 3 + 1]] + vertex_score[indices[candidate * 3 + 2]];
+                triangle_score[candidate] = score;
+                if (score > best_score) {
+                    best_score = score;
+                    best_triangle = candidate;
+                }
+            }
+        }
+        if (cache.size() > (size_t)CACHE_SIZE) {
+            cache.resize(CACHE_SIZE);
+        }
+    }
+
+    indices.swap(output);
+}
+
+uint32_t optimize_vertex_fetch(std::vector<uint32_t>& indices, uint32_t vertex_count, std::vector<uint32_t>* remap)
+{
+    remap->assign(vertex_count, UINT32_MAX);
+    uint32_t next = 0;
+    for (uint32_t& index : indices) {
+        if ((*remap)[index] == UINT32_MAX) {
+            (*remap)[index] = next++;
+        }
+        index = (*remap)[index];
+    }
+    return next;
+}
+
+float compute_acmr(const std::vector<uint32_t>& indices, uint32_t vertex_count, uint32_t cache_size)
+{
+    if (indices.size() < 3) {
+        return 0.0f;
+    }
+    // Time stamps make the FIFO check O(1): a vertex is cached if it entered less than cache_size misses ago.
+    std::vector<uint32_t> entered(vertex_count, 0);
+    uint32_t misses = 0;
+    for (uint32_t index : indices) {
+        if (entered[index] == 0 || misses + 1 - entered[index] > cache_size) {
+            ++misses;
+            entered[index] = misses;
+        }
+    }
+    return (float)misses / (float)(indices.size() / 3);
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+// Cache size the ACMR numbers are reported for, a conservative FIFO.
+constexpr uint32_t MESH_REPORT_CACHE_SIZE = 16;
+
+// Reorders triangles for the post-transform vertex cache with Forsyth's
+// linear-speed scoring (32 entry LRU model), which stays good across
+// cache sizes and replacement policies.
+void optimize_vertex_cache(std::vector<uint32_t>& indices, uint32_t vertex_count);
+
+// Numbers vertices in the order the indices first use them. Fills remap
+// with the new index of every old vertex and rewrites the indices,
+// returns the number of vertices still referenced.
+uint32_t optimize_vertex_fetch(std::vector<uint32_t>& indices, uint32_t vertex_count, std::vector<uint32_t>* remap);
+
+// Average vertex shader invocations per triangle with a FIFO cache.
+float compute_acmr(const std::vector<uint32_t>& indices, uint32_t vertex_count, uint32_t cache_size);
@@ -0,0 +1,267 @@
+#include "mesh_simplifier.h"
+
+#include <cmath>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+
+// Symmetric 4x4 plane quadric, weighted by triangle area. The error of a
+// point is p^T Q p over the total weight, the mean squared distance to the
+// planes.
+struct Quadric {
+    double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+    double a11 = 0, a12 = 0, a13 = 0;
+    double a22 = 0, a23 = 0;
+    double a33 = 0;
+    double weight = 0;
+
+    void add_plane(double x, double y, double z, double w, double area)
+    {
+        a00 += area * x * x; a01 += area * x * y; a02 += area * x * z; a03 += area * x * w;
+        a11 += area * y * y; a12 += area * y * z; a13 += area * y * w;
+        a22 += area * z * z; a23 += area * z * w;
+        a33 += area * w * w;
+        weight += area;
+    }
+
+    void add(const Quadric& other)
+    {
+        a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+        a11 += other.a11; a12 += other.a12; a13 += other.a13;
+        a22 += other.a22; a23 += other.a23;
+        a33 += other.a33;
+        weight += other.weight;
+    }
+
+    double evaluate(const float* p) const
+    {
+        double x = p[0], y = p[1], z = p[2];
+        double error = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x
+            + a11 * y * y + 2 * a12 * y * z + 2 * a13 * y
+            + a22 * z * z + 2 * a23 * z
+            + a33;
+        return error > 0.0 && weight > 0.0 ? error / weight : 0.0;
+    }
+};
+
+struct Collapse {
+    double cost;
+    uint32_t from;
+    uint32_t to;
+    uint32_t from_version;
+    uint32_t to_version;
+
+    bool operator<(const Collapse& other) const
+    {
+        // std::priority_queue is a max heap.
+        return cost > other.cost;
+    }
+};
+
+struct PositionKey {
+    float x, y, z;
+    bool operator==(const PositionKey& other) const
+    {
+        return x == other.x && y == other.y && z == other.z;
+    }
+};
+
+struct PositionHash {
+    size_t operator()(const PositionKey& key) const
+    {
+        uint32_t bits[3];
+        memcpy(bits, &key, sizeof(bits));
+        return (size_t)(bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u);
+    }
+};
+
+static void triangle_normal(const float* a, const float* b, const float* c, double normal[3])
+{
+    double ab[3] = { (double)b[0] - a[0], (double)b[1] - a[1], (double)b[2] - a[2] };
+    double ac[3] = { (double)c[0] - a[0], (double)c[1] - a[1], (double)c[2] - a[2] };
+    normal[0] = ab[1] * ac[2] - ab[2] * ac[1];
+    normal[1] = ab[2] * ac[0] - ab[0] * ac[2];
+    normal[2] = ab[0] * ac[1] - ab[1] * ac[0];
+}
+
+float simplify_mesh(const std::vector<uint32_t>& indices, const float* positions, uint32_t vertex_count,
+    size_t target_index_count, std::vector<uint32_t>* output)
+{
+    std::vector<uint32_t> triangles = indices;
+    uint32_t triangle_count = (uint32_t)(triangles.size() / 3);
+    size_t live_index_count = triangles.size();
+
+    // Vertices sharing a position with different attributes sit on a seam.
+    std::vector<bool> locked(vertex_count, false);
+    std::vector<uint32_t> position_of(vertex_count);
+    {
+        std::unordered_map<PositionKey, uint32_t, PositionHash> first_of;
+        for (uint32_t vertex = 0; vertex < vertex_count; ++vertex) {
+            PositionKey key = { positions[vertex * 3], positions[vertex * 3 + 1], positions[vertex * 3 + 2] };
+            auto found = first_of.emplace(key, vertex);
+            position_of[vertex] = found.first->second;
+        }
+        std::vector<uint32_t> twins(vertex_count, 0);
+        for (uint32_t vertex = 0; vertex < vertex_count; ++vertex) {
+            ++twins[position_of[vertex]];
+        }
+        for (uint32_t vertex = 0; vertex < vertex_count; ++vertex) {
+            locked[vertex] = twins[position_of[vertex]] > 1;
+        }
+    }
+
+    // Edges used by a single triangle are on an open border.
+    {
+        std::unordered_map<uint64_t, int> edge_uses;
+        for (uint32_t triangle = 0; triangle < triangle_count; ++triangle) {
+            for (int corner = 0; corner < 3; ++corner) {
+                uint64_t a = position_of[triangles[triangle * 3 + corner]];
+                uint64_t b = position_of[triangles[triangle * 3 + (corner + 1) % 3]];
+                uint64_t key = a < b ? (a << 32) | b : (b << 32) | a;
+                ++edge_uses[key];
+            }
+        }
+        for (uint32_t triangle = 0; triangle < triangle_count; ++triangle) {
+            for (int corner = 0; corner < 3; ++corner) {
+                uint32_t a = triangles[triangle * 3 + corner];
+                uint32_t b = triangles[triangle * 3 + (corner + 1) % 3];
+                uint64_t pa = position_of[a];
+                uint64_t pb = position_of[b];
+                if (edge_uses[pa < pb ? (pa << 32) | pb : (pb << 32) | pa] == 1) {
+                    locked[a] = true;
+                    locked[b] = true;
+                }
+            }
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertex_count);
+    std::vector<std::vector<uint32_t>> adjacent(vertex_count);
+    for (uint32_t triangle = 0; triangle < triangle_count; ++triangle) {
+        const uint32_t* corners = &triangles[triangle * 3];
+        double normal[3];
+        triangle_normal(&positions[corners[0] * 3], &positions[corners[1] * 3], &positions[corners[2] * 3], normal);
+        double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (length > 0.0) {
+            normal[0] /= length;
+            normal[1] /= length;
+            normal[2] /= length;
+            const float* p = &positions[corners[0] * 3];
+            double w = -(normal[0] * p[0] + normal[1] * p[1] + normal[2] * p[2]);
+            for (int corner = 0; corner < 3; ++corner) {
+                quadrics[corners[corner]].add_plane(normal[0], normal[1], normal[2], w, length * 0.5);
+            }
+        }
+        for (int corner = 0; corner < 3; ++corner) {
+            adjacent[corners[corner]].push_back(triangle);
+        }
+    }
+
+    std::vector<bool> removed(triangle_count, false);
+    std::vector<uint32_t> version(vertex_count, 0);
+    std::priority_queue<Collapse> queue;
+    auto push_collapse = [&](uint32_t from, uint32_t to) {
+        if (locked[from] || from == to) {
+            return;
+        }
+        Quadric combined = quadrics[from];
+        combined.add(quadrics[to]);
+        Collapse collapse;
+        collapse.cost = combined.evaluate(&positions[to * 3]);
+        collapse.from = from;
+        collapse.to = to;
+        collapse.from_version = version[from];
+        collapse.to_version = version[to];
+        queue.push(collapse);
+    };
+    for (uint32_t triangle = 0; triangle < triangle_count; ++triangle) {
+        for (int corner = 0; corner < 3; ++corner) {
+            push_collapse(triangles[triangle * 3 + corner], triangles[triangle * 3 + (corner + 1) % 3]);
+            push_collapse(triangles[triangle * 3 + (corner + 1) % 3], triangles[triangle * 3 + corner]);
+        }
+    }
+
+    double max_cost = 0.0;
+    while (live_index_count > target_index_count && !queue.empty()) {
+        Collapse collapse = queue.top();
+        queue.pop();
+        uint32_t from = collapse.from;
+        uint32_t to = collapse.to;
+        if (collapse.from_version != version[from] || collapse.to_version != version[to]) {
+            continue;
+        }
+
+        // Reject collapses that fold a triangle over.
+        bool flips = false;
+        for (uint32_t triangle : adjacent[from]) {
+            if (removed[triangle]) {
+                continue;
+            }
+            const uint32_t* corners = &triangles[triangle * 3];
+            if (corners[0] == to || corners[1] == to || corners[2] == to) {
+                continue;
+            }
+            const float* moved[3];
+            for (int corner = 0; corner < 3; ++corner) {
+                moved[corner] = &positions[(corners[corner] == from ? to : corners[corner]) * 3];
+            }
+            double before[3];
+            double after[3];
+            triangle_normal(&positions[corners[0] * 3], &positions[corners[1] * 3], &positions[corners[2] * 3], before);
+            triangle_normal(moved[0], moved[1], moved[2], after);
+            if (before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0.0) {
+                flips = true;
+                break;
+            }
+        }
+        if (flips) {
+            continue;
+        }
+
+        for (uint32_t triangle : adjacent[from]) {
+            if (removed[triangle]) {
+                continue;
+            }
+            uint32_t* corners = &triangles[triangle * 3];
+            if (corners[0] == to || corners[1] == to || corners[2] == to) {
+                removed[triangle] = true;
+                live_index_count -= 3;
+                continue;
+            }
+            for (int corner = 0; corner < 3; ++corner) {
+                if (corners[corner] == from) {
+                    corners[corner] = to;
+                }
+            }
+            adjacent[to].push_back(triangle);
+        }
+        adjacent[from].clear();
+        quadrics[to].add(quadrics[from]);
+        max_cost = collapse.cost > max_cost ? collapse.cost : max_cost;
+        ++version[from];
+        ++version[to];
+
+        // Costs around the merged vertex changed.
+        for (uint32_t triangle : adjacent[to]) {
+            if (removed[triangle]) {
+                continue;
+            }
+            for (int corner = 0; corner < 3; ++corner) {
+                uint32_t other = triangles[triangle * 3 + corner];
+                if (other != to) {
+                    push_collapse(other, to);
+                    push_collapse(to, other);
+                }
+            }
+        }
+    }
+
+    output->clear();
+    output->reserve(live_index_count);
+    for (uint32_t triangle = 0; triangle < triangle_count; ++triangle) {
+        if (!removed[triangle]) {
+            output->insert(output->end(), &triangles[triangle * 3], &triangles[triangle * 3] + 3);
+        }
+    }
+    return (float)std::sqrt(max_cost);
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Edge collapse simplification in quadric error order (Garland and
+// Heckbert). Vertices only ever collapse onto other existing vertices, so
+// every level can index the same vertex buffer. UV and normal seams and
+// open borders are locked so the silhouette and texture mapping hold.
+// positions holds xyz per vertex. Stops at target_index_count or when no
+// collapse is left, and returns the largest error introduced as an object
+// space distance.
+float simplify_mesh(const std::vector<uint32_t>& indices, const float* positions, uint32_t vertex_count,
+    size_t target_index_count, std::vector<uint32_t>* output);
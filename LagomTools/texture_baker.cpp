@@ -0,0 +1,392 @@
+#include "texture_baker.h"
+#include "mapped_file.h"
+#include "texture_compress.h"
+#include "texture_file.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct Image {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> rgba;
+};
+
+// KTX2 data format descriptor color models and channel ids.
+constexpr uint32_t KDF_MODEL_RGBSDA = 1;
+constexpr uint32_t KDF_MODEL_BC1A = 128;
+constexpr uint32_t KDF_MODEL_BC3 = 130;
+constexpr uint32_t KDF_MODEL_BC4 = 131;
+constexpr uint32_t KDF_MODEL_BC5 = 132;
+constexpr uint32_t KDF_PRIMARIES_BT709 = 1;
+constexpr uint32_t KDF_TRANSFER_LINEAR = 1;
+constexpr uint32_t KDF_TRANSFER_SRGB = 2;
+constexpr uint32_t KDF_CHANNEL_RED = 0;
+constexpr uint32_t KDF_CHANNEL_GREEN = 1;
+constexpr uint32_t KDF_CHANNEL_BLUE = 2;
+constexpr uint32_t KDF_CHANNEL_ALPHA = 15;
+constexpr uint32_t KDF_SAMPLE_LINEAR = 0x10;
+
+static void write_u32(std::vector<uint8_t>& bytes, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i) {
+        bytes.push_back((uint8_t)(value >> (i * 8)));
+    }
+}
+
+static void write_u64(std::vector<uint8_t>& bytes, uint64_t value)
+{
+    write_u32(bytes, (uint32_t)value);
+    write_u32(bytes, (uint32_t)(value >> 32));
+}
+
+static void patch_u64(std::vector<uint8_t>& bytes, size_t offset, uint64_t value)
+{
+    for (int i = 0; i < 8; ++i) {
+        bytes[offset + i] = (uint8_t)(value >> (i * 8));
+    }
+}
+
+static bool load_tga(const std::string& path, Image* image)
+{
+    MappedFile file;
+    if (!file.open(path) || file.get_size() < 18) {
+        std::cout << "Unable to open: " << path << std::endl;
+        return false;
+    }
+    const uint8_t* data = file.get_data();
+    size_t size = file.get_size();
+
+    uint8_t id_length = data[0];
+    uint8_t color_map_type = data[1];
+    uint8_t image_type = data[2];
+    image->width = (uint32_t)(data[12] | (data[13] << 8));
+    image->height = (uint32_t)(data[14] | (data[15] << 8));
+    uint32_t bits = data[16];
+    bool top_down = (data[17] & 0x20) != 0;
+
+    bool rle = image_type == 10 || image_type == 11;
+    bool gray = image_type == 3 || image_type == 11;
+    uint32_t pixel_bytes = bits / 8;
+    if (color_map_type != 0 || (image_type != 2 && image_type != 3 && image_type != 10 && image_type != 11) ||
+        image->width == 0 || image->height == 0 ||
+        (gray && bits != 8) || (!gray && bits != 24 && bits != 32)) {
+        std::cout << "Unsupported TGA, expected 8 bit gray or 24/32 bit truecolor: " << path << std::endl;
+        return false;
+    }
+
+    size_t pixel_count = (size_t)image->width * image->height;
+    std::vector<uint8_t> pixels(pixel_count * pixel_bytes);
+    size_t offset = 18 + id_length;
+    if (rle) {
+        size_t written = 0;
+        while (written < pixels.size()) {
+            if (offset >= size) {
+                std::cout << "Truncated TGA: " << path << std::endl;
+                return false;
+            }
+            uint8_t packet = data[offset++];
+            size_t count = (size_t)(packet & 0x7F) + 1;
+            size_t bytes = count * pixel_bytes;
+            if (written + bytes > pixels.size()) {
+                bytes = pixels.size() - written;
+            }
+            if (packet & 0x80) {
+                if (offset + pixel_bytes > size) {
+                    std::cout << "Truncated TGA: " << path << std::endl;
+                    return false;
+                }
+                for (size_t i = 0; i < bytes; i += pixel_bytes) {
+                    memcpy(pixels.data() + written + i, data + offset, pixel_bytes);
+                }
+                offset += pixel_bytes;
+            }
+            else {
+                if (offset + bytes > size) {
+                    std::cout << "Truncated TGA: " << path << std::endl;
+                    return false;
+                }
+                memcpy(pixels.data() + written, data + offset, bytes);
+                offset += bytes;
+            }
+            written += bytes;
+        }
+    }
+    else {
+        if (offset + pixels.size() > size) {
+            std::cout << "Truncated TGA: " << path << std::endl;
+            return false;
+        }
+        memcpy(pixels.data(), data + offset, pixels.size());
+    }
+
+    // TGA stores BGR(A) bottom-up unless the descriptor says otherwise.
+    image->rgba.resize(pixel_count * 4);
+    for (uint32_t y = 0; y < image->height; ++y) {
+        uint32_t source_y = top_down ? y : image->height - 1 - y;
+        for (uint32_t x = 0; x < image->width; ++x) {
+            const uint8_t* source = pixels.data() + ((size_t)source_y * image->width + x) * pixel_bytes;
+            uint8_t* destination = image->rgba.data() + ((size_t)y * image->width + x) * 4;
+            if (gray) {
+                destination[0] = source[0];
+                destination[1] = source[0];
+                destination[2] = source[0];
+                destination[3] = 255;
+            }
+            else {
+                destination[0] = source[2];
+                destination[1] = source[1];
+                destination[2] = source[0];
+                destination[3] = pixel_bytes == 4 ? source[3] : 255;
+            }
+        }
+    }
+    return true;
+}
+
+static float srgb_to_linear(float value)
+{
+    return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+static float linear_to_srgb(float value)
+{
+    return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+// 2x2 box filter, odd sizes fold the last row or column into the one before.
+static Image downsample(const Image& source, bool srgb)
+{
+    float to_linear[256];
+    for (int i = 0; i < 256; ++i) {
+        to_linear[i] = srgb ? srgb_to_linear(i / 255.0f) : i / 255.0f;
+    }
+
+    Image result;
+    result.width = source.width > 1 ? source.width / 2 : 1;
+    result.height = source.height > 1 ? source.height / 2 : 1;
+    result.rgba.resize((size_t)result.width * result.height * 4);
+    uint32_t step_x = source.width > 1 ? 2 : 1;
+    uint32_t step_y = source.height > 1 ? 2 : 1;
+
+    for (uint32_t y = 0; y < result.height; ++y) {
+        uint32_t end_y = y == result.height - 1 ? source.height : (y + 1) * step_y;
+        for (uint32_t x = 0; x < result.width; ++x) {
+            uint32_t end_x = x == result.width - 1 ? source.width : (x + 1) * step_x;
+            float sum[4] = {};
+            uint32_t count = 0;
+            for (uint32_t source_y = y * step_y; source_y < end_y; ++source_y) {
+                for (uint32_t source_x = x * step_x; source_x < end_x; ++source_x) {
+                    const uint8_t* texel = source.rgba.data() + ((size_t)source_y * source.width + source_x) * 4;
+                    sum[0] += to_linear[texel[0]];
+                    sum[1] += to_linear[texel[1]];
+                    sum[2] += to_linear[texel[2]];
+                    // Alpha is always linear.
+                    sum[3] += texel[3] / 255.0f;
+                    ++count;
+                }
+            }
+            uint8_t* destination = result.rgba.data() + ((size_t)y * result.width + x) * 4;
+            for (int c = 0; c < 4; ++c) {
+                float value = sum[c] / count;
+                if (srgb && c < 3) {
+                    value = linear_to_srgb(value);
+                }
+                destination[c] = (uint8_t)(value * 255.0f + 0.5f);
+            }
+        }
+    }
+    return result;
+}
+
+static void write_sample(std::vector<uint8_t>& dfd, uint32_t bit_offset, uint32_t bit_length, uint32_t channel, uint32_t upper)
+{
+    write_u32(dfd, bit_offset | ((bit_length - 1) << 16) | (channel << 24));
+    write_u32(dfd, 0);
+    write_u32(dfd, 0);
+    write_u32(dfd, upper);
+}
+
+// Basic data format descriptor, the runtime reads vkFormat but other KTX2 tools need this.
+static std::vector<uint8_t> build_dfd(uint32_t vk_format)
+{
+    bool srgb = is_texture_format_srgb(vk_format);
+    bool compressed = is_texture_format_compressed(vk_format);
+    uint32_t model = KDF_MODEL_RGBSDA;
+    uint32_t sample_count = 4;
+    uint32_t block_bytes = 4;
+    switch (vk_format) {
+    case TEXTURE_FORMAT_BC1_RGB_UNORM:
+    case TEXTURE_FORMAT_BC1_RGB_SRGB:
+        model = KDF_MODEL_BC1A;
+        sample_count = 1;
+        block_bytes = 8;
+        break;
+    case TEXTURE_FORMAT_BC3_UNORM:
+    case TEXTURE_FORMAT_BC3_SRGB:
+        model = KDF_MODEL_BC3;
+        sample_count = 2;
+        block_bytes = 16;
+        break;
+    case TEXTURE_FORMAT_BC4_UNORM:
+        model = KDF_MODEL_BC4;
+        sample_count = 1;
+        block_bytes = 8;
+        break;
+    case TEXTURE_FORMAT_BC5_UNORM:
+        model = KDF_MODEL_BC5;
+        sample_count = 2;
+        block_bytes = 16;
+        break;
+    }
+
+    uint32_t block_size = 24 + 16 * sample_count;
+    std::vector<uint8_t> dfd;
+    write_u32(dfd, 4 + block_size);
+    write_u32(dfd, 0);
+    write_u32(dfd, 2 | (block_size << 16));
+    write_u32(dfd, model | (KDF_PRIMARIES_BT709 << 8) | ((srgb ? KDF_TRANSFER_SRGB : KDF_TRANSFER_LINEAR) << 16));
+    write_u32(dfd, compressed ? 0x00000303 : 0);
+    write_u32(dfd, block_bytes);
+    write_u32(dfd, 0);
+
+    uint32_t alpha_channel = KDF_CHANNEL_ALPHA | (srgb ? KDF_SAMPLE_LINEAR : 0);
+    switch (model) {
+    case KDF_MODEL_RGBSDA:
+        write_sample(dfd, 0, 8, KDF_CHANNEL_RED, 255);
+        write_sample(dfd, 8, 8, KDF_CHANNEL_GREEN, 255);
+        write_sample(dfd, 16, 8, KDF_CHANNEL_BLUE, 255);
+        write_sample(dfd, 24, 8, alpha_channel, 255);
+        break;
+    case KDF_MODEL_BC3:
+        write_sample(dfd, 0, 64, alpha_channel, 0xFFFFFFFF);
+        write_sample(dfd, 64, 64, KDF_CHANNEL_RED, 0xFFFFFFFF);
+        break;
+    case KDF_MODEL_BC5:
+        write_sample(dfd, 0, 64, KDF_CHANNEL_RED, 0xFFFFFFFF);
+        write_sample(dfd, 64, 64, KDF_CHANNEL_GREEN, 0xFFFFFFFF);
+        break;
+    default:
+        write_sample(dfd, 0, 64, KDF_CHANNEL_RED, 0xFFFFFFFF);
+        break;
+    }
+    return dfd;
+}
+
+static bool parse_format(const std::string& name, bool srgb, uint32_t* vk_format)
+{
+    if (name == "rgba8") {
+        *vk_format = srgb ? TEXTURE_FORMAT_R8G8B8A8_SRGB : TEXTURE_FORMAT_R8G8B8A8_UNORM;
+    }
+    else if (name == "bc1") {
+        *vk_format = srgb ? TEXTURE_FORMAT_BC1_RGB_SRGB : TEXTURE_FORMAT_BC1_RGB_UNORM;
+    }
+    else if (name == "bc3") {
+        *vk_format = srgb ? TEXTURE_FORMAT_BC3_SRGB : TEXTURE_FORMAT_BC3_UNORM;
+    }
+    else if (name == "bc4" && !srgb) {
+        *vk_format = TEXTURE_FORMAT_BC4_UNORM;
+    }
+    else if (name == "bc5" && !srgb) {
+        *vk_format = TEXTURE_FORMAT_BC5_UNORM;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+int bake_command(int argc, char** argv)
+{
+    if (argc < 3) {
+        std::cout << "Usage: LagomTools bake <input.tga> <output.ktx2> <rgba8|bc1|bc3|bc4|bc5> [--srgb] [--no-mips]" << std::endl;
+        return 1;
+    }
+    bool srgb = false;
+    bool mips = true;
+    for (int i = 3; i < argc; ++i) {
+        std::string option = argv[i];
+        if (option == "--srgb") {
+            srgb = true;
+        }
+        else if (option == "--no-mips") {
+            mips = false;
+        }
+        else {
+            std::cout << "Unknown option: " << option << std::endl;
+            return 1;
+        }
+    }
+    uint32_t vk_format = 0;
+    if (!parse_format(argv[2], srgb, &vk_format)) {
+        std::cout << "Unknown format: " << argv[2] << (srgb ? " (bc4 and bc5 have no sRGB variant)" : "") << std::endl;
+        return 1;
+    }
+
+    std::vector<Image> levels(1);
+    if (!load_tga(argv[0], &levels[0])) {
+        return 1;
+    }
+    while (mips && levels.size() < TEXTURE_MAX_LEVELS && (levels.back().width > 1 || levels.back().height > 1)) {
+        levels.push_back(downsample(levels.back(), srgb));
+    }
+
+    std::vector<std::vector<uint8_t>> level_data(levels.size());
+    size_t source_bytes = 0;
+    for (size_t level = 0; level < levels.size(); ++level) {
+        compress_texture_level(vk_format, levels[level].rgba.data(), levels[level].width, levels[level].height, &level_data[level]);
+        source_bytes += levels[level].rgba.size();
+    }
+
+    std::vector<uint8_t> bytes = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+    write_u32(bytes, vk_format);
+    write_u32(bytes, 1);
+    write_u32(bytes, levels[0].width);
+    write_u32(bytes, levels[0].height);
+    write_u32(bytes, 0);
+    write_u32(bytes, 0);
+    write_u32(bytes, 1);
+    write_u32(bytes, (uint32_t)levels.size());
+    write_u32(bytes, 0);
+
+    std::vector<uint8_t> dfd = build_dfd(vk_format);
+    size_t level_index_offset = bytes.size() + 32;
+    uint32_t dfd_offset = (uint32_t)(level_index_offset + levels.size() * 24);
+    write_u32(bytes, dfd_offset);
+    write_u32(bytes, (uint32_t)dfd.size());
+    write_u32(bytes, 0);
+    write_u32(bytes, 0);
+    write_u64(bytes, 0);
+    write_u64(bytes, 0);
+    for (size_t level = 0; level < levels.size(); ++level) {
+        write_u64(bytes, 0);
+        write_u64(bytes, level_data[level].size());
+        write_u64(bytes, level_data[level].size());
+    }
+    bytes.insert(bytes.end(), dfd.begin(), dfd.end());
+
+    // Smallest level first as the spec asks, each aligned to the block size.
+    size_t alignment = is_texture_format_compressed(vk_format) ? 16 : 4;
+    size_t compressed_bytes = 0;
+    for (size_t level = levels.size(); level-- > 0;) {
+        bytes.resize((bytes.size() + alignment - 1) / alignment * alignment);
+        patch_u64(bytes, level_index_offset + level * 24, bytes.size());
+        bytes.insert(bytes.end(), level_data[level].begin(), level_data[level].end());
+        compressed_bytes += level_data[level].size();
+    }
+
+    std::ofstream output(argv[1], std::ios::binary);
+    if (!output.is_open()) {
+        std::cout << "Unable to create: " << argv[1] << std::endl;
+        return 1;
+    }
+    output.write((const char*)bytes.data(), (std::streamsize)bytes.size());
+
+    std::cout << "Baked " << levels[0].width << "x" << levels[0].height << ", " << levels.size() << " levels, "
+        << compressed_bytes << " bytes of texel data from " << source_bytes << " RGBA8 bytes" << std::endl;
+    return 0;
+}
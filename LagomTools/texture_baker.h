@@ -0,0 +1,7 @@
+#pragma once
+
+// LagomTools bake <input.tga> <output.ktx2> <rgba8|bc1|bc3|bc4|bc5> [--srgb] [--no-mips]
+// Reads an uncompressed or RLE truecolor/grayscale TGA, builds the mip
+// chain with a box filter (in linear space for --srgb) and writes a KTX2
+// file with every level in the chosen format.
+int bake_command(int argc, char** argv);
@@ -1,4 +1,10 @@
 #pragma once
 
 #define BUILD_ENABLE_VULKAN_DEBUG 1
-#define BUILD_ENABLE_VULKAN_RUNTIME_DEBUG 1
\ No newline at end of file
+#define BUILD_ENABLE_VULKAN_RUNTIME_DEBUG 1
+
+// Keep the depth buffer after the main pass so a hierarchical-Z pyramid can be built from it.
+#define BUILD_ENABLE_HIZ_OCCLUSION_CULLING 0
+
+// Render the scene into an offscreen target scaled from GPU frame time, then upscale into the swapchain.
+#define BUILD_ENABLE_DYNAMIC_RESOLUTION 0
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "asset_pack.h"
+
+#include <iostream>
+
+uint64_t hash_asset_name(const std::string& name)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : name) {
+        if (c == '\\') {
+            c = '/';
+        }
+        else if (c >= 'A' && c <= 'Z') {
+            c = c - 'A' + 'a';
+        }
+        hash ^= (uint8_t)c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+AssetPack::AssetPack()
+{
+}
+
+AssetPack::~AssetPack()
+{
+    close();
+}
+
+bool AssetPack::open(const std::string& filename)
+{
+    close();
+    if (!_file.open(filename)) {
+        std::cout << "Unable to open asset pack: " << filename << std::endl;
+        return false;
+    }
+
+    const uint8_t* data = _file.get_data();
+    size_t size = _file.get_size();
+    const AssetPackHeader* header = (const AssetPackHeader*)data;
+    if (size < sizeof(AssetPackHeader) || header->magic != ASSET_PACK_MAGIC || header->version != ASSET_PACK_VERSION) {
+        std::cout << "Invalid asset pack: " << filename << std::endl;
+        _file.close();
+        return false;
+    }
+
+    uint64_t toc_size = (uint64_t)header->entry_count * sizeof(AssetPackEntry);
+    // Offsets are checked against size before subtracting, so crafted values can't wrap around.
+    if (header->toc_offset % alignof(AssetPackEntry) != 0 || header->toc_offset > size ||
+        toc_size > size - header->toc_offset || header->names_offset > size) {
+        std::cout << "Corrupt asset pack table of contents: " << filename << std::endl;
+        _file.close();
+        return false;
+    }
+
+    const AssetPackEntry* entries = (const AssetPackEntry*)(data + header->toc_offset);
+    for (uint32_t i = 0; i < header->entry_count; ++i) {
+        if (entries[i].offset > size || entries[i].size > size - entries[i].offset) {
+            std::cout << "Corrupt asset pack entry in: " << filename << std::endl;
+            _file.close();
+            return false;
+        }
+    }
+
+    _header = header;
+    _entries = entries;
+    _names = (const char*)(data + header->names_offset);
+    _names_size = size - (size_t)header->names_offset;
+    return true;
+}
+
+void AssetPack::close()
+{
+    _file.close();
+    _header = nullptr;
+    _entries = nullptr;
+    _names = nullptr;
+    _names_size = 0;
+}
+
+AssetView AssetPack::find(const std::string& name) const
+{
+    return find(hash_asset_name(name));
+}
+
+AssetView AssetPack::find(uint64_t name_hash) const
+{
+    AssetView view;
+    if (_header == nullptr) {
+        return view;
+    }
+
+    uint32_t low = 0;
+    uint32_t high = _header->entry_count;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        if (_entries[middle].name_hash < name_hash) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+    if (low == _header->entry_count || _entries[low].name_hash != name_hash) {
+        return view;
+    }
+
+    const AssetPackEntry& entry = _entries[low];
+    view.data = _file.get_data() + entry.offset;
+    view.size = (size_t)entry.size;
+    view.type = (AssetType)entry.type;
+    return view;
+}
+
+uint32_t AssetPack::get_entry_count() const
+{
+    return _header != nullptr ? _header->entry_count : 0;
+}
+
+const AssetPackEntry& AssetPack::get_entry(uint32_t index) const
+{
+    return _entries[index];
+}
+
+const char* AssetPack::get_entry_name(uint32_t index) const
+{
+    uint32_t name_offset = _entries[index].name_offset;
+    return name_offset < _names_size ? _names + name_offset : "";
+}
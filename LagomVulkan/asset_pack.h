@@ -0,0 +1,96 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include "mapped_file.h"
+
+// On-disk layout, little-endian, written by the LagomTools packer:
+//   AssetPackHeader
+//   blobs, each starting on a multiple of header.alignment
+//   AssetPackEntry[entry_count], sorted by name_hash
+//   names, zero terminated, for tools and error messages
+constexpr uint32_t ASSET_PACK_MAGIC = 0x4B41504C; // "LPAK"
+constexpr uint32_t ASSET_PACK_VERSION = 1;
+constexpr uint32_t ASSET_PACK_ALIGNMENT = 256;
+
+enum AssetType : uint32_t {
+    ASSET_TYPE_RAW = 0,
+    // SPIR-V words, ready for vkCreateShaderModule.
+    ASSET_TYPE_SPIRV = 1,
+    // AssetSoundHeader followed by canonical 16-bit PCM.
+    ASSET_TYPE_SOUND = 2,
+    // Pre-baked GPU data, uploaded as is.
+    ASSET_TYPE_TEXTURE = 3,
+    ASSET_TYPE_MESH = 4,
+};
+
+struct AssetPackHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t alignment;
+    uint64_t toc_offset;
+    uint64_t names_offset;
+};
+static_assert(sizeof(AssetPackHeader) == 32, "AssetPackHeader layout is part of the file format");
+
+struct AssetPackEntry {
+    uint64_t name_hash;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t type;
+    uint32_t name_offset;
+};
+static_assert(sizeof(AssetPackEntry) == 32, "AssetPackEntry layout is part of the file format");
+
+struct AssetSoundHeader {
+    uint32_t channels;
+    uint32_t frame_count;
+    uint32_t sample_rate;
+    uint32_t reserved;
+};
+static_assert(sizeof(AssetSoundHeader) == 16, "AssetSoundHeader layout is part of the file format");
+
+// Points straight into the mapped pack.
+struct AssetView {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    AssetType type = ASSET_TYPE_RAW;
+
+    bool is_valid() const { return data != nullptr; }
+};
+
+// FNV-1a over the name with '\' as '/' and ASCII lowercased, so lookups
+// don't depend on how a path was spelled.
+uint64_t hash_asset_name(const std::string& name);
+
+// A pack file mapped once; every lookup is a binary search over the table
+// of contents and returns a view into the mapping, nothing is copied.
+// Nothing opens a pack at startup yet, so shaders, sounds and textures
+// load from loose files until the app opens one and hands it to
+// set_asset_pack() and the pack overload of load_shader_module().
+class AssetPack {
+public:
+    AssetPack();
+    ~AssetPack();
+
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+
+    bool open(const std::string& filename);
+    void close();
+
+    AssetView find(const std::string& name) const;
+    AssetView find(uint64_t name_hash) const;
+
+    uint32_t get_entry_count() const;
+    const AssetPackEntry& get_entry(uint32_t index) const;
+    const char* get_entry_name(uint32_t index) const;
+
+private:
+    MappedFile _file;
+    const AssetPackHeader* _header = nullptr;
+    const AssetPackEntry* _entries = nullptr;
+    const char* _names = nullptr;
+    size_t _names_size = 0;
+};
@@ -1,14 +1,51 @@
 #pragma once
+#include <stdint.h>
+#include <string>
+
+// Refers to one playing sound, goes stale when the sound ends or its voice is reused.
+struct SoundHandle {
+    uint32_t id = 0;
+
+    bool is_valid() const { return id != 0; }
+};
+
 class Audio {
 public:
     virtual ~Audio() {}
-    virtual void play_sound(int soundId) = 0;
-    virtual void stop_sound(int soundId) = 0;
+    // Returns the id for play_sound, the sound may finish loading later.
+    virtual int load_sound(const std::string& filename) = 0;
+    virtual void unload_sound(int soundId) = 0;
+    // Higher priority sounds take voices from lower ones when all are busy.
+    virtual SoundHandle play_sound(int soundId, float gain, int priority) = 0;
+    virtual void stop_sound(SoundHandle sound) = 0;
+    virtual bool is_sound_playing(SoundHandle sound) = 0;
+    virtual void set_sound_gain(SoundHandle sound, float gain) = 0;
+    // 3D sound attenuated by distance to the listener, silent past max_distance.
+    virtual int create_emitter(int soundId, float gain, float max_distance, int priority, bool loop) = 0;
+    virtual void destroy_emitter(int emitterId) = 0;
+    virtual void set_emitter_position(int emitterId, float x, float y, float z) = 0;
+    virtual void set_listener(const float position[3], const float forward[3], const float up[3]) = 0;
+    // Plays a file without loading it fully, returns -1 when no stream is free.
+    virtual int play_stream(const std::string& filename, bool loop) = 0;
+    virtual void stop_stream(int streamId) = 0;
+    // Once per frame.
+    virtual void update() = 0;
 };
 
 class NullAudio : public Audio
 {
 public:
-    virtual void play_sound(int soundID) { /* Do nothing. */ }
-    virtual void stop_sound(int soundID) { /* Do nothing. */ }
+    virtual int load_sound(const std::string& filename) { return -1; }
+    virtual void unload_sound(int soundID) { /* Do nothing. */ }
+    virtual SoundHandle play_sound(int soundID, float gain, int priority) { return SoundHandle(); }
+    virtual void stop_sound(SoundHandle sound) { /* Do nothing. */ }
+    virtual bool is_sound_playing(SoundHandle sound) { return false; }
+    virtual void set_sound_gain(SoundHandle sound, float gain) { /* Do nothing. */ }
+    virtual int create_emitter(int soundID, float gain, float max_distance, int priority, bool loop) { return -1; }
+    virtual void destroy_emitter(int emitterID) { /* Do nothing. */ }
+    virtual void set_emitter_position(int emitterID, float x, float y, float z) { /* Do nothing. */ }
+    virtual void set_listener(const float position[3], const float forward[3], const float up[3]) { /* Do nothing. */ }
+    virtual int play_stream(const std::string& filename, bool loop) { return -1; }
+    virtual void stop_stream(int streamID) { /* Do nothing. */ }
+    virtual void update() { /* Do nothing. */ }
 };
@@ -0,0 +1,297 @@
+#include "audio_import.h"
+#include "mix_kernels.h"
+
+#include <string.h>
+#include <vector>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define AUDIO_IMPORT_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// Decodes sample_count interleaved samples to float in [-1, 1).
+static void decode_u8(float* output, const uint8_t* input, uint32_t sample_count)
+{
+    uint32_t i = 0;
+#if AUDIO_IMPORT_SSE2
+    __m128i zero = _mm_setzero_si128();
+    __m128i bias = _mm_set1_epi16(128);
+    __m128 scale = _mm_set1_ps(1.0f / 128.0f);
+    for (; i + 16 <= sample_count; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(input + i));
+        __m128i low = _mm_sub_epi16(_mm_unpacklo_epi8(bytes, zero), bias);
+        __m128i high = _mm_sub_epi16(_mm_unpackhi_epi8(bytes, zero), bias);
+        // Sign extend 16 to 32 bits by placing the value in the top half and shifting back down.
+        _mm_storeu_ps(output + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(low, low), 16)), scale));
+        _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(low, low), 16)), scale));
+        _mm_storeu_ps(output + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(high, high), 16)), scale));
+        _mm_storeu_ps(output + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(high, high), 16)), scale));
+    }
+#endif
+    for (; i < sample_count; ++i) {
+        output[i] = ((float)input[i] - 128.0f) / 128.0f;
+    }
+}
+
+static void decode_s16(float* output, const uint8_t* input, uint32_t sample_count)
+{
+    uint32_t i = 0;
+#if AUDIO_IMPORT_SSE2
+    __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+    for (; i + 8 <= sample_count; i += 8) {
+        __m128i words = _mm_loadu_si128((const __m128i*)(input + i * 2));
+        _mm_storeu_ps(output + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(words, words), 16)), scale));
+        _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(words, words), 16)), scale));
+    }
+#endif
+    for (; i < sample_count; ++i) {
+        int16_t sample = (int16_t)(input[i * 2] | (input[i * 2 + 1] << 8));
+        output[i] = (float)sample / 32768.0f;
+    }
+}
+
+static void decode_s24(float* output, const uint8_t* input, uint32_t sample_count)
+{
+    // Packed 3-byte samples don't line up with vector lanes.
+    for (uint32_t i = 0; i < sample_count; ++i) {
+        const uint8_t* bytes = input + i * 3;
+        int32_t sample = (int32_t)(((uint32_t)bytes[0] << 8) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 24)) >> 8;
+        output[i] = (float)sample / 8388608.0f;
+    }
+}
+
+static void decode_s32(float* output, const uint8_t* input, uint32_t sample_count)
+{
+    uint32_t i = 0;
+#if AUDIO_IMPORT_SSE2
+    __m128 scale = _mm_set1_ps(1.0f / 2147483648.0f);
+    for (; i + 4 <= sample_count; i += 4) {
+        __m128i words = _mm_loadu_si128((const __m128i*)(input + i * 4));
+        _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(words), scale));
+    }
+#endif
+    for (; i < sample_count; ++i) {
+        int32_t sample;
+        memcpy(&sample, input + i * 4, sizeof(sample));
+        output[i] = (float)sample / 2147483648.0f;
+    }
+}
+
+static void decode_f32(float* output, const uint8_t* input, uint32_t sample_count)
+{
+    memcpy(output, input, sample_count * sizeof(float));
+}
+
+static void decode_f64(float* output, const uint8_t* input, uint32_t sample_count)
+{
+    for (uint32_t i = 0; i < sample_count; ++i) {
+        double sample;
+        memcpy(&sample, input + i * 8, sizeof(sample));
+        output[i] = (float)sample;
+    }
+}
+
+// Speaker layouts WAVE assumes when a file has no channel mask, by channel count.
+static uint32_t get_default_channel_mask(uint32_t channels)
+{
+    switch (channels) {
+    case 1: return WAVE_SPEAKER_FRONT_CENTER;
+    case 2: return WAVE_SPEAKER_FRONT_LEFT | WAVE_SPEAKER_FRONT_RIGHT;
+    case 3: return WAVE_SPEAKER_FRONT_LEFT | WAVE_SPEAKER_FRONT_RIGHT | WAVE_SPEAKER_FRONT_CENTER;
+    case 4: return WAVE_SPEAKER_FRONT_LEFT | WAVE_SPEAKER_FRONT_RIGHT | WAVE_SPEAKER_BACK_LEFT | WAVE_SPEAKER_BACK_RIGHT;
+    case 5: return WAVE_SPEAKER_FRONT_LEFT | WAVE_SPEAKER_FRONT_RIGHT | WAVE_SPEAKER_FRONT_CENTER | WAVE_SPEAKER_BACK_LEFT | WAVE_SPEAKER_BACK_RIGHT;
+    case 6: return WAVE_SPEAKER_FRONT_LEFT | WAVE_SPEAKER_FRONT_RIGHT | WAVE_SPEAKER_FRONT_CENTER | WAVE_SPEAKER_LOW_FREQUENCY |
+        WAVE_SPEAKER_BACK_LEFT | WAVE_SPEAKER_BACK_RIGHT;
+    case 8: return WAVE_SPEAKER_FRONT_LEFT | WAVE_SPEAKER_FRONT_RIGHT | WAVE_SPEAKER_FRONT_CENTER | WAVE_SPEAKER_LOW_FREQUENCY |
+        WAVE_SPEAKER_BACK_LEFT | WAVE_SPEAKER_BACK_RIGHT | WAVE_SPEAKER_SIDE_LEFT | WAVE_SPEAKER_SIDE_RIGHT;
+    default: return 0;
+    }
+}
+
+// Left and right gain of one speaker. Fronts pass through, centers and
+// surrounds go in at -3 dB, the LFE is dropped like most stereo downmixes do.
+static void get_speaker_gains(uint32_t speaker, float* left, float* right)
+{
+    const float attenuated = 0.70710678f;
+    const uint32_t left_speakers = WAVE_SPEAKER_BACK_LEFT | WAVE_SPEAKER_FRONT_LEFT_OF_CENTER | WAVE_SPEAKER_SIDE_LEFT |
+        WAVE_SPEAKER_TOP_FRONT_LEFT | WAVE_SPEAKER_TOP_BACK_LEFT;
+    const uint32_t right_speakers = WAVE_SPEAKER_BACK_RIGHT | WAVE_SPEAKER_FRONT_RIGHT_OF_CENTER | WAVE_SPEAKER_SIDE_RIGHT |
+        WAVE_SPEAKER_TOP_FRONT_RIGHT | WAVE_SPEAKER_TOP_BACK_RIGHT;
+    *left = 0.0f;
+    *right = 0.0f;
+    if (speaker == WAVE_SPEAKER_FRONT_LEFT) {
+        *left = 1.0f;
+    }
+    else if (speaker == WAVE_SPEAKER_FRONT_RIGHT) {
+        *right = 1.0f;
+    }
+    else if (speaker & left_speakers) {
+        *left = attenuated;
+    }
+    else if (speaker & right_speakers) {
+        *right = attenuated;
+    }
+    else if (speaker != WAVE_SPEAKER_LOW_FREQUENCY) {
+        *left = attenuated;
+        *right = attenuated;
+    }
+}
+
+// Folds the speakers of channel_mask (or the default layout of the channel
+// count) down to stereo. Channels past the mask have no position and are
+// dropped. Gains are scaled so full scale on every channel can't clip.
+static void fold_to_stereo(float* output, const float* input, uint32_t frame_count, uint32_t channels, uint32_t channel_mask)
+{
+    if (channel_mask == 0) {
+        channel_mask = get_default_channel_mask(channels);
+    }
+
+    std::vector<float> gains(channels * 2, 0.0f);
+    float left_sum = 0.0f;
+    float right_sum = 0.0f;
+    uint32_t assigned = 0;
+    for (uint32_t bit = 0; bit < 32 && assigned < channels; ++bit) {
+        uint32_t speaker = 1u << bit;
+        if (channel_mask & speaker) {
+            get_speaker_gains(speaker, &gains[assigned * 2 + 0], &gains[assigned * 2 + 1]);
+            left_sum += gains[assigned * 2 + 0];
+            right_sum += gains[assigned * 2 + 1];
+            ++assigned;
+        }
+    }
+    float largest_sum = left_sum > right_sum ? left_sum : right_sum;
+    if (largest_sum > 1.0f) {
+        for (float& gain : gains) {
+            gain /= largest_sum;
+        }
+    }
+
+    for (uint32_t frame = 0; frame < frame_count; ++frame) {
+        const float* in = input + frame * channels;
+        float left = 0.0f;
+        float right = 0.0f;
+        for (uint32_t channel = 0; channel < channels; ++channel) {
+            left += in[channel] * gains[channel * 2 + 0];
+            right += in[channel] * gains[channel * 2 + 1];
+        }
+        output[frame * 2 + 0] = left;
+        output[frame * 2 + 1] = right;
+    }
+}
+
+// Linear interpolation, positions in 32.32 fixed point so long sounds don't drift.
+static void resample_linear(float* output, uint32_t output_frames, const float* input, uint32_t input_frames, uint32_t channels, uint64_t step)
+{
+    uint32_t frame = 0;
+    uint64_t position = 0;
+#if AUDIO_IMPORT_SSE2
+    // Four output frames at a time while the last of them still has a next input frame.
+    // Positions are kept as 32-bit index and fraction lanes with a manual carry.
+    if (channels <= 2 && output_frames >= 4) {
+        const __m128i sign = _mm_set1_epi32((int)0x80000000);
+        const __m128i low_mask = _mm_set1_epi32(0xFFFF);
+        __m128i step_fraction = _mm_set1_epi32((int)(uint32_t)(step * 4));
+        __m128i step_index = _mm_set1_epi32((int)(uint32_t)((step * 4) >> 32));
+        __m128i lane_fraction = _mm_setr_epi32(0, (int)(uint32_t)step, (int)(uint32_t)(step * 2), (int)(uint32_t)(step * 3));
+        __m128i lane_index = _mm_setr_epi32(0, (int)(uint32_t)(step >> 32), (int)(uint32_t)((step * 2) >> 32), (int)(uint32_t)((step * 3) >> 32));
+        for (; frame + 4 <= output_frames && ((position + step * 3) >> 32) + 1 < input_frames; frame += 4, position += step * 4) {
+            // Same rounding as the scalar (float)fraction, both 16-bit halves convert exactly.
+            __m128 high = _mm_cvtepi32_ps(_mm_srli_epi32(lane_fraction, 16));
+            __m128 low = _mm_cvtepi32_ps(_mm_and_si128(lane_fraction, low_mask));
+            __m128 t = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(high, _mm_set1_ps(65536.0f)), low), _mm_set1_ps(1.0f / 4294967296.0f));
+            uint32_t index[4];
+            _mm_storeu_si128((__m128i*)index, lane_index);
+
+            if (channels == 1) {
+                __m128 a = _mm_setr_ps(input[index[0]], input[index[1]], input[index[2]], input[index[3]]);
+                __m128 b = _mm_setr_ps(input[index[0] + 1], input[index[1] + 1], input[index[2] + 1], input[index[3] + 1]);
+                _mm_storeu_ps(output + frame, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t)));
+            }
+            else {
+                // Two stereo frames per register, left and right share the fraction.
+                __m128 a = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(input + index[0] * 2)), (const __m64*)(input + index[1] * 2));
+                __m128 b = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(input + index[0] * 2 + 2)), (const __m64*)(input + index[1] * 2 + 2));
+                _mm_storeu_ps(output + frame * 2, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_unpacklo_ps(t, t))));
+                a = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(input + index[2] * 2)), (const __m64*)(input + index[3] * 2));
+                b = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(input + index[2] * 2 + 2)), (const __m64*)(input + index[3] * 2 + 2));
+                _mm_storeu_ps(output + frame * 2 + 4, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_unpackhi_ps(t, t))));
+            }
+
+            // Unsigned overflow of the fraction carries into the index.
+            __m128i next_fraction = _mm_add_epi32(lane_fraction, step_fraction);
+            __m128i carry = _mm_cmpgt_epi32(_mm_xor_si128(lane_fraction, sign), _mm_xor_si128(next_fraction, sign));
+            lane_index = _mm_sub_epi32(_mm_add_epi32(lane_index, step_index), carry);
+            lane_fraction = next_fraction;
+        }
+    }
+#endif
+    for (; frame < output_frames; ++frame, position += step) {
+        uint32_t index = (uint32_t)(position >> 32);
+        float fraction = (float)(position & 0xFFFFFFFFull) * (1.0f / 4294967296.0f);
+        uint32_t next = index + 1 < input_frames ? index + 1 : index;
+        for (uint32_t channel = 0; channel < channels; ++channel) {
+            float a = input[index * channels + channel];
+            float b = input[next * channels + channel];
+            output[frame * channels + channel] = a + (b - a) * fraction;
+        }
+    }
+}
+
+bool import_wave(const WaveFile& wave, ImportedSound* sound)
+{
+    void (*decode)(float*, const uint8_t*, uint32_t) = nullptr;
+    if (wave.format_tag == WAVE_TAG_PCM) {
+        switch (wave.bits_per_sample) {
+        case 8: decode = decode_u8; break;
+        case 16: decode = decode_s16; break;
+        case 24: decode = decode_s24; break;
+        case 32: decode = decode_s32; break;
+        }
+    }
+    else if (wave.format_tag == WAVE_TAG_IEEE_FLOAT) {
+        switch (wave.bits_per_sample) {
+        case 32: decode = decode_f32; break;
+        case 64: decode = decode_f64; break;
+        }
+    }
+    uint32_t bytes_per_sample = wave.bits_per_sample / 8;
+    if (decode == nullptr || wave.block_align != bytes_per_sample * wave.channels) {
+        return false;
+    }
+
+    uint32_t channels = wave.channels > 2 ? 2 : wave.channels;
+    uint32_t frame_count = wave.sample_bytes / wave.block_align;
+    sound->channels = channels;
+    sound->converted.clear();
+
+    if (wave.format_tag == WAVE_TAG_PCM && wave.bits_per_sample == 16 &&
+        wave.channels == channels && wave.sample_rate == CANONICAL_SAMPLE_RATE) {
+        sound->frame_count = frame_count;
+        sound->passthrough = (const int16_t*)wave.samples;
+        return true;
+    }
+
+    std::vector<float> decoded((size_t)frame_count * wave.channels);
+    decode(decoded.data(), wave.samples, frame_count * wave.channels);
+
+    if (wave.channels > 2) {
+        std::vector<float> folded((size_t)frame_count * 2);
+        fold_to_stereo(folded.data(), decoded.data(), frame_count, wave.channels, wave.channel_mask);
+        decoded.swap(folded);
+    }
+
+    if (wave.sample_rate != CANONICAL_SAMPLE_RATE && frame_count > 0) {
+        uint64_t step = ((uint64_t)wave.sample_rate << 32) / CANONICAL_SAMPLE_RATE;
+        uint32_t resampled_frames = (uint32_t)(((uint64_t)frame_count * CANONICAL_SAMPLE_RATE) / wave.sample_rate);
+        std::vector<float> resampled((size_t)resampled_frames * channels);
+        resample_linear(resampled.data(), resampled_frames, decoded.data(), frame_count, channels, step);
+        decoded.swap(resampled);
+        frame_count = resampled_frames;
+    }
+
+    sound->frame_count = frame_count;
+    sound->passthrough = nullptr;
+    sound->converted.resize((size_t)frame_count * channels);
+    convert_float_to_s16(sound->converted.data(), decoded.data(), frame_count * channels);
+    return true;
+}
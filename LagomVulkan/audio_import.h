@@ -0,0 +1,27 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "wave_file.h"
+
+constexpr uint32_t CANONICAL_SAMPLE_RATE = 48000;
+
+// Sound in the one format every backend plays: signed 16-bit,
+// CANONICAL_SAMPLE_RATE, mono or stereo.
+struct ImportedSound {
+    uint32_t channels = 0;
+    uint32_t frame_count = 0;
+
+    // Either points into the parsed WAVE data when it was canonical
+    // already, or at converted.
+    const int16_t* get_samples() const { return converted.empty() ? passthrough : converted.data(); }
+    uint32_t get_byte_size() const { return frame_count * channels * sizeof(int16_t); }
+
+    const int16_t* passthrough = nullptr;
+    std::vector<int16_t> converted;
+};
+
+// Converts 8, 16, 24 and 32-bit PCM and 32/64-bit float with any channel
+// count. More than two channels are folded down to stereo by speaker position
+// (the extensible channel mask or the default layout), other rates
+// are resampled with linear interpolation. Canonical input isn't copied.
+bool import_wave(const WaveFile& wave, ImportedSound* sound);
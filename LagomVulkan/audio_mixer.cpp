@@ -0,0 +1,338 @@
+#include "audio_mixer.h"
+#include "audio_import.h"
+#include "mapped_file.h"
+#include "mix_kernels.h"
+#include "wave_file.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string.h>
+
+// More than this per update means the caller stalled, don't write the gap.
+constexpr uint32_t MIXER_MAX_FILE_FRAMES_PER_UPDATE = MIXER_SAMPLE_RATE / 4;
+
+static SoundHandle make_handle(uint32_t index, uint16_t generation)
+{
+    SoundHandle handle;
+    handle.id = ((uint32_t)generation << 16) | (index + 1);
+    return handle;
+}
+
+static void write_u16(std::ofstream& file, uint16_t value)
+{
+    uint8_t bytes[2] = { (uint8_t)value, (uint8_t)(value >> 8) };
+    file.write((const char*)bytes, sizeof(bytes));
+}
+
+static void write_u32(std::ofstream& file, uint32_t value)
+{
+    uint8_t bytes[4] = { (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24) };
+    file.write((const char*)bytes, sizeof(bytes));
+}
+
+AudioMixer::AudioMixer(const std::string& output_filename)
+{
+    _voices.resize(MIXER_MAX_VOICES);
+    _bus.resize(MIXER_BLOCK_FRAMES * 2);
+    _pcm.resize(MIXER_BLOCK_FRAMES * 2);
+
+    _to_file = !output_filename.empty();
+    if (_to_file) {
+        _init_file(output_filename);
+    }
+    else {
+        _init_device();
+    }
+    _last_update = std::chrono::steady_clock::now();
+}
+
+AudioMixer::~AudioMixer()
+{
+    if (_to_file) {
+        _deinit_file();
+    }
+    else {
+        _deinit_device();
+    }
+}
+
+int AudioMixer::load_sound(const std::string& filename)
+{
+    MappedFile file;
+    WaveFile wave;
+    if (!file.open(filename) || !parse_wave(file.get_data(), file.get_size(), &wave)) {
+        std::cout << "Unable to load sound: " << filename << std::endl;
+        return -1;
+    }
+    ImportedSound imported;
+    if (!import_wave(wave, &imported)) {
+        std::cout << "Unsupported WAVE format in: " << filename << std::endl;
+        return -1;
+    }
+
+    Sound sound;
+    sound.channels = imported.channels;
+    sound.frame_count = imported.frame_count;
+    sound.samples.resize(sound.frame_count * sound.channels);
+    const int16_t* samples = imported.get_samples();
+    for (size_t i = 0; i < sound.samples.size(); ++i) {
+        sound.samples[i] = (float)samples[i] / 32768.0f;
+    }
+
+    _sounds.push_back(std::move(sound));
+    return (int)_sounds.size() - 1;
+}
+
+void AudioMixer::set_sound_pan(SoundHandle sound, float pan)
+{
+    Voice* voice = _find_voice(sound);
+    if (voice != nullptr) {
+        voice->pan = std::min(std::max(pan, -1.0f), 1.0f);
+    }
+}
+
+void AudioMixer::mix(float* output, uint32_t frame_count)
+{
+    memset(output, 0, sizeof(float) * frame_count * 2);
+
+    for (auto& voice : _voices) {
+        if (!voice.active) {
+            continue;
+        }
+        const Sound& sound = _sounds[voice.sound];
+        uint32_t frames = std::min(frame_count, sound.frame_count - voice.position);
+        const float* source = sound.samples.data() + voice.position * sound.channels;
+
+        if (sound.channels == 1) {
+            // Equal power pan, centered mono ends up at -3 dB per side.
+            float angle = (voice.pan + 1.0f) * 0.78539816f;
+            mix_mono_to_stereo(output, source, frames, voice.gain * std::cos(angle), voice.gain * std::sin(angle));
+        }
+        else {
+            // Balance, the far side is turned down and the near one left alone.
+            float gain_left = voice.gain * std::min(1.0f, 1.0f - voice.pan);
+            float gain_right = voice.gain * std::min(1.0f, 1.0f + voice.pan);
+            mix_stereo_to_stereo(output, source, frames, gain_left, gain_right);
+        }
+
+        voice.position += frames;
+        if (voice.position == sound.frame_count) {
+            _release(voice);
+        }
+    }
+}
+
+SoundHandle AudioMixer::play_sound(int soundID, float gain, int priority)
+{
+    if (soundID < 0 || soundID >= (int)_sounds.size()) {
+        return SoundHandle();
+    }
+
+    // Same policy as VoicePool: a free voice, else the lowest priority, quietest, oldest.
+    Voice* chosen = nullptr;
+    for (auto& voice : _voices) {
+        if (!voice.active) {
+            chosen = &voice;
+            break;
+        }
+        if (chosen == nullptr ||
+            voice.priority < chosen->priority ||
+            (voice.priority == chosen->priority && voice.gain < chosen->gain) ||
+            (voice.priority == chosen->priority && voice.gain == chosen->gain && voice.start_order < chosen->start_order)) {
+            chosen = &voice;
+        }
+    }
+    if (chosen->active) {
+        if (chosen->priority > priority || (chosen->priority == priority && chosen->gain > gain)) {
+            return SoundHandle();
+        }
+        _release(*chosen);
+    }
+
+    chosen->active = true;
+    chosen->sound = (uint32_t)soundID;
+    chosen->position = 0;
+    chosen->gain = gain;
+    chosen->pan = 0.0f;
+    chosen->priority = priority;
+    chosen->start_order = _start_counter++;
+    return make_handle((uint32_t)(chosen - _voices.data()), chosen->generation);
+}
+
+void AudioMixer::stop_sound(SoundHandle sound)
+{
+    Voice* voice = _find_voice(sound);
+    if (voice != nullptr) {
+        _release(*voice);
+    }
+}
+
+bool AudioMixer::is_sound_playing(SoundHandle sound)
+{
+    return _find_voice(sound) != nullptr;
+}
+
+void AudioMixer::set_sound_gain(SoundHandle sound, float gain)
+{
+    Voice* voice = _find_voice(sound);
+    if (voice != nullptr) {
+        voice->gain = gain;
+    }
+}
+
+void AudioMixer::update()
+{
+    if (_to_file) {
+        _update_file();
+    }
+    else {
+        _update_device();
+    }
+}
+
+void AudioMixer::_init_device()
+{
+    _device = alcOpenDevice(nullptr);
+    if (_device == nullptr) {
+        assert(0 && "Unable to open an audio device for the mixer");
+        std::exit(-1);
+    }
+    _context = alcCreateContext(_device, nullptr);
+    alcMakeContextCurrent(_context);
+
+    alGetError();
+    alGenSources(1, &_source);
+    alGenBuffers(MIXER_DEVICE_BUFFERS, _buffers);
+    ALenum error = alGetError();
+    if (error != AL_NO_ERROR) {
+        std::cout << "Error: " << error << " ";
+        assert(0 && "Unable to create the mixer output source");
+        std::exit(-1);
+    }
+
+    // Prime the whole queue, update() keeps it full from here on.
+    for (uint32_t i = 0; i < MIXER_DEVICE_BUFFERS; ++i) {
+        mix(_bus.data(), MIXER_BLOCK_FRAMES);
+        convert_float_to_s16(_pcm.data(), _bus.data(), MIXER_BLOCK_FRAMES * 2);
+        alBufferData(_buffers[i], AL_FORMAT_STEREO16, _pcm.data(), (ALsizei)(_pcm.size() * sizeof(int16_t)), MIXER_SAMPLE_RATE);
+    }
+    alSourceQueueBuffers(_source, MIXER_DEVICE_BUFFERS, _buffers);
+    alSourcePlay(_source);
+}
+
+void AudioMixer::_deinit_device()
+{
+    alSourceStop(_source);
+    alSourcei(_source, AL_BUFFER, 0);
+    alDeleteBuffers(MIXER_DEVICE_BUFFERS, _buffers);
+    alDeleteSources(1, &_source);
+    alcMakeContextCurrent(nullptr);
+    alcDestroyContext(_context);
+    alcCloseDevice(_device);
+}
+
+void AudioMixer::_init_file(const std::string& filename)
+{
+    _file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!_file) {
+        assert(0 && "Unable to open the mixer output file");
+        std::exit(-1);
+    }
+
+    // 16-bit stereo PCM, sizes are patched in _deinit_file.
+    _file.write("RIFF", 4);
+    write_u32(_file, 0);
+    _file.write("WAVEfmt ", 8);
+    write_u32(_file, 16);
+    write_u16(_file, WAVE_TAG_PCM);
+    write_u16(_file, 2);
+    write_u32(_file, MIXER_SAMPLE_RATE);
+    write_u32(_file, MIXER_SAMPLE_RATE * 4);
+    write_u16(_file, 4);
+    write_u16(_file, 16);
+    _file.write("data", 4);
+    write_u32(_file, 0);
+}
+
+void AudioMixer::_deinit_file()
+{
+    uint32_t data_size = _file_frames * 4;
+    _file.seekp(4);
+    write_u32(_file, 36 + data_size);
+    _file.seekp(40);
+    write_u32(_file, data_size);
+    _file.close();
+}
+
+void AudioMixer::_update_device()
+{
+    ALint processed = 0;
+    alGetSourcei(_source, AL_BUFFERS_PROCESSED, &processed);
+    while (processed > 0) {
+        ALuint buffer = 0;
+        alSourceUnqueueBuffers(_source, 1, &buffer);
+        mix(_bus.data(), MIXER_BLOCK_FRAMES);
+        convert_float_to_s16(_pcm.data(), _bus.data(), MIXER_BLOCK_FRAMES * 2);
+        alBufferData(buffer, AL_FORMAT_STEREO16, _pcm.data(), (ALsizei)(_pcm.size() * sizeof(int16_t)), MIXER_SAMPLE_RATE);
+        alSourceQueueBuffers(_source, 1, &buffer);
+        --processed;
+    }
+
+    ALint state = AL_STOPPED;
+    alGetSourcei(_source, AL_SOURCE_STATE, &state);
+    if (state != AL_PLAYING) {
+        // We fell behind and the queue ran dry.
+        alSourcePlay(_source);
+    }
+}
+
+void AudioMixer::_update_file()
+{
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - _last_update).count();
+    uint32_t frames = std::min((uint32_t)(elapsed * MIXER_SAMPLE_RATE), MIXER_MAX_FILE_FRAMES_PER_UPDATE);
+    if (frames == 0) {
+        return;
+    }
+    // Only advance by what was written so rounding never drifts.
+    _last_update += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>((double)frames / MIXER_SAMPLE_RATE));
+    if (elapsed * MIXER_SAMPLE_RATE > MIXER_MAX_FILE_FRAMES_PER_UPDATE) {
+        _last_update = now;
+    }
+
+    while (frames > 0) {
+        uint32_t block = std::min(frames, MIXER_BLOCK_FRAMES);
+        mix(_bus.data(), block);
+        convert_float_to_s16(_pcm.data(), _bus.data(), block * 2);
+        for (uint32_t i = 0; i < block * 2; ++i) {
+            write_u16(_file, (uint16_t)_pcm[i]);
+        }
+        _file_frames += block;
+        frames -= block;
+    }
+}
+
+AudioMixer::Voice* AudioMixer::_find_voice(SoundHandle sound)
+{
+    uint32_t index = (sound.id & 0xFFFF) - 1;
+    uint16_t generation = (uint16_t)(sound.id >> 16);
+    if (sound.id == 0 || index >= _voices.size()) {
+        return nullptr;
+    }
+    Voice& voice = _voices[index];
+    if (!voice.active || voice.generation != generation) {
+        return nullptr;
+    }
+    return &voice;
+}
+
+void AudioMixer::_release(Voice& voice)
+{
+    voice.active = false;
+    if (++voice.generation == 0) {
+        voice.generation = 1;
+    }
+}
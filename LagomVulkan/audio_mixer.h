@@ -0,0 +1,98 @@
+#pragma once
+#include <al.h>
+#include <alc.h>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "audio.h"
+#include "audio_import.h"
+
+constexpr uint32_t MIXER_SAMPLE_RATE = CANONICAL_SAMPLE_RATE;
+constexpr uint32_t MIXER_BLOCK_FRAMES = 1024;
+constexpr uint32_t MIXER_MAX_VOICES = 1024;
+constexpr uint32_t MIXER_DEVICE_BUFFERS = 4;
+
+// Audio backend that mixes every voice itself into a float stereo bus with
+// the SIMD kernels in mix_kernels.h. The result is played through a single
+// streaming OpenAL source, or written to a WAVE file so mixing can run on
+// machines without an audio device. Sounds are imported to the canonical
+// format and kept as float.
+class AudioMixer : public Audio {
+public:
+    // Writes to output_filename instead of a device when it is not empty.
+    AudioMixer(const std::string& output_filename);
+    virtual ~AudioMixer();
+
+    // -1 is full left, 1 full right.
+    void set_sound_pan(SoundHandle sound, float pan);
+
+    // Mixes the next frame_count frames of all voices into output as
+    // interleaved stereo, and frees voices that reach their end.
+    void mix(float* output, uint32_t frame_count);
+
+    // Loads right away, -1 if the file can't be used.
+    virtual int load_sound(const std::string& filename);
+    // Sounds stay loaded for the mixer's lifetime.
+    virtual void unload_sound(int soundID) { /* Do nothing. */ }
+    virtual SoundHandle play_sound(int soundID, float gain, int priority);
+    virtual void stop_sound(SoundHandle sound);
+    virtual bool is_sound_playing(SoundHandle sound);
+    virtual void set_sound_gain(SoundHandle sound, float gain);
+    // 3D emitters and streaming are left to AudioOpenAL.
+    virtual int create_emitter(int soundID, float gain, float max_distance, int priority, bool loop) { return -1; }
+    virtual void destroy_emitter(int emitterID) { /* Do nothing. */ }
+    virtual void set_emitter_position(int emitterID, float x, float y, float z) { /* Do nothing. */ }
+    virtual void set_listener(const float position[3], const float forward[3], const float up[3]) { /* Do nothing. */ }
+    virtual int play_stream(const std::string& filename, bool loop) { return -1; }
+    virtual void stop_stream(int streamID) { /* Do nothing. */ }
+    virtual void update();
+
+private:
+    struct Sound {
+        std::vector<float> samples;
+        uint32_t channels = 0;
+        uint32_t frame_count = 0;
+    };
+
+    struct Voice {
+        uint32_t sound = 0;
+        uint32_t position = 0;
+        float gain = 1.0f;
+        float pan = 0.0f;
+        int priority = 0;
+        uint16_t generation = 1;
+        bool active = false;
+        uint64_t start_order = 0;
+    };
+
+    void _init_device();
+    void _deinit_device();
+
+    void _init_file(const std::string& filename);
+    void _deinit_file();
+
+    void _update_device();
+    void _update_file();
+
+    Voice* _find_voice(SoundHandle sound);
+    void _release(Voice& voice);
+
+    std::vector<Sound> _sounds;
+    std::vector<Voice> _voices;
+    uint64_t _start_counter = 0;
+
+    std::vector<float> _bus;
+    std::vector<int16_t> _pcm;
+
+    bool _to_file = false;
+
+    ALCdevice* _device = nullptr;
+    ALCcontext* _context = nullptr;
+    ALuint _source = 0;
+    ALuint _buffers[MIXER_DEVICE_BUFFERS];
+
+    std::ofstream _file;
+    uint32_t _file_frames = 0;
+    std::chrono::steady_clock::time_point _last_update;
+};
@@ -8,166 +8,171 @@ AudioOpenAL::AudioOpenAL()
 {
     _init_device();
     _init_context();
-    _init_buffers();
+    _init_sound_bank();
+    _init_voices();
+    _init_spatial();
+    _init_streams();
 }
 
 AudioOpenAL::~AudioOpenAL()
 {
-    _deinit_buffers();
+    _deinit_streams();
+    _deinit_spatial();
+    _deinit_voices();
+    _deinit_sound_bank();
     _deinit_context();
     _deinit_device();
 }
 
-void AudioOpenAL::_init_device()
+void AudioOpenAL::set_asset_pack(const AssetPack* pack)
 {
-    _device = alcOpenDevice(nullptr);
+    _sound_bank->set_asset_pack(pack);
 }
 
-void AudioOpenAL::_deinit_device()
+int AudioOpenAL::load_sound(const std::string& filename)
 {
-    alcCloseDevice(_device);
+    return _sound_bank->acquire(filename);
 }
 
-void AudioOpenAL::_init_context()
+void AudioOpenAL::unload_sound(int soundID)
 {
-    _context = alcCreateContext(_device, nullptr);
-    alcMakeContextCurrent(_context);
+    _sound_bank->release(soundID);
 }
 
-void AudioOpenAL::_deinit_context()
+SoundHandle AudioOpenAL::play_sound(int soundID, float gain, int priority)
 {
-    alcMakeContextCurrent(nullptr);
-    alcDestroyContext(_context);
+    // Sounds that haven't finished loading are skipped rather than waited for.
+    ALuint buffer = _sound_bank->get_buffer(soundID);
+    if (buffer == 0) {
+        return SoundHandle();
+    }
+    return _voices->play(buffer, gain, priority, false);
 }
 
-void AudioOpenAL::_init_buffers()
+void AudioOpenAL::stop_sound(SoundHandle sound)
 {
-    _eax_available = alIsExtensionPresent("EAX2.0");
-    alGetError();
-    alGenBuffers(1, _buffers);
-    ALenum error = alGetError();
-    if (error != AL_NO_ERROR) {
-        std::cout << "Error: " << error << " ";
-        assert(0 && "Unable to alGenBuffers");
-        std::exit(-1);
-    }
-    unsigned char* data = nullptr;
-    ALsizei size;
-    ALsizei frequency;
-    ALenum format;
+    _voices->stop(sound);
+}
 
-    _load_wave("THX48@16.wav", _buffers, &size, &frequency, &format, data);
+bool AudioOpenAL::is_sound_playing(SoundHandle sound)
+{
+    return _voices->is_playing(sound);
 }
 
-void AudioOpenAL::_deinit_buffers()
+void AudioOpenAL::set_sound_gain(SoundHandle sound, float gain)
 {
-    alDeleteBuffers(1, _buffers);
+    _voices->set_gain(sound, gain);
 }
 
-bool AudioOpenAL::_load_wave(
-    const std::string filename, 
-    ALuint * buffer, 
-    ALsizei * size, 
-    ALsizei * frequency, 
-    ALenum * format, 
-    unsigned char* data)
+int AudioOpenAL::create_emitter(int soundID, float gain, float max_distance, int priority, bool loop)
 {
-    std::cout << "\nAudio not implemented yet!" << std::endl;
-    return false;
+    return _spatial->create_emitter(soundID, gain, max_distance, priority, loop);
+}
 
-    FILE* audio_file = nullptr;
-    RIFFHeader riff_header;
-    WAVEFormat wave_format;
-    WAVEData wave_data;
+void AudioOpenAL::destroy_emitter(int emitterID)
+{
+    _spatial->destroy_emitter(emitterID);
+}
 
-    // Open sound file.
-    fopen_s(&audio_file, filename.c_str(), "rb");
-    if (!audio_file) {
-        assert(0 && "Unable to open audio file");
-        return false;
-    }
+void AudioOpenAL::set_emitter_position(int emitterID, float x, float y, float z)
+{
+    _spatial->set_emitter_position(emitterID, x, y, z);
+}
 
-    // Read riff header
-    fread(&riff_header, sizeof(RIFFHeader), 1, audio_file);
-
-    // Check for sure it has RIFF and WAVE tag
-    if ((riff_header.chunk_id[0] != 'R' ||
-        riff_header.chunk_id[1] != 'I' ||
-        riff_header.chunk_id[2] != 'F' ||
-        riff_header.chunk_id[3] != 'F') ||
-        (riff_header.format[0] != 'W' ||
-            riff_header.format[1] != 'A' ||
-            riff_header.format[2] != 'V' ||
-            riff_header.format[3] != 'E')) {
-        fclose(audio_file);
-        assert(0 && "Invalid RIFF or WAVE header");
-        return false;
-    }
+void AudioOpenAL::set_listener(const float position[3], const float forward[3], const float up[3])
+{
+    _spatial->set_listener(position, forward, up);
+}
 
-    // Read wave format
-    fread(&wave_format, sizeof(WAVEFormat), 1, audio_file);
-
-    // Check for fmt tag
-    if (wave_format.sub_chunk_id[0] != 'f' ||
-        wave_format.sub_chunk_id[1] != 'm' ||
-        wave_format.sub_chunk_id[2] != 't' ||
-        wave_format.sub_chunk_id[3] != ' ') {
-        fclose(audio_file);
-        assert(0 && "Invalid WAVE format");
-        return false;
+int AudioOpenAL::play_stream(const std::string& filename, bool loop)
+{
+    for (uint32_t i = 0; i < _streams.size(); ++i) {
+        if (!_streams[i]->is_active()) {
+            _streams[i]->start(filename, loop);
+            return (int)i;
+        }
     }
+    return -1;
+}
 
-    // Check for extra parameters
-    if (wave_format.sub_chunk_size > 16) {
-        fseek(audio_file, sizeof(short), SEEK_CUR);
+void AudioOpenAL::stop_stream(int streamID)
+{
+    if (streamID >= 0 && streamID < (int)_streams.size()) {
+        _streams[streamID]->stop();
     }
+}
 
-    // Read wave data
-    fread(&wave_data, sizeof(WAVEData), 1, audio_file);
-    if (wave_data.sub_chunk_id[0] != 'd' ||
-        wave_data.sub_chunk_id[1] != 'a' ||
-        wave_data.sub_chunk_id[2] != 't' ||
-        wave_data.sub_chunk_id[3] != 'a') {
-        fclose(audio_file);
-        assert(0 && "Invalid WAVE data header");
-        return false;
+void AudioOpenAL::update()
+{
+    _sound_bank->update();
+    _voices->update();
+    _spatial->update(_context);
+    for (auto& stream : _streams) {
+        stream->update();
     }
+}
 
-    // Allocate heap memory for data
-    data = new unsigned char[wave_data.sub_chunk_2_size];
+void AudioOpenAL::_init_device()
+{
+    _device = alcOpenDevice(nullptr);
+}
 
-    // Read audio data 
-    if (!fread(data, wave_data.sub_chunk_2_size, 1, audio_file)) {
-        fclose(audio_file);
-        assert(0 && "Error loading wave data into array");
-        return false;
-    }
+void AudioOpenAL::_deinit_device()
+{
+    alcCloseDevice(_device);
+}
 
-    if (size != nullptr) {
-        *size = wave_data.sub_chunk_2_size;
-    }
-    if (frequency != nullptr) {
-        *frequency = wave_format.sample_rate;
-    }
+void AudioOpenAL::_init_context()
+{
+    _context = alcCreateContext(_device, nullptr);
+    alcMakeContextCurrent(_context);
+    _eax_available = alIsExtensionPresent("EAX2.0");
+}
 
-    // Figure out audio format
-    if (format != nullptr) {
-        if (wave_format.num_channels == 1) {
-            if (wave_format.bits_per_sample == 8)
-                *format = AL_FORMAT_MONO8;
-            else if (wave_format.bits_per_sample == 16)
-                *format = AL_FORMAT_MONO16;
-        }
-        else if (wave_format.num_channels == 2) {
-            if (wave_format.bits_per_sample == 8)
-                *format = AL_FORMAT_STEREO8;
-            else if (wave_format.bits_per_sample == 16)
-                *format = AL_FORMAT_STEREO16;
-        }
-    }
+void AudioOpenAL::_deinit_context()
+{
+    alcMakeContextCurrent(nullptr);
+    alcDestroyContext(_context);
+}
 
-    fclose(audio_file);
+void AudioOpenAL::_init_sound_bank()
+{
+    _sound_bank.reset(new SoundBank(SOUND_BANK_BUDGET));
+}
 
-    alBufferData(_buffers[0], *format, data, *size, *frequency);
-    return true;
+void AudioOpenAL::_deinit_sound_bank()
+{
+    _sound_bank.reset();
+}
+
+void AudioOpenAL::_init_voices()
+{
+    _voices.reset(new VoicePool(MAX_AUDIO_VOICES));
+}
+
+void AudioOpenAL::_deinit_voices()
+{
+    _voices.reset();
+}
+
+void AudioOpenAL::_init_spatial()
+{
+    _spatial.reset(new SpatialAudio(_voices.get(), _sound_bank.get()));
+}
+
+void AudioOpenAL::_deinit_spatial()
+{
+    _spatial.reset();
+}
+
+void AudioOpenAL::_init_streams()
+{
+    for (uint32_t i = 0; i < MAX_AUDIO_STREAMS; ++i) {
+        _streams.push_back(std::unique_ptr<AudioStream>(new AudioStream()));
+    }
+}
+
+void AudioOpenAL::_deinit_streams()
+{
+    _streams.clear();
 }
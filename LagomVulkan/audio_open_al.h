@@ -1,15 +1,38 @@
 #pragma once
 #include <al.h>
 #include <alc.h>
+#include <memory>
 #include <string>
+#include <vector>
 #include "audio.h"
+#include "audio_stream.h"
+#include "sound_bank.h"
+#include "spatial_audio.h"
+#include "voice_pool.h"
+
+constexpr uint32_t MAX_AUDIO_STREAMS = 4;
+constexpr uint32_t MAX_AUDIO_VOICES = 32;
+constexpr size_t SOUND_BANK_BUDGET = 64 * 1024 * 1024;
 
 class AudioOpenAL : public Audio {
 public:
     AudioOpenAL();
     virtual ~AudioOpenAL();
-    virtual void play_sound(int soundID) { /* Do nothing. */ }
-    virtual void stop_sound(int soundID) { /* Do nothing. */ }
+    // Sounds are looked up in the pack before the file system.
+    void set_asset_pack(const AssetPack* pack);
+    virtual int load_sound(const std::string& filename);
+    virtual void unload_sound(int soundID);
+    virtual SoundHandle play_sound(int soundID, float gain, int priority);
+    virtual void stop_sound(SoundHandle sound);
+    virtual bool is_sound_playing(SoundHandle sound);
+    virtual void set_sound_gain(SoundHandle sound, float gain);
+    virtual int create_emitter(int soundID, float gain, float max_distance, int priority, bool loop);
+    virtual void destroy_emitter(int emitterID);
+    virtual void set_emitter_position(int emitterID, float x, float y, float z);
+    virtual void set_listener(const float position[3], const float forward[3], const float up[3]);
+    virtual int play_stream(const std::string& filename, bool loop);
+    virtual void stop_stream(int streamID);
+    virtual void update();
 private:
     void _init_device();
     void _deinit_device();
@@ -17,21 +40,25 @@ private:
     void _init_context();
     void _deinit_context();
 
-    void _init_buffers();
-    void _deinit_buffers();
+    void _init_sound_bank();
+    void _deinit_sound_bank();
+
+    void _init_voices();
+    void _deinit_voices();
+
+    void _init_spatial();
+    void _deinit_spatial();
 
-    bool _load_wave(
-        const std::string filename, 
-        ALuint* buffer, 
-        ALsizei* size, 
-        ALsizei* frequency, 
-        ALenum* format, 
-        unsigned char* data);
+    void _init_streams();
+    void _deinit_streams();
 
     ALCdevice* _device = nullptr;
     ALCcontext* _context = nullptr;
 
-    ALuint _buffers[1];
+    std::unique_ptr<SoundBank> _sound_bank;
+    std::unique_ptr<VoicePool> _voices;
+    std::unique_ptr<SpatialAudio> _spatial;
+    std::vector<std::unique_ptr<AudioStream>> _streams;
 
     ALboolean _eax_available = false;
 };
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "audio_stream.h"
+#include "mapped_file.h"
+#include "wave_file.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string.h>
+
+AudioStream::AudioStream()
+{
+    alGenSources(1, &_source);
+    alGenBuffers(STREAM_QUEUE_LENGTH, _buffers);
+    for (uint32_t i = 0; i < STREAM_QUEUE_LENGTH; ++i) {
+        _free_buffers[i] = _buffers[i];
+    }
+    _free_buffer_count = STREAM_QUEUE_LENGTH;
+}
+
+AudioStream::~AudioStream()
+{
+    stop();
+    alDeleteBuffers(STREAM_QUEUE_LENGTH, _buffers);
+    alDeleteSources(1, &_source);
+}
+
+void AudioStream::start(const std::string& filename, bool loop)
+{
+    stop();
+
+    _stop_requested = false;
+    _reader_done = false;
+    _reader_failed = false;
+    _write_index = 0;
+    _read_index = 0;
+    _format = AL_NONE;
+    _sample_rate = 0;
+    _active = true;
+
+    _reader = std::thread(&AudioStream::_reader_main, this, filename, loop);
+}
+
+void AudioStream::stop()
+{
+    if (_reader.joinable()) {
+        _stop_requested = true;
+        _reader_wake.notify_one();
+        _reader.join();
+    }
+
+    alSourceStop(_source);
+    alSourcei(_source, AL_BUFFER, 0);
+    for (uint32_t i = 0; i < STREAM_QUEUE_LENGTH; ++i) {
+        _free_buffers[i] = _buffers[i];
+    }
+    _free_buffer_count = STREAM_QUEUE_LENGTH;
+    _active = false;
+}
+
+void AudioStream::update()
+{
+    if (!_active) {
+        return;
+    }
+    if (_reader_failed) {
+        stop();
+        return;
+    }
+
+    // Recycle what has played, then feed free buffers from the ring.
+    ALint processed = 0;
+    alGetSourcei(_source, AL_BUFFERS_PROCESSED, &processed);
+    while (processed > 0) {
+        alSourceUnqueueBuffers(_source, 1, &_free_buffers[_free_buffer_count]);
+        ++_free_buffer_count;
+        --processed;
+    }
+    while (_free_buffer_count > 0 && _refill(_free_buffers[_free_buffer_count - 1])) {
+        --_free_buffer_count;
+    }
+    ALint queued = (ALint)(STREAM_QUEUE_LENGTH - _free_buffer_count);
+
+    ALint state = AL_STOPPED;
+    alGetSourcei(_source, AL_SOURCE_STATE, &state);
+    if (state != AL_PLAYING && queued > 0) {
+        // Start, or restart after the reader fell behind.
+        alSourcePlay(_source);
+    }
+    else if (state != AL_PLAYING && _reader_done && _read_index == _write_index) {
+        stop();
+    }
+}
+
+bool AudioStream::is_active() const
+{
+    return _active;
+}
+
+bool AudioStream::_refill(ALuint buffer)
+{
+    uint32_t read_index = _read_index.load(std::memory_order_relaxed);
+    if (read_index == _write_index.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    uint32_t slot = read_index % STREAM_SLOT_COUNT;
+    alBufferData(buffer, _format, _slots[slot], (ALsizei)_slot_sizes[slot], _sample_rate);
+    alSourceQueueBuffers(_source, 1, &buffer);
+
+    _read_index.store(read_index + 1, std::memory_order_release);
+    _reader_wake.notify_one();
+    return true;
+}
+
+void AudioStream::_reader_main(std::string filename, bool loop)
+{
+    MappedFile file;
+    WaveFile wave;
+    if (!file.open(filename) || !parse_wave(file.get_data(), file.get_size(), &wave)) {
+        std::cout << "Unable to stream audio file: " << filename << std::endl;
+        _reader_failed = true;
+        return;
+    }
+
+    if (wave.format_tag == WAVE_TAG_PCM && wave.channels == 1 && wave.bits_per_sample == 8) {
+        _format = AL_FORMAT_MONO8;
+    }
+    else if (wave.format_tag == WAVE_TAG_PCM && wave.channels == 1 && wave.bits_per_sample == 16) {
+        _format = AL_FORMAT_MONO16;
+    }
+    else if (wave.format_tag == WAVE_TAG_PCM && wave.channels == 2 && wave.bits_per_sample == 8) {
+        _format = AL_FORMAT_STEREO8;
+    }
+    else if (wave.format_tag == WAVE_TAG_PCM && wave.channels == 2 && wave.bits_per_sample == 16) {
+        _format = AL_FORMAT_STEREO16;
+    }
+    else {
+        std::cout << "Unsupported WAVE format for streaming: " << filename << std::endl;
+        _reader_failed = true;
+        return;
+    }
+    _sample_rate = (ALsizei)wave.sample_rate;
+
+    // Whole sample frames only, so no buffer ever splits a frame.
+    uint32_t slot_capacity = STREAM_SLOT_SIZE - STREAM_SLOT_SIZE % wave.block_align;
+    uint32_t offset = 0;
+    while (!_stop_requested) {
+        uint32_t write_index = _write_index.load(std::memory_order_relaxed);
+        if (write_index - _read_index.load(std::memory_order_acquire) == STREAM_SLOT_COUNT) {
+            std::unique_lock<std::mutex> lock(_reader_mutex);
+            _reader_wake.wait_for(lock, std::chrono::milliseconds(10));
+            continue;
+        }
+
+        if (offset == wave.sample_bytes) {
+            if (!loop || wave.sample_bytes == 0) {
+                break;
+            }
+            offset = 0;
+        }
+
+        uint32_t slot = write_index % STREAM_SLOT_COUNT;
+        uint32_t size = std::min(slot_capacity, wave.sample_bytes - offset);
+        memcpy(_slots[slot], wave.samples + offset, size);
+        _slot_sizes[slot] = size;
+        offset += size;
+
+        _write_index.store(write_index + 1, std::memory_order_release);
+    }
+
+    _reader_done = true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <al.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+constexpr uint32_t STREAM_QUEUE_LENGTH = 4;
+constexpr uint32_t STREAM_SLOT_COUNT = 8;
+constexpr uint32_t STREAM_SLOT_SIZE = 32 * 1024;
+
+// One OpenAL source playing a WAVE file that is never fully resident.
+// A reader thread copies PCM out of the mapped file into a fixed ring of
+// slots, so page faults and disk waits happen there; update() on the AL
+// thread moves filled slots into the source's buffer queue. Memory is
+// STREAM_SLOT_COUNT + STREAM_QUEUE_LENGTH slots no matter the track length.
+class AudioStream {
+public:
+    // Needs a current AL context.
+    AudioStream();
+    ~AudioStream();
+
+    AudioStream(const AudioStream&) = delete;
+    AudioStream& operator=(const AudioStream&) = delete;
+
+    void start(const std::string& filename, bool loop);
+    void stop();
+
+    // Call regularly on the AL thread, never blocks.
+    void update();
+
+    // True from start() until the track has played out, failed or been stopped.
+    bool is_active() const;
+
+private:
+    void _reader_main(std::string filename, bool loop);
+    bool _refill(ALuint buffer);
+
+    ALuint _source = 0;
+    ALuint _buffers[STREAM_QUEUE_LENGTH];
+    // Buffers not currently queued on the source.
+    ALuint _free_buffers[STREAM_QUEUE_LENGTH];
+    uint32_t _free_buffer_count = 0;
+
+    std::thread _reader;
+    std::mutex _reader_mutex;
+    std::condition_variable _reader_wake;
+    std::atomic<bool> _stop_requested{ false };
+    std::atomic<bool> _reader_done{ false };
+    std::atomic<bool> _reader_failed{ false };
+
+    // Single producer ring, written by the reader and read by update().
+    uint8_t _slots[STREAM_SLOT_COUNT][STREAM_SLOT_SIZE];
+    uint32_t _slot_sizes[STREAM_SLOT_COUNT] = {};
+    std::atomic<uint32_t> _write_index{ 0 };
+    std::atomic<uint32_t> _read_index{ 0 };
+
+    // Written by the reader before it publishes the first slot.
+    ALenum _format = AL_NONE;
+    ALsizei _sample_rate = 0;
+
+    bool _active = false;
+};
@@ -0,0 +1,278 @@
+#include "audio_threaded.h"
+
+AudioThreaded::AudioThreaded(std::function<Audio*()> create_backend)
+    : _commands(AUDIO_COMMAND_QUEUE_SIZE)
+{
+    for (auto& live_sound : _live_sounds) {
+        live_sound.store(0, std::memory_order_relaxed);
+    }
+    _thread = std::thread(&AudioThreaded::_thread_main, this, create_backend);
+}
+
+AudioThreaded::~AudioThreaded()
+{
+    _quit = true;
+    _thread.join();
+}
+
+int AudioThreaded::load_sound(const std::string& filename)
+{
+    int sound_id = _next_sound_id.fetch_add(1, std::memory_order_relaxed);
+
+    Command command;
+    command.type = CommandType::LOAD_SOUND;
+    command.id = sound_id;
+    command.filename = new std::string(filename);
+    _push(std::move(command));
+    return sound_id;
+}
+
+void AudioThreaded::unload_sound(int soundID)
+{
+    Command command;
+    command.type = CommandType::UNLOAD_SOUND;
+    command.id = soundID;
+    _push(std::move(command));
+}
+
+SoundHandle AudioThreaded::play_sound(int soundID, float gain, int priority)
+{
+    uint32_t ticket = _next_sound_ticket.fetch_add(1, std::memory_order_relaxed);
+    if (ticket == 0) {
+        ticket = _next_sound_ticket.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Counted as playing until the audio thread says otherwise.
+    _live_sounds[ticket % AUDIO_TICKET_SLOTS].store(ticket, std::memory_order_relaxed);
+
+    Command command;
+    command.type = CommandType::PLAY_SOUND;
+    command.ticket = ticket;
+    command.id = soundID;
+    command.gain = gain;
+    command.priority = priority;
+    _push(std::move(command));
+
+    SoundHandle sound;
+    sound.id = ticket;
+    return sound;
+}
+
+void AudioThreaded::stop_sound(SoundHandle sound)
+{
+    Command command;
+    command.type = CommandType::STOP_SOUND;
+    command.ticket = sound.id;
+    _push(std::move(command));
+}
+
+bool AudioThreaded::is_sound_playing(SoundHandle sound)
+{
+    return sound.is_valid() && _live_sounds[sound.id % AUDIO_TICKET_SLOTS].load(std::memory_order_relaxed) == sound.id;
+}
+
+void AudioThreaded::set_sound_gain(SoundHandle sound, float gain)
+{
+    Command command;
+    command.type = CommandType::SET_SOUND_GAIN;
+    command.ticket = sound.id;
+    command.gain = gain;
+    _push(std::move(command));
+}
+
+int AudioThreaded::create_emitter(int soundID, float gain, float max_distance, int priority, bool loop)
+{
+    int emitter_id = _next_emitter_id.fetch_add(1, std::memory_order_relaxed);
+
+    Command command;
+    command.type = CommandType::CREATE_EMITTER;
+    command.ticket = (uint32_t)emitter_id;
+    command.id = soundID;
+    command.gain = gain;
+    command.max_distance = max_distance;
+    command.priority = priority;
+    command.loop = loop;
+    _push(std::move(command));
+    return emitter_id;
+}
+
+void AudioThreaded::destroy_emitter(int emitterID)
+{
+    Command command;
+    command.type = CommandType::DESTROY_EMITTER;
+    command.ticket = (uint32_t)emitterID;
+    _push(std::move(command));
+}
+
+void AudioThreaded::set_emitter_position(int emitterID, float x, float y, float z)
+{
+    Command command;
+    command.type = CommandType::SET_EMITTER_POSITION;
+    command.ticket = (uint32_t)emitterID;
+    command.vectors[0] = x;
+    command.vectors[1] = y;
+    command.vectors[2] = z;
+    _push(std::move(command));
+}
+
+void AudioThreaded::set_listener(const float position[3], const float forward[3], const float up[3])
+{
+    Command command;
+    command.type = CommandType::SET_LISTENER;
+    for (uint32_t i = 0; i < 3; ++i) {
+        command.vectors[i] = position[i];
+        command.vectors[i + 3] = forward[i];
+        command.vectors[i + 6] = up[i];
+    }
+    _push(std::move(command));
+}
+
+int AudioThreaded::play_stream(const std::string& filename, bool loop)
+{
+    int ticket = _next_stream_ticket.fetch_add(1, std::memory_order_relaxed);
+
+    // Streams start rarely, the one allocation here doesn't matter.
+    Command command;
+    command.type = CommandType::PLAY_STREAM;
+    command.ticket = (uint32_t)ticket;
+    command.loop = loop;
+    command.filename = new std::string(filename);
+    _push(std::move(command));
+    return ticket;
+}
+
+void AudioThreaded::stop_stream(int streamID)
+{
+    Command command;
+    command.type = CommandType::STOP_STREAM;
+    command.ticket = (uint32_t)streamID;
+    _push(std::move(command));
+}
+
+void AudioThreaded::_push(Command&& command)
+{
+    // Only spins if the audio thread is thousands of commands behind.
+    while (!_commands.try_push(std::move(command))) {
+        std::this_thread::yield();
+    }
+}
+
+void AudioThreaded::_thread_main(std::function<Audio*()> create_backend)
+{
+    _backend.reset(create_backend());
+
+    Command command;
+    while (!_quit) {
+        while (_commands.try_pop(command)) {
+            _execute(command);
+        }
+        _backend->update();
+        _refresh_live_sounds();
+        std::this_thread::sleep_for(AUDIO_THREAD_PERIOD);
+    }
+
+    // Free whatever is left, strings included.
+    while (_commands.try_pop(command)) {
+        _execute(command);
+    }
+    _backend.reset();
+}
+
+void AudioThreaded::_execute(Command& command)
+{
+    uint32_t slot = command.ticket % AUDIO_TICKET_SLOTS;
+
+    switch (command.type) {
+    case CommandType::LOAD_SOUND:
+        if (command.id >= (int)_sound_ids.size()) {
+            _sound_ids.resize(command.id + 1, -1);
+        }
+        _sound_ids[command.id] = _backend->load_sound(*command.filename);
+        delete command.filename;
+        command.filename = nullptr;
+        break;
+    case CommandType::UNLOAD_SOUND:
+        if (command.id >= 0 && command.id < (int)_sound_ids.size() && _sound_ids[command.id] >= 0) {
+            _backend->unload_sound(_sound_ids[command.id]);
+            _sound_ids[command.id] = -1;
+        }
+        break;
+    case CommandType::PLAY_SOUND: {
+        int sound_id = command.id >= 0 && command.id < (int)_sound_ids.size() ? _sound_ids[command.id] : -1;
+        // An older sound still in this slot loses its ticket, it plays out untracked.
+        SoundHandle sound = _backend->play_sound(sound_id, command.gain, command.priority);
+        if (sound.is_valid()) {
+            _slot_tickets[slot] = command.ticket;
+            _slot_sounds[slot] = sound;
+        }
+        else {
+            uint32_t expected = command.ticket;
+            _live_sounds[slot].compare_exchange_strong(expected, 0);
+        }
+        break;
+    }
+    case CommandType::STOP_SOUND:
+        if (command.ticket != 0 && _slot_tickets[slot] == command.ticket) {
+            _backend->stop_sound(_slot_sounds[slot]);
+        }
+        break;
+    case CommandType::SET_SOUND_GAIN:
+        if (command.ticket != 0 && _slot_tickets[slot] == command.ticket) {
+            _backend->set_sound_gain(_slot_sounds[slot], command.gain);
+        }
+        break;
+    case CommandType::CREATE_EMITTER: {
+        int sound_id = command.id >= 0 && command.id < (int)_sound_ids.size() ? _sound_ids[command.id] : -1;
+        if (command.ticket >= _emitter_ids.size()) {
+            _emitter_ids.resize(command.ticket + 1, -1);
+        }
+        _emitter_ids[command.ticket] = _backend->create_emitter(sound_id, command.gain, command.max_distance, command.priority, command.loop);
+        break;
+    }
+    case CommandType::DESTROY_EMITTER:
+        if (command.ticket < _emitter_ids.size() && _emitter_ids[command.ticket] >= 0) {
+            _backend->destroy_emitter(_emitter_ids[command.ticket]);
+            _emitter_ids[command.ticket] = -1;
+        }
+        break;
+    case CommandType::SET_EMITTER_POSITION:
+        if (command.ticket < _emitter_ids.size() && _emitter_ids[command.ticket] >= 0) {
+            _backend->set_emitter_position(_emitter_ids[command.ticket], command.vectors[0], command.vectors[1], command.vectors[2]);
+        }
+        break;
+    case CommandType::SET_LISTENER:
+        _backend->set_listener(&command.vectors[0], &command.vectors[3], &command.vectors[6]);
+        break;
+    case CommandType::PLAY_STREAM: {
+        int stream = _backend->play_stream(*command.filename, command.loop);
+        if (stream >= 0) {
+            if (stream >= (int)_stream_tickets.size()) {
+                _stream_tickets.resize(stream + 1, -1);
+            }
+            _stream_tickets[stream] = (int)command.ticket;
+        }
+        delete command.filename;
+        command.filename = nullptr;
+        break;
+    }
+    case CommandType::STOP_STREAM:
+        for (uint32_t i = 0; i < _stream_tickets.size(); ++i) {
+            if (_stream_tickets[i] == (int)command.ticket) {
+                _backend->stop_stream((int)i);
+                _stream_tickets[i] = -1;
+            }
+        }
+        break;
+    }
+}
+
+void AudioThreaded::_refresh_live_sounds()
+{
+    for (uint32_t slot = 0; slot < AUDIO_TICKET_SLOTS; ++slot) {
+        uint32_t ticket = _slot_tickets[slot];
+        if (ticket != 0 && !_backend->is_sound_playing(_slot_sounds[slot])) {
+            // Leave the slot alone if a newer sound has been queued into it.
+            _live_sounds[slot].compare_exchange_strong(ticket, 0);
+            _slot_tickets[slot] = 0;
+        }
+    }
+}
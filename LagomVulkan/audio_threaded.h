@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "audio.h"
+#include "command_queue.h"
+
+constexpr uint32_t AUDIO_COMMAND_QUEUE_SIZE = 4096;
+constexpr uint32_t AUDIO_TICKET_SLOTS = 1024;
+constexpr std::chrono::milliseconds AUDIO_THREAD_PERIOD(5);
+
+// Audio front end that is safe to call from any thread. Calls only push a
+// command into a lock-free queue; a dedicated audio thread creates the real
+// backend, so it owns the AL context, and drains the queue every tick.
+// Handles returned here are tickets the audio thread maps to the backend's.
+class AudioThreaded : public Audio {
+public:
+    // create_backend runs on the audio thread.
+    AudioThreaded(std::function<Audio*()> create_backend);
+    virtual ~AudioThreaded();
+
+    virtual int load_sound(const std::string& filename);
+    virtual void unload_sound(int soundID);
+    virtual SoundHandle play_sound(int soundID, float gain, int priority);
+    virtual void stop_sound(SoundHandle sound);
+    virtual bool is_sound_playing(SoundHandle sound);
+    virtual void set_sound_gain(SoundHandle sound, float gain);
+    virtual int create_emitter(int soundID, float gain, float max_distance, int priority, bool loop);
+    virtual void destroy_emitter(int emitterID);
+    virtual void set_emitter_position(int emitterID, float x, float y, float z);
+    virtual void set_listener(const float position[3], const float forward[3], const float up[3]);
+    virtual int play_stream(const std::string& filename, bool loop);
+    virtual void stop_stream(int streamID);
+    // The audio thread updates the backend by itself.
+    virtual void update() { /* Do nothing. */ }
+
+private:
+    enum class CommandType {
+        LOAD_SOUND,
+        UNLOAD_SOUND,
+        PLAY_SOUND,
+        STOP_SOUND,
+        SET_SOUND_GAIN,
+        CREATE_EMITTER,
+        DESTROY_EMITTER,
+        SET_EMITTER_POSITION,
+        SET_LISTENER,
+        PLAY_STREAM,
+        STOP_STREAM,
+    };
+
+    struct Command {
+        CommandType type = CommandType::PLAY_SOUND;
+        uint32_t ticket = 0;
+        int id = 0;
+        float gain = 1.0f;
+        int priority = 0;
+        bool loop = false;
+        // Emitter position, or listener position, forward and up.
+        float vectors[9] = {};
+        float max_distance = 0.0f;
+        // Owned by the command, deleted on the audio thread.
+        std::string* filename = nullptr;
+    };
+
+    void _push(Command&& command);
+
+    void _thread_main(std::function<Audio*()> create_backend);
+    void _execute(Command& command);
+    void _refresh_live_sounds();
+
+    CommandQueue<Command> _commands;
+    std::thread _thread;
+    std::atomic<bool> _quit{ false };
+
+    std::atomic<int> _next_sound_id{ 0 };
+    std::atomic<uint32_t> _next_sound_ticket{ 1 };
+    std::atomic<int> _next_emitter_id{ 0 };
+    std::atomic<int> _next_stream_ticket{ 0 };
+
+    // Ticket of the sound in each slot that is still playing, read by any thread.
+    std::atomic<uint32_t> _live_sounds[AUDIO_TICKET_SLOTS];
+
+    // Audio thread only.
+    std::unique_ptr<Audio> _backend;
+    uint32_t _slot_tickets[AUDIO_TICKET_SLOTS] = {};
+    SoundHandle _slot_sounds[AUDIO_TICKET_SLOTS];
+    // Backend sound id for each id handed out by load_sound.
+    std::vector<int> _sound_ids;
+    std::vector<int> _emitter_ids;
+    std::vector<int> _stream_tickets;
+};
@@ -0,0 +1,140 @@
+#include "cached_pass.h"
+#include "renderer.h"
+#include "shared.h"
+
+#include <cstring>
+
+CachedPass::CachedPass(Renderer* renderer, VkRenderPass render_pass, uint32_t subpass, std::function<void(VkCommandBuffer)> record_function)
+{
+    _renderer = renderer;
+    _render_pass = render_pass;
+    _subpass = subpass;
+    _record_function = record_function;
+    _entries.reserve(CACHED_PASS_MAX_FRAMEBUFFERS);
+
+    _init_command_pool();
+}
+
+CachedPass::~CachedPass()
+{
+    _deinit_command_pool();
+}
+
+void CachedPass::set_static(bool is_static)
+{
+    _static = is_static;
+}
+
+void CachedPass::set_inputs(const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    if (size == _inputs.size() && std::memcmp(_inputs.data(), bytes, size) == 0) {
+        return;
+    }
+    _inputs.assign(bytes, bytes + size);
+    invalidate();
+}
+
+void CachedPass::invalidate()
+{
+    ++_version;
+}
+
+void CachedPass::forget_framebuffers()
+{
+    // Command buffers stay allocated for reuse.
+    for (Entry& entry : _entries) {
+        entry.framebuffer = VK_NULL_HANDLE;
+        entry.version = 0;
+        entry.last_used = 0;
+    }
+}
+
+void CachedPass::execute(VkCommandBuffer command_buffer, VkFramebuffer framebuffer)
+{
+    ++_execute_count;
+    Entry* entry = _find_entry(framebuffer);
+    if (!_static || entry->framebuffer != framebuffer || entry->version != _version) {
+        _record(entry, framebuffer);
+    }
+    entry->last_used = _execute_count;
+    vkCmdExecuteCommands(command_buffer, 1, &entry->command_buffer);
+}
+
+const bool CachedPass::is_static() const
+{
+    return _static;
+}
+
+const uint64_t CachedPass::get_record_count() const
+{
+    return _record_count;
+}
+
+void CachedPass::_init_command_pool()
+{
+    VkCommandPoolCreateInfo pool_create_info{};
+    pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    pool_create_info.queueFamilyIndex = _renderer->get_vulkan_graphics_family_index();
+    error_check(vkCreateCommandPool(_renderer->get_vulkan_device(), &pool_create_info, nullptr, &_command_pool));
+}
+
+void CachedPass::_deinit_command_pool()
+{
+    // Frees the command buffers with it.
+    vkDestroyCommandPool(_renderer->get_vulkan_device(), _command_pool, nullptr);
+    _entries.clear();
+}
+
+CachedPass::Entry * CachedPass::_find_entry(VkFramebuffer framebuffer)
+{
+    Entry* least_recent = nullptr;
+    for (Entry& entry : _entries) {
+        if (entry.framebuffer == framebuffer) {
+            return &entry;
+        }
+        if (least_recent == nullptr || entry.last_used < least_recent->last_used) {
+            least_recent = &entry;
+        }
+    }
+    if (_entries.size() == CACHED_PASS_MAX_FRAMEBUFFERS) {
+        // Forgotten entries were never used since, so they go first.
+        return least_recent;
+    }
+
+    Entry entry;
+    VkCommandBufferAllocateInfo command_buffer_allocate_info{};
+    command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    command_buffer_allocate_info.commandPool = _command_pool;
+    command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    command_buffer_allocate_info.commandBufferCount = 1;
+    error_check(vkAllocateCommandBuffers(_renderer->get_vulkan_device(), &command_buffer_allocate_info, &entry.command_buffer));
+    _entries.push_back(entry);
+    return &_entries.back();
+}
+
+void CachedPass::_record(Entry* entry, VkFramebuffer framebuffer)
+{
+    VkCommandBufferInheritanceInfo inheritance_info{};
+    inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance_info.renderPass = _render_pass;
+    inheritance_info.subpass = _subpass;
+    inheritance_info.framebuffer = framebuffer;
+
+    // Begin resets the buffer, the pool allows it.
+    VkCommandBufferBeginInfo command_buffer_begin_info{};
+    command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    if (!_static) {
+        command_buffer_begin_info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    }
+    command_buffer_begin_info.pInheritanceInfo = &inheritance_info;
+    error_check(vkBeginCommandBuffer(entry->command_buffer, &command_buffer_begin_info));
+    _record_function(entry->command_buffer);
+    error_check(vkEndCommandBuffer(entry->command_buffer));
+
+    entry->framebuffer = framebuffer;
+    entry->version = _version;
+    ++_record_count;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "platform.h"
+
+#include <functional>
+#include <vector>
+
+class Renderer;
+
+// Framebuffers remembered per pass, the least recently used one is recycled past this.
+constexpr uint32_t CACHED_PASS_MAX_FRAMEBUFFERS = 8;
+
+// Keeps the commands of a pass in a secondary command buffer per framebuffer
+// and replays them with vkCmdExecuteCommands. A static pass is recorded
+// through the record function once and re-recorded only when its inputs
+// change, so unchanging UI, backgrounds and static geometry cost no
+// recording at all; a pass that is not static is recorded every execute.
+// Only the commands are cached, clear values and buffer contents read at
+// execution time still change freely. Re-recording happens in execute(),
+// after Window::begin_render has waited for the previous frame.
+class CachedPass {
+public:
+    CachedPass(Renderer* renderer, VkRenderPass render_pass, uint32_t subpass, std::function<void(VkCommandBuffer)> record_function);
+    ~CachedPass();
+
+    void set_static(bool is_static);
+    // Everything the recorded commands bake in (handles, counts, extents),
+    // the pass is invalidated when the bytes differ from the last call.
+    void set_inputs(const void* data, size_t size);
+    // Re-record for every framebuffer on their next execute.
+    void invalidate();
+    // Call when framebuffers are destroyed, so a recycled handle is not mistaken for an old one.
+    void forget_framebuffers();
+
+    // Record inside the render pass, begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+    void execute(VkCommandBuffer command_buffer, VkFramebuffer framebuffer);
+
+    const bool is_static() const;
+    // Times the record function ran, to see the cache at work.
+    const uint64_t get_record_count() const;
+
+private:
+    struct Entry {
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+        uint64_t version = 0;
+        uint64_t last_used = 0;
+    };
+
+    void _init_command_pool();
+    void _deinit_command_pool();
+
+    Entry* _find_entry(VkFramebuffer framebuffer);
+    void _record(Entry* entry, VkFramebuffer framebuffer);
+
+    Renderer* _renderer = nullptr;
+    VkRenderPass _render_pass = VK_NULL_HANDLE;
+    uint32_t _subpass = 0;
+    std::function<void(VkCommandBuffer)> _record_function;
+
+    VkCommandPool _command_pool = VK_NULL_HANDLE;
+    std::vector<Entry> _entries;
+    std::vector<unsigned char> _inputs;
+
+    bool _static = true;
+    // Entries recorded at an older version are dirty.
+    uint64_t _version = 1;
+    uint64_t _execute_count = 0;
+    uint64_t _record_count = 0;
+};
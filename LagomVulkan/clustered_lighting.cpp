@@ -0,0 +1,268 @@
+#include "clustered_lighting.h"
+#include "renderer.h"
+#include "shared.h"
+
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+constexpr uint32_t LIGHT_INDEX_CAPACITY = CLUSTER_COUNT * CLUSTER_AVERAGE_LIGHTS;
+
+struct ClusterPushConstants {
+    float view[16];
+    float projection[4];
+    uint32_t grid[4];
+    uint32_t light_index_capacity;
+};
+
+ClusteredLighting::ClusteredLighting(Renderer* renderer, uint32_t max_lights)
+{
+    _renderer = renderer;
+    _max_lights = max_lights;
+    _view[0] = _view[5] = _view[10] = _view[15] = 1.0f;
+
+    _init_buffers();
+    _init_descriptors();
+    _init_pipeline();
+}
+
+ClusteredLighting::~ClusteredLighting()
+{
+    _deinit_pipeline();
+    _deinit_descriptors();
+    _deinit_buffers();
+}
+
+ClusterLight * ClusteredLighting::get_lights() const
+{
+    return _lights;
+}
+
+void ClusteredLighting::set_light_count(uint32_t light_count)
+{
+    if (light_count > _max_lights) {
+        assert(0 && "More lights than the ClusteredLighting was created for");
+        std::exit(-1);
+    }
+    _light_count = light_count;
+}
+
+void ClusteredLighting::set_view(const float view[16], float vertical_fov, float aspect, float near_plane, float far_plane)
+{
+    std::memcpy(_view, view, sizeof(_view));
+    float tan_half_y = std::tan(vertical_fov * 0.5f);
+    _projection[0] = tan_half_y * aspect;
+    _projection[1] = tan_half_y;
+    _projection[2] = near_plane;
+    _projection[3] = far_plane;
+}
+
+void ClusteredLighting::record_binning(VkCommandBuffer command_buffer)
+{
+    // Last frame's shading and binning must be done with the lists before they are rewritten.
+    VkMemoryBarrier reuse_barrier{};
+    reuse_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    reuse_barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    reuse_barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(command_buffer,
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 1, &reuse_barrier, 0, nullptr, 0, nullptr);
+
+    vkCmdFillBuffer(command_buffer, _light_index_count_buffer, 0, VK_WHOLE_SIZE, 0);
+
+    VkMemoryBarrier clear_barrier{};
+    clear_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    clear_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    clear_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(command_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 1, &clear_barrier, 0, nullptr, 0, nullptr);
+
+    ClusterPushConstants push_constants{};
+    std::memcpy(push_constants.view, _view, sizeof(push_constants.view));
+    std::memcpy(push_constants.projection, _projection, sizeof(push_constants.projection));
+    push_constants.grid[0] = CLUSTER_GRID_X;
+    push_constants.grid[1] = CLUSTER_GRID_Y;
+    push_constants.grid[2] = CLUSTER_GRID_Z;
+    push_constants.grid[3] = _light_count;
+    push_constants.light_index_capacity = LIGHT_INDEX_CAPACITY;
+
+    // Every cluster gets a record, empty ones included.
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline_layout, 0, 1, &_descriptor_set, 0, nullptr);
+    vkCmdPushConstants(command_buffer, _pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push_constants), &push_constants);
+    vkCmdDispatch(command_buffer, CLUSTER_GRID_X, CLUSTER_GRID_Y, CLUSTER_GRID_Z);
+
+    VkMemoryBarrier shade_barrier{};
+    shade_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    shade_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    shade_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        0, 1, &shade_barrier, 0, nullptr, 0, nullptr);
+}
+
+const VkDescriptorSetLayout ClusteredLighting::get_vulkan_descriptor_set_layout() const
+{
+    return _descriptor_set_layout;
+}
+
+const VkDescriptorSet ClusteredLighting::get_vulkan_descriptor_set() const
+{
+    return _descriptor_set;
+}
+
+const uint32_t ClusteredLighting::get_max_lights() const
+{
+    return _max_lights;
+}
+
+void ClusteredLighting::_init_buffers()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+    const VkPhysicalDeviceMemoryProperties* memory_properties = &_renderer->get_vulkan_physical_device_memory_properties();
+
+    create_buffer(device, memory_properties,
+        sizeof(ClusterLight) * _max_lights,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        &_light_buffer, &_light_buffer_memory);
+    void* mapped = nullptr;
+    error_check(vkMapMemory(device, _light_buffer_memory, 0, VK_WHOLE_SIZE, 0, &mapped));
+    _lights = (ClusterLight*)mapped;
+
+    create_buffer(device, memory_properties,
+        sizeof(uint32_t) * 2 * CLUSTER_COUNT,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        &_cluster_buffer, &_cluster_buffer_memory);
+
+    create_buffer(device, memory_properties,
+        sizeof(uint32_t) * LIGHT_INDEX_CAPACITY,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        &_light_index_buffer, &_light_index_buffer_memory);
+
+    create_buffer(device, memory_properties,
+        sizeof(uint32_t),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        &_light_index_count_buffer, &_light_index_count_buffer_memory);
+}
+
+void ClusteredLighting::_deinit_buffers()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+    vkUnmapMemory(device, _light_buffer_memory);
+    vkDestroyBuffer(device, _light_buffer, nullptr);
+    vkFreeMemory(device, _light_buffer_memory, nullptr);
+    vkDestroyBuffer(device, _cluster_buffer, nullptr);
+    vkFreeMemory(device, _cluster_buffer_memory, nullptr);
+    vkDestroyBuffer(device, _light_index_buffer, nullptr);
+    vkFreeMemory(device, _light_index_buffer_memory, nullptr);
+    vkDestroyBuffer(device, _light_index_count_buffer, nullptr);
+    vkFreeMemory(device, _light_index_count_buffer_memory, nullptr);
+    _lights = nullptr;
+}
+
+void ClusteredLighting::_init_descriptors()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+
+    std::array<VkDescriptorSetLayoutBinding, 4> bindings{};
+    for (uint32_t i = 0; i < bindings.size(); ++i) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info{};
+    descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptor_set_layout_create_info.bindingCount = (uint32_t)bindings.size();
+    descriptor_set_layout_create_info.pBindings = bindings.data();
+    error_check(vkCreateDescriptorSetLayout(device, &descriptor_set_layout_create_info, nullptr, &_descriptor_set_layout));
+
+    VkDescriptorPoolSize pool_size{};
+    pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    pool_size.descriptorCount = (uint32_t)bindings.size();
+
+    VkDescriptorPoolCreateInfo descriptor_pool_create_info{};
+    descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptor_pool_create_info.maxSets = 1;
+    descriptor_pool_create_info.poolSizeCount = 1;
+    descriptor_pool_create_info.pPoolSizes = &pool_size;
+    error_check(vkCreateDescriptorPool(device, &descriptor_pool_create_info, nullptr, &_descriptor_pool));
+
+    VkDescriptorSetAllocateInfo descriptor_set_allocate_info{};
+    descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descriptor_set_allocate_info.descriptorPool = _descriptor_pool;
+    descriptor_set_allocate_info.descriptorSetCount = 1;
+    descriptor_set_allocate_info.pSetLayouts = &_descriptor_set_layout;
+    error_check(vkAllocateDescriptorSets(device, &descriptor_set_allocate_info, &_descriptor_set));
+
+    std::array<VkDescriptorBufferInfo, 4> buffer_infos{};
+    buffer_infos[0].buffer = _light_buffer;
+    buffer_infos[0].range = VK_WHOLE_SIZE;
+    buffer_infos[1].buffer = _cluster_buffer;
+    buffer_infos[1].range = VK_WHOLE_SIZE;
+    buffer_infos[2].buffer = _light_index_buffer;
+    buffer_infos[2].range = VK_WHOLE_SIZE;
+    buffer_infos[3].buffer = _light_index_count_buffer;
+    buffer_infos[3].range = VK_WHOLE_SIZE;
+
+    std::array<VkWriteDescriptorSet, 4> writes{};
+    for (uint32_t i = 0; i < writes.size(); ++i) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = _descriptor_set;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].pBufferInfo = &buffer_infos[i];
+    }
+    vkUpdateDescriptorSets(device, (uint32_t)writes.size(), writes.data(), 0, nullptr);
+}
+
+void ClusteredLighting::_deinit_descriptors()
+{
+    vkDestroyDescriptorPool(_renderer->get_vulkan_device(), _descriptor_pool, nullptr);
+    vkDestroyDescriptorSetLayout(_renderer->get_vulkan_device(), _descriptor_set_layout, nullptr);
+}
+
+void ClusteredLighting::_init_pipeline()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+
+    VkPushConstantRange push_constant_range{};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(ClusterPushConstants);
+
+    VkPipelineLayoutCreateInfo pipeline_layout_create_info{};
+    pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_create_info.setLayoutCount = 1;
+    pipeline_layout_create_info.pSetLayouts = &_descriptor_set_layout;
+    pipeline_layout_create_info.pushConstantRangeCount = 1;
+    pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+    error_check(vkCreatePipelineLayout(device, &pipeline_layout_create_info, nullptr, &_pipeline_layout));
+
+    VkShaderModule shader_module = load_shader_module(device, "shaders/cluster_lights.comp.spv");
+
+    VkComputePipelineCreateInfo pipeline_create_info{};
+    pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_create_info.stage.module = shader_module;
+    pipeline_create_info.stage.pName = "main";
+    pipeline_create_info.layout = _pipeline_layout;
+    error_check(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeline_create_info, nullptr, &_pipeline));
+
+    vkDestroyShaderModule(device, shader_module, nullptr);
+}
+
+void ClusteredLighting::_deinit_pipeline()
+{
+    vkDestroyPipeline(_renderer->get_vulkan_device(), _pipeline, nullptr);
+    vkDestroyPipelineLayout(_renderer->get_vulkan_device(), _pipeline_layout, nullptr);
+}
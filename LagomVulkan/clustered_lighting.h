@@ -0,0 +1,78 @@
+#pragma once
+#include "platform.h"
+
+class Renderer;
+
+constexpr uint32_t CLUSTER_GRID_X = 16;
+constexpr uint32_t CLUSTER_GRID_Y = 9;
+constexpr uint32_t CLUSTER_GRID_Z = 24;
+constexpr uint32_t CLUSTER_COUNT = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+// Room in the light index list per cluster on average, single clusters may hold up to 256.
+constexpr uint32_t CLUSTER_AVERAGE_LIGHTS = 32;
+
+// Matches Light in shaders/cluster_lights.comp and shaders/clustered_lighting.glsl.
+struct ClusterLight {
+    float position[3];
+    float radius;
+    float color[4];
+};
+
+// Clustered forward lighting. The view frustum is split into a grid of
+// screen tiles and exponential depth slices, and a compute pass bins the
+// point lights (written by the CPU into a mapped buffer, world space) into
+// a compact light index list with an (offset, count) record per cluster.
+// Forward fragment shaders bind get_vulkan_descriptor_set(), find their
+// cluster with shaders/clustered_lighting.glsl and shade only its lights.
+class ClusteredLighting {
+public:
+    ClusteredLighting(Renderer* renderer, uint32_t max_lights);
+    ~ClusteredLighting();
+
+    ClusterLight* get_lights() const;
+    void set_light_count(uint32_t light_count);
+    // Column major view matrix, perspective projection parameters in radians.
+    void set_view(const float view[16], float vertical_fov, float aspect, float near_plane, float far_plane);
+
+    // Record outside of a render pass, before the passes that shade with the lists.
+    void record_binning(VkCommandBuffer command_buffer);
+
+    // Lights, clusters, light indices and the light index count at bindings 0 to 3,
+    // readable from fragment shaders.
+    const VkDescriptorSetLayout get_vulkan_descriptor_set_layout() const;
+    const VkDescriptorSet get_vulkan_descriptor_set() const;
+    const uint32_t get_max_lights() const;
+
+private:
+    void _init_buffers();
+    void _deinit_buffers();
+
+    void _init_descriptors();
+    void _deinit_descriptors();
+
+    void _init_pipeline();
+    void _deinit_pipeline();
+
+    Renderer* _renderer = nullptr;
+
+    VkDescriptorSetLayout _descriptor_set_layout = VK_NULL_HANDLE;
+    VkDescriptorPool _descriptor_pool = VK_NULL_HANDLE;
+    VkDescriptorSet _descriptor_set = VK_NULL_HANDLE;
+    VkPipelineLayout _pipeline_layout = VK_NULL_HANDLE;
+    VkPipeline _pipeline = VK_NULL_HANDLE;
+
+    uint32_t _max_lights = 0;
+    uint32_t _light_count = 0;
+    float _view[16] = {};
+    float _projection[4] = {};
+
+    VkBuffer _light_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory _light_buffer_memory = VK_NULL_HANDLE;
+    ClusterLight* _lights = nullptr;
+
+    VkBuffer _cluster_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory _cluster_buffer_memory = VK_NULL_HANDLE;
+    VkBuffer _light_index_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory _light_index_buffer_memory = VK_NULL_HANDLE;
+    VkBuffer _light_index_count_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory _light_index_count_buffer_memory = VK_NULL_HANDLE;
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include <assert.h>
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Bounded lock-free queue for any number of producers and consumers, each
+// cell carries a sequence number that says whose turn it is. Capacity must
+// be a power of two. Values are moved in and out, no allocation after
+// construction.
+template<typename T>
+class CommandQueue {
+public:
+    CommandQueue(size_t capacity)
+        : _cells(capacity), _mask(capacity - 1)
+    {
+        assert(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+        for (size_t i = 0; i < capacity; ++i) {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    CommandQueue(const CommandQueue&) = delete;
+    CommandQueue& operator=(const CommandQueue&) = delete;
+
+    // False when full.
+    bool try_push(T&& value)
+    {
+        size_t position = _enqueue_position.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = _cells[position & _mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+            if (difference == 0) {
+                if (_enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0) {
+                return false;
+            }
+            else {
+                position = _enqueue_position.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // False when empty.
+    bool try_pop(T& value)
+    {
+        size_t position = _dequeue_position.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = _cells[position & _mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+            if (difference == 0) {
+                if (_dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    cell.sequence.store(position + _mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0) {
+                return false;
+            }
+            else {
+                position = _dequeue_position.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::vector<Cell> _cells;
+    const size_t _mask;
+
+    // Producers and consumers on separate cache lines.
+    alignas(64) std::atomic<size_t> _enqueue_position{ 0 };
+    alignas(64) std::atomic<size_t> _dequeue_position{ 0 };
+};
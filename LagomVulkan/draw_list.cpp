@@ -0,0 +1,202 @@
+#include "draw_list.h"
+#include "uniform_ring.h"
+#include "shared.h"
+
+#include <algorithm>
+#include <cstring>
+
+uint64_t make_draw_key(uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t depth)
+{
+    assert(pipeline < (1u << DRAW_KEY_PIPELINE_BITS));
+    assert(material < (1u << DRAW_KEY_MATERIAL_BITS));
+    assert(mesh < (1u << DRAW_KEY_MESH_BITS));
+    assert(depth < (1u << DRAW_KEY_DEPTH_BITS));
+
+    uint64_t key = pipeline;
+    key = (key << DRAW_KEY_MATERIAL_BITS) | material;
+    key = (key << DRAW_KEY_MESH_BITS) | mesh;
+    key = (key << DRAW_KEY_DEPTH_BITS) | depth;
+    return key;
+}
+
+static uint32_t key_pipeline(uint64_t key)
+{
+    return (uint32_t)(key >> (DRAW_KEY_DEPTH_BITS + DRAW_KEY_MESH_BITS + DRAW_KEY_MATERIAL_BITS));
+}
+
+static uint32_t key_material(uint64_t key)
+{
+    return (uint32_t)(key >> (DRAW_KEY_DEPTH_BITS + DRAW_KEY_MESH_BITS)) & ((1u << DRAW_KEY_MATERIAL_BITS) - 1);
+}
+
+static uint32_t key_mesh(uint64_t key)
+{
+    return (uint32_t)(key >> DRAW_KEY_DEPTH_BITS) & ((1u << DRAW_KEY_MESH_BITS) - 1);
+}
+
+DrawList::DrawList(UniformRing* uniform_ring, uint32_t instance_size)
+{
+    _uniform_ring = uniform_ring;
+    _instance_size = instance_size;
+}
+
+DrawList::~DrawList()
+{
+}
+
+uint32_t DrawList::register_pipeline(VkPipeline pipeline, VkPipelineLayout layout)
+{
+    _pipelines.push_back({ pipeline, layout });
+    return (uint32_t)_pipelines.size() - 1;
+}
+
+uint32_t DrawList::register_material(VkDescriptorSet descriptor_set)
+{
+    _materials.push_back(descriptor_set);
+    return (uint32_t)_materials.size() - 1;
+}
+
+uint32_t DrawList::register_mesh(const DrawMesh & mesh)
+{
+    _meshes.push_back(mesh);
+    return (uint32_t)_meshes.size() - 1;
+}
+
+void DrawList::set_instance_descriptor_set(VkDescriptorSet descriptor_set)
+{
+    _instance_descriptor_set = descriptor_set;
+}
+
+void DrawList::clear()
+{
+    _items.clear();
+    _instance_data.clear();
+    _batches.clear();
+}
+
+void DrawList::submit(uint64_t key, const void * instance_data)
+{
+    uint32_t instance_index = (uint32_t)_items.size();
+    _items.push_back({ key, instance_index });
+
+    size_t offset = _instance_data.size();
+    _instance_data.resize(offset + _instance_size);
+    std::memcpy(_instance_data.data() + offset, instance_data, _instance_size);
+}
+
+void DrawList::build()
+{
+    _batches.clear();
+    if (_items.empty()) {
+        return;
+    }
+
+    _radix_sort();
+
+    // Instance data goes to the ring in sorted order so every batch reads a contiguous range.
+    unsigned char* instances = (unsigned char*)_uniform_ring->allocate(
+        (VkDeviceSize)_items.size() * _instance_size, &_instance_dynamic_offset);
+    if (instances == nullptr) {
+        return;
+    }
+
+    DrawBatch batch{};
+    batch.key = _items[0].key;
+    for (uint32_t i = 0; i < (uint32_t)_items.size(); ++i) {
+        const DrawItem& item = _items[i];
+        std::memcpy(instances + (size_t)i * _instance_size, _instance_data.data() + (size_t)item.instance_index * _instance_size, _instance_size);
+
+        if ((item.key >> DRAW_KEY_DEPTH_BITS) != (batch.key >> DRAW_KEY_DEPTH_BITS)) {
+            _batches.push_back(batch);
+            batch.key = item.key;
+            batch.first_instance = i;
+            batch.instance_count = 0;
+        }
+        ++batch.instance_count;
+    }
+    _batches.push_back(batch);
+}
+
+void DrawList::record(VkCommandBuffer command_buffer) const
+{
+    uint32_t bound_pipeline = UINT32_MAX;
+    uint32_t bound_material = UINT32_MAX;
+    uint32_t bound_mesh = UINT32_MAX;
+
+    for (const DrawBatch& batch : _batches) {
+        uint32_t pipeline_id = key_pipeline(batch.key);
+        uint32_t material_id = key_material(batch.key);
+        uint32_t mesh_id = key_mesh(batch.key);
+        const DrawPipeline& pipeline = _pipelines[pipeline_id];
+
+        if (pipeline_id != bound_pipeline) {
+            vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline);
+            if (_instance_descriptor_set != VK_NULL_HANDLE) {
+                vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.layout,
+                    0, 1, &_instance_descriptor_set, 1, &_instance_dynamic_offset);
+            }
+            bound_pipeline = pipeline_id;
+            bound_material = UINT32_MAX;
+        }
+        if (material_id != bound_material) {
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.layout,
+                1, 1, &_materials[material_id], 0, nullptr);
+            bound_material = material_id;
+        }
+        if (mesh_id != bound_mesh) {
+            const DrawMesh& mesh = _meshes[mesh_id];
+            VkDeviceSize vertex_offset = 0;
+            vkCmdBindVertexBuffers(command_buffer, 0, 1, &mesh.vertex_buffer, &vertex_offset);
+            vkCmdBindIndexBuffer(command_buffer, mesh.index_buffer, 0, mesh.index_type);
+            bound_mesh = mesh_id;
+        }
+
+        const DrawMesh& mesh = _meshes[mesh_id];
+        vkCmdDrawIndexed(command_buffer, mesh.index_count, batch.instance_count, mesh.first_index, mesh.vertex_offset, batch.first_instance);
+    }
+}
+
+const std::vector<DrawBatch>& DrawList::get_batches() const
+{
+    return _batches;
+}
+
+void DrawList::_radix_sort()
+{
+    const size_t count = _items.size();
+    _sort_scratch.resize(count);
+
+    // Histogram all eight key bytes in a single pass.
+    uint32_t histograms[8][256] = {};
+    for (const DrawItem& item : _items) {
+        for (uint32_t byte = 0; byte < 8; ++byte) {
+            ++histograms[byte][(item.key >> (byte * 8)) & 0xff];
+        }
+    }
+
+    DrawItem* source = _items.data();
+    DrawItem* destination = _sort_scratch.data();
+    for (uint32_t byte = 0; byte < 8; ++byte) {
+        uint32_t* histogram = histograms[byte];
+
+        // Every key has the same value in this byte, the pass would not move anything.
+        if (histogram[(source[0].key >> (byte * 8)) & 0xff] == count) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t bucket_count = histogram[i];
+            histogram[i] = offset;
+            offset += bucket_count;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            destination[histogram[(source[i].key >> (byte * 8)) & 0xff]++] = source[i];
+        }
+        std::swap(source, destination);
+    }
+
+    if (source != _items.data()) {
+        _items.swap(_sort_scratch);
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "platform.h"
+
+#include <vector>
+
+class UniformRing;
+
+// Draw sort key, most significant bits first:
+// [63..56] pipeline, [55..40] material, [39..24] mesh, [23..0] depth.
+// Draws that only differ in depth are merged into one instanced draw.
+constexpr uint32_t DRAW_KEY_DEPTH_BITS = 24;
+constexpr uint32_t DRAW_KEY_MESH_BITS = 16;
+constexpr uint32_t DRAW_KEY_MATERIAL_BITS = 16;
+constexpr uint32_t DRAW_KEY_PIPELINE_BITS = 8;
+
+uint64_t make_draw_key(uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t depth);
+
+struct DrawMesh {
+    VkBuffer vertex_buffer = VK_NULL_HANDLE;
+    VkBuffer index_buffer = VK_NULL_HANDLE;
+    VkIndexType index_type = VK_INDEX_TYPE_UINT16;
+    uint32_t index_count = 0;
+    uint32_t first_index = 0;
+    int32_t vertex_offset = 0;
+};
+
+struct DrawBatch {
+    uint64_t key = 0;
+    uint32_t first_instance = 0;
+    uint32_t instance_count = 0;
+};
+
+// Collects draws for a frame, radix sorts them on their keys and merges
+// runs with the same pipeline, material and mesh into instanced draws.
+// Per-instance data is written in sorted order into the uniform ring and
+// read in the vertex shader through gl_InstanceIndex from descriptor
+// set 0 (a dynamic storage buffer over the ring). Materials are set 1.
+class DrawList {
+public:
+    DrawList(UniformRing* uniform_ring, uint32_t instance_size);
+    ~DrawList();
+
+    uint32_t register_pipeline(VkPipeline pipeline, VkPipelineLayout layout);
+    uint32_t register_material(VkDescriptorSet descriptor_set);
+    uint32_t register_mesh(const DrawMesh& mesh);
+    void set_instance_descriptor_set(VkDescriptorSet descriptor_set);
+
+    void clear();
+    void submit(uint64_t key, const void* instance_data);
+
+    // Sort, batch and upload instance data. Call once per frame after all submits.
+    void build();
+    void record(VkCommandBuffer command_buffer) const;
+
+    const std::vector<DrawBatch>& get_batches() const;
+
+private:
+    struct DrawItem {
+        uint64_t key;
+        uint32_t instance_index;
+    };
+
+    struct DrawPipeline {
+        VkPipeline pipeline;
+        VkPipelineLayout layout;
+    };
+
+    void _radix_sort();
+
+    UniformRing* _uniform_ring = nullptr;
+    uint32_t _instance_size = 0;
+
+    std::vector<DrawPipeline> _pipelines;
+    std::vector<VkDescriptorSet> _materials;
+    std::vector<DrawMesh> _meshes;
+    VkDescriptorSet _instance_descriptor_set = VK_NULL_HANDLE;
+
+    std::vector<DrawItem> _items;
+    std::vector<DrawItem> _sort_scratch;
+    std::vector<unsigned char> _instance_data;
+    std::vector<DrawBatch> _batches;
+    uint32_t _instance_dynamic_offset = 0;
+};
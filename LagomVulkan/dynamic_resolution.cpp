@@ -0,0 +1,346 @@
+#include "dynamic_resolution.h"
+#include "renderer.h"
+#include "window.h"
+#include "shared.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+// How far the scale moves towards its ideal value each frame.
+constexpr float SCALE_RESPONSE = 0.25f;
+
+static void create_attachment_image(
+    Renderer* renderer,
+    VkExtent2D size,
+    VkFormat format,
+    VkImageUsageFlags usage,
+    VkImageAspectFlags aspect,
+    VkImage* image,
+    VkDeviceMemory* memory,
+    VkImageView* view)
+{
+    VkDevice device = renderer->get_vulkan_device();
+
+    VkImageCreateInfo image_create_info{};
+    image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_create_info.imageType = VK_IMAGE_TYPE_2D;
+    image_create_info.format = format;
+    image_create_info.extent.width = size.width;
+    image_create_info.extent.height = size.height;
+    image_create_info.extent.depth = 1;
+    image_create_info.mipLevels = 1;
+    image_create_info.arrayLayers = 1;
+    image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_create_info.usage = usage;
+    image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    error_check(vkCreateImage(device, &image_create_info, nullptr, image));
+
+    VkMemoryRequirements image_memory_requirements{};
+    vkGetImageMemoryRequirements(device, *image, &image_memory_requirements);
+    VkMemoryAllocateInfo memory_allocate_info{};
+    memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    memory_allocate_info.allocationSize = image_memory_requirements.size;
+    memory_allocate_info.memoryTypeIndex = find_memory_type_index(&renderer->get_vulkan_physical_device_memory_properties(), &image_memory_requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    error_check(vkAllocateMemory(device, &memory_allocate_info, nullptr, memory));
+    error_check(vkBindImageMemory(device, *image, *memory, 0));
+
+    VkImageViewCreateInfo image_view_create_info{};
+    image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    image_view_create_info.image = *image;
+    image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    image_view_create_info.format = format;
+    image_view_create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+    image_view_create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+    image_view_create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+    image_view_create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    image_view_create_info.subresourceRange.aspectMask = aspect;
+    image_view_create_info.subresourceRange.baseMipLevel = 0;
+    image_view_create_info.subresourceRange.levelCount = 1;
+    image_view_create_info.subresourceRange.baseArrayLayer = 0;
+    image_view_create_info.subresourceRange.layerCount = 1;
+    error_check(vkCreateImageView(device, &image_view_create_info, nullptr, view));
+}
+
+DynamicResolution::DynamicResolution(Renderer* renderer, Window* window, float target_frame_ms, float min_scale)
+{
+    _renderer = renderer;
+    _window = window;
+    _target_frame_ms = target_frame_ms;
+    _min_scale = std::min(std::max(min_scale, 0.1f), 1.0f);
+
+    _size = _window->get_vulkan_surface_size();
+    _color_format = _window->get_vulkan_surface_format().format;
+    _depth_format = _window->get_vulkan_depth_stencil_format();
+    _render_area.extent = _size;
+
+    VkFormatProperties format_properties{};
+    vkGetPhysicalDeviceFormatProperties(_renderer->get_vulkan_physical_device(), _color_format, &format_properties);
+    VkFormatFeatureFlags required_features = VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    if ((format_properties.optimalTilingFeatures & required_features) != required_features) {
+        assert(0 && "Surface format can't be used for a scaled blit");
+        std::exit(-1);
+    }
+
+    _init_images();
+    _init_render_pass();
+    _init_framebuffer();
+    _init_queries();
+}
+
+DynamicResolution::~DynamicResolution()
+{
+    _deinit_queries();
+    _deinit_framebuffer();
+    _deinit_render_pass();
+    _deinit_images();
+}
+
+void DynamicResolution::begin_frame(VkCommandBuffer command_buffer)
+{
+    if (!_timestamps_supported) {
+        return;
+    }
+
+    if (_queries_written) {
+        // Last frame has already been waited on, don't stall if the results are not there anyway.
+        std::array<uint64_t, 2> timestamps{};
+        VkResult result = vkGetQueryPoolResults(_renderer->get_vulkan_device(), _query_pool, 0, 2,
+            sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+        if (result == VK_SUCCESS && timestamps[1] > timestamps[0]) {
+            float period = _renderer->get_vulkan_physical_device_properties().limits.timestampPeriod;
+            _gpu_frame_ms = (float)((double)(timestamps[1] - timestamps[0]) * period / 1000000.0);
+            _update_scale();
+        }
+    }
+
+    vkCmdResetQueryPool(command_buffer, _query_pool, 0, 2);
+    vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, _query_pool, 0);
+}
+
+void DynamicResolution::end_frame(VkCommandBuffer command_buffer)
+{
+    VkImage swapchain_image = _window->get_vulkan_active_swapchain_image();
+
+    VkImageMemoryBarrier to_transfer{};
+    to_transfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    to_transfer.srcAccessMask = 0;
+    to_transfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    to_transfer.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    to_transfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    to_transfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    to_transfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    to_transfer.image = swapchain_image;
+    to_transfer.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    to_transfer.subresourceRange.levelCount = 1;
+    to_transfer.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(command_buffer,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &to_transfer);
+
+    VkImageBlit blit{};
+    blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    blit.srcSubresource.layerCount = 1;
+    blit.srcOffsets[1].x = (int32_t)_render_area.extent.width;
+    blit.srcOffsets[1].y = (int32_t)_render_area.extent.height;
+    blit.srcOffsets[1].z = 1;
+    blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    blit.dstSubresource.layerCount = 1;
+    blit.dstOffsets[1].x = (int32_t)_size.width;
+    blit.dstOffsets[1].y = (int32_t)_size.height;
+    blit.dstOffsets[1].z = 1;
+    vkCmdBlitImage(command_buffer,
+        _color_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        swapchain_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        1, &blit, VK_FILTER_LINEAR);
+
+    VkImageMemoryBarrier to_present = to_transfer;
+    to_present.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    to_present.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+    to_present.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    to_present.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    vkCmdPipelineBarrier(command_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &to_present);
+
+    if (_timestamps_supported) {
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _query_pool, 1);
+        _queries_written = true;
+    }
+}
+
+const VkRenderPass DynamicResolution::get_vulkan_render_pass() const
+{
+    return _render_pass;
+}
+
+const VkFramebuffer DynamicResolution::get_vulkan_framebuffer() const
+{
+    return _framebuffer;
+}
+
+const VkRect2D DynamicResolution::get_render_area() const
+{
+    return _render_area;
+}
+
+const float DynamicResolution::get_scale() const
+{
+    return _scale;
+}
+
+const float DynamicResolution::get_gpu_frame_ms() const
+{
+    return _gpu_frame_ms;
+}
+
+void DynamicResolution::_update_scale()
+{
+    if (_gpu_frame_ms <= 0.0f) {
+        return;
+    }
+
+    // GPU time is roughly proportional to the pixel count, which goes with the square of the scale.
+    float ideal_scale = _scale * std::sqrt(_target_frame_ms / _gpu_frame_ms);
+    _scale += (ideal_scale - _scale) * SCALE_RESPONSE;
+    _scale = std::min(std::max(_scale, _min_scale), 1.0f);
+
+    _render_area.extent.width = std::max(1u, (uint32_t)(_size.width * _scale));
+    _render_area.extent.height = std::max(1u, (uint32_t)(_size.height * _scale));
+}
+
+void DynamicResolution::_init_images()
+{
+    create_attachment_image(_renderer, _size, _color_format,
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+        VK_IMAGE_ASPECT_COLOR_BIT,
+        &_color_image, &_color_image_memory, &_color_image_view);
+
+    bool stencil_available =
+        (_depth_format == VK_FORMAT_D32_SFLOAT_S8_UINT) ||
+        (_depth_format == VK_FORMAT_D24_UNORM_S8_UINT) ||
+        (_depth_format == VK_FORMAT_D16_UNORM_S8_UINT);
+    create_attachment_image(_renderer, _size, _depth_format,
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+        VK_IMAGE_ASPECT_DEPTH_BIT | (stencil_available ? VK_IMAGE_ASPECT_STENCIL_BIT : 0),
+        &_depth_image, &_depth_image_memory, &_depth_image_view);
+}
+
+void DynamicResolution::_deinit_images()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+    vkDestroyImageView(device, _depth_image_view, nullptr);
+    vkFreeMemory(device, _depth_image_memory, nullptr);
+    vkDestroyImage(device, _depth_image, nullptr);
+    vkDestroyImageView(device, _color_image_view, nullptr);
+    vkFreeMemory(device, _color_image_memory, nullptr);
+    vkDestroyImage(device, _color_image, nullptr);
+}
+
+void DynamicResolution::_init_render_pass()
+{
+    // Same attachment order as the window's render pass so clear values can be shared.
+    std::array<VkAttachmentDescription, 2> attachments{};
+    attachments[0].format = _depth_format;
+    attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachments[0].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    attachments[1].format = _color_format;
+    attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachments[1].finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+    VkAttachmentReference depth_attachment{};
+    depth_attachment.attachment = 0;
+    depth_attachment.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference color_attachment{};
+    color_attachment.attachment = 1;
+    color_attachment.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkSubpassDescription sub_pass{};
+    sub_pass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    sub_pass.colorAttachmentCount = 1;
+    sub_pass.pColorAttachments = &color_attachment;
+    sub_pass.pDepthStencilAttachment = &depth_attachment;
+
+    // The upscale blit reads the color attachment after the pass.
+    VkSubpassDependency blit_dependency{};
+    blit_dependency.srcSubpass = 0;
+    blit_dependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+    blit_dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    blit_dependency.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    blit_dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    blit_dependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    VkRenderPassCreateInfo render_pass_create_info{};
+    render_pass_create_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    render_pass_create_info.attachmentCount = (uint32_t)attachments.size();
+    render_pass_create_info.pAttachments = attachments.data();
+    render_pass_create_info.subpassCount = 1;
+    render_pass_create_info.pSubpasses = &sub_pass;
+    render_pass_create_info.dependencyCount = 1;
+    render_pass_create_info.pDependencies = &blit_dependency;
+
+    error_check(vkCreateRenderPass(_renderer->get_vulkan_device(), &render_pass_create_info, nullptr, &_render_pass));
+}
+
+void DynamicResolution::_deinit_render_pass()
+{
+    vkDestroyRenderPass(_renderer->get_vulkan_device(), _render_pass, nullptr);
+}
+
+void DynamicResolution::_init_framebuffer()
+{
+    std::array<VkImageView, 2> attachments{};
+    attachments[0] = _depth_image_view;
+    attachments[1] = _color_image_view;
+
+    VkFramebufferCreateInfo framebuffer_create_info{};
+    framebuffer_create_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebuffer_create_info.renderPass = _render_pass;
+    framebuffer_create_info.attachmentCount = (uint32_t)attachments.size();
+    framebuffer_create_info.pAttachments = attachments.data();
+    framebuffer_create_info.width = _size.width;
+    framebuffer_create_info.height = _size.height;
+    framebuffer_create_info.layers = 1;
+    error_check(vkCreateFramebuffer(_renderer->get_vulkan_device(), &framebuffer_create_info, nullptr, &_framebuffer));
+}
+
+void DynamicResolution::_deinit_framebuffer()
+{
+    vkDestroyFramebuffer(_renderer->get_vulkan_device(), _framebuffer, nullptr);
+}
+
+void DynamicResolution::_init_queries()
+{
+    _timestamps_supported = _renderer->get_vulkan_physical_device_properties().limits.timestampComputeAndGraphics == VK_TRUE;
+    if (!_timestamps_supported) {
+        std::cout << "Dynamic resolution: timestamps not supported, render scale stays at 1." << std::endl;
+        return;
+    }
+
+    VkQueryPoolCreateInfo query_pool_create_info{};
+    query_pool_create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    query_pool_create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    query_pool_create_info.queryCount = 2;
+    error_check(vkCreateQueryPool(_renderer->get_vulkan_device(), &query_pool_create_info, nullptr, &_query_pool));
+}
+
+void DynamicResolution::_deinit_queries()
+{
+    if (_query_pool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(_renderer->get_vulkan_device(), _query_pool, nullptr);
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "platform.h"
+
+class Renderer;
+class Window;
+
+// Offscreen scene target whose used area is scaled every frame from the
+// measured GPU frame time, then upscaled into the swapchain image with a
+// linear blit. The target is allocated once at full window size so scale
+// changes never reallocate anything. Requires BUILD_ENABLE_DYNAMIC_RESOLUTION
+// so swapchain images can be blit destinations. The window's depth buffer is
+// not written while it is in use, so HiZPyramid (which builds from it) can't
+// be combined with it and exits on construction.
+class DynamicResolution {
+public:
+    DynamicResolution(Renderer* renderer, Window* window, float target_frame_ms, float min_scale);
+    ~DynamicResolution();
+
+    // Record first in the frame, reads back last frame's GPU time and picks this frame's scale.
+    void begin_frame(VkCommandBuffer command_buffer);
+    // Record after the scene render pass, upscales into the window's active swapchain image.
+    void end_frame(VkCommandBuffer command_buffer);
+
+    const VkRenderPass get_vulkan_render_pass() const;
+    const VkFramebuffer get_vulkan_framebuffer() const;
+    // Scaled area to render into, also the viewport and scissor for the scene.
+    const VkRect2D get_render_area() const;
+    const float get_scale() const;
+    const float get_gpu_frame_ms() const;
+
+private:
+    void _init_images();
+    void _deinit_images();
+
+    void _init_render_pass();
+    void _deinit_render_pass();
+
+    void _init_framebuffer();
+    void _deinit_framebuffer();
+
+    void _init_queries();
+    void _deinit_queries();
+
+    void _update_scale();
+
+    Renderer* _renderer = nullptr;
+    Window* _window = nullptr;
+
+    VkExtent2D _size = {};
+    VkFormat _color_format = VK_FORMAT_UNDEFINED;
+    VkFormat _depth_format = VK_FORMAT_UNDEFINED;
+
+    VkImage _color_image = VK_NULL_HANDLE;
+    VkDeviceMemory _color_image_memory = VK_NULL_HANDLE;
+    VkImageView _color_image_view = VK_NULL_HANDLE;
+    VkImage _depth_image = VK_NULL_HANDLE;
+    VkDeviceMemory _depth_image_memory = VK_NULL_HANDLE;
+    VkImageView _depth_image_view = VK_NULL_HANDLE;
+
+    VkRenderPass _render_pass = VK_NULL_HANDLE;
+    VkFramebuffer _framebuffer = VK_NULL_HANDLE;
+
+    VkQueryPool _query_pool = VK_NULL_HANDLE;
+    bool _timestamps_supported = false;
+    bool _queries_written = false;
+
+    float _target_frame_ms = 16.0f;
+    float _min_scale = 0.5f;
+    float _scale = 1.0f;
+    float _gpu_frame_ms = 0.0f;
+    VkRect2D _render_area = {};
+};
@@ -0,0 +1,290 @@
+#include "entity_world.h"
+#include "job_system.h"
+
+#include <cassert>
+#include <cstring>
+
+constexpr uint32_t NO_ARCHETYPE = UINT32_MAX;
+// Columns start on 16 bytes so SIMD loops can use aligned loads.
+constexpr uint32_t COLUMN_ALIGNMENT = 16;
+
+static uint32_t align_column(uint32_t offset)
+{
+    return (offset + COLUMN_ALIGNMENT - 1) & ~(COLUMN_ALIGNMENT - 1);
+}
+
+const Entity* EntityChunk::get_entities() const
+{
+    // The entity column is always first.
+    return (const Entity*)data;
+}
+
+void* EntityChunk::get_column(uint32_t component) const
+{
+    uint32_t offset = archetype->offsets[component];
+    return offset != ENTITY_NO_COLUMN ? data + offset : nullptr;
+}
+
+EntityWorld::EntityWorld()
+{
+}
+
+EntityWorld::~EntityWorld()
+{
+}
+
+uint32_t EntityWorld::register_component(uint32_t size)
+{
+    assert(_component_sizes.size() < ENTITY_MAX_COMPONENTS && "Too many components");
+    _component_sizes.push_back(size);
+    return (uint32_t)_component_sizes.size() - 1;
+}
+
+Entity EntityWorld::create_entity(uint64_t signature)
+{
+    uint32_t slot = 0;
+    if (!_free_slots.empty()) {
+        slot = _free_slots.back();
+        _free_slots.pop_back();
+    }
+    else {
+        slot = (uint32_t)_records.size();
+        _records.push_back({ NO_ARCHETYPE, 0, 0, 1 });
+    }
+
+    EntityRecord& record = _records[slot];
+    Entity entity = ((uint64_t)record.generation << 32) | slot;
+    record.archetype = _find_archetype(signature);
+    _allocate_row(record.archetype, &record.chunk, &record.row);
+    EntityChunk* chunk = _archetypes[record.archetype]->chunks[record.chunk].get();
+    ((Entity*)chunk->data)[record.row] = entity;
+    ++_entity_count;
+    return entity;
+}
+
+void EntityWorld::destroy_entity(Entity entity)
+{
+    const EntityRecord* found = _find_record(entity);
+    if (found == nullptr) {
+        return;
+    }
+    uint32_t slot = (uint32_t)entity;
+    EntityRecord record = *found;
+    _remove_row(record.archetype, record.chunk, record.row);
+
+    _records[slot].archetype = NO_ARCHETYPE;
+    // Stale handles stop matching, generation 0 is skipped so NO_ENTITY stays invalid.
+    _records[slot].generation = _records[slot].generation + 1 != 0 ? _records[slot].generation + 1 : 1;
+    _free_slots.push_back(slot);
+    --_entity_count;
+}
+
+bool EntityWorld::is_alive(Entity entity) const
+{
+    return _find_record(entity) != nullptr;
+}
+
+void EntityWorld::add_component(Entity entity, uint32_t component)
+{
+    const EntityRecord* record = _find_record(entity);
+    if (record != nullptr) {
+        _change_signature(entity, _archetypes[record->archetype]->signature | component_bit(component));
+    }
+}
+
+void EntityWorld::remove_component(Entity entity, uint32_t component)
+{
+    const EntityRecord* record = _find_record(entity);
+    if (record != nullptr) {
+        _change_signature(entity, _archetypes[record->archetype]->signature & ~component_bit(component));
+    }
+}
+
+void* EntityWorld::get_component(Entity entity, uint32_t component) const
+{
+    const EntityRecord* record = _find_record(entity);
+    if (record == nullptr) {
+        return nullptr;
+    }
+    EntityChunk* chunk = _archetypes[record->archetype]->chunks[record->chunk].get();
+    uint8_t* column = (uint8_t*)chunk->get_column(component);
+    return column != nullptr ? column + (size_t)record->row * _component_sizes[component] : nullptr;
+}
+
+void EntityWorld::for_each_chunk(uint64_t required, const std::function<void(EntityChunk&)>& function)
+{
+    for (auto& archetype : _archetypes) {
+        if ((archetype->signature & required) != required) {
+            continue;
+        }
+        for (auto& chunk : archetype->chunks) {
+            function(*chunk);
+        }
+    }
+}
+
+void EntityWorld::parallel_for_each_chunk(JobSystem* jobs, uint64_t required, const std::function<void(EntityChunk&)>& function)
+{
+    if (jobs == nullptr) {
+        for_each_chunk(required, function);
+        return;
+    }
+
+    std::vector<EntityChunk*> matching;
+    for (auto& archetype : _archetypes) {
+        if ((archetype->signature & required) != required) {
+            continue;
+        }
+        for (auto& chunk : archetype->chunks) {
+            matching.push_back(chunk.get());
+        }
+    }
+    // A chunk is already a few thousand components, one per job keeps the load even.
+    jobs->parallel_for((uint32_t)matching.size(), 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            function(*matching[i]);
+        }
+    });
+}
+
+uint32_t EntityWorld::get_entity_count() const
+{
+    return _entity_count;
+}
+
+uint32_t EntityWorld::get_archetype_count() const
+{
+    return (uint32_t)_archetypes.size();
+}
+
+uint32_t EntityWorld::_find_archetype(uint64_t signature)
+{
+    auto found = _archetype_of.find(signature);
+    if (found != _archetype_of.end()) {
+        return found->second;
+    }
+
+    std::unique_ptr<EntityArchetype> archetype(new EntityArchetype());
+    archetype->signature = signature;
+    for (auto& offset : archetype->offsets) {
+        offset = ENTITY_NO_COLUMN;
+    }
+
+    // Largest capacity whose aligned columns still fit in a chunk.
+    uint32_t row_size = sizeof(Entity);
+    for (uint32_t component = 0; component < (uint32_t)_component_sizes.size(); ++component) {
+        if (signature & component_bit(component)) {
+            row_size += _component_sizes[component];
+        }
+    }
+    uint32_t capacity = ENTITY_CHUNK_SIZE / row_size;
+    for (; capacity > 0; --capacity) {
+        uint32_t offset = align_column(capacity * (uint32_t)sizeof(Entity));
+        for (uint32_t component = 0; component < (uint32_t)_component_sizes.size(); ++component) {
+            if (signature & component_bit(component)) {
+                archetype->offsets[component] = offset;
+                offset = align_column(offset + capacity * _component_sizes[component]);
+            }
+        }
+        if (offset <= ENTITY_CHUNK_SIZE) {
+            break;
+        }
+    }
+    assert(capacity > 0 && "Components too large for a chunk");
+    archetype->capacity = capacity;
+
+    uint32_t index = (uint32_t)_archetypes.size();
+    _archetypes.push_back(std::move(archetype));
+    _archetype_of[signature] = index;
+    return index;
+}
+
+void EntityWorld::_allocate_row(uint32_t archetype_index, uint32_t* chunk_index, uint32_t* row)
+{
+    EntityArchetype* archetype = _archetypes[archetype_index].get();
+    if (archetype->chunks.empty() || archetype->chunks.back()->count == archetype->capacity) {
+        std::unique_ptr<EntityChunk> chunk(new EntityChunk());
+        chunk->archetype = archetype;
+        // new only guarantees 8 bytes on 32-bit Windows, align by hand.
+        chunk->storage.reset(new uint8_t[ENTITY_CHUNK_SIZE + COLUMN_ALIGNMENT - 1]);
+        uintptr_t address = (uintptr_t)chunk->storage.get();
+        chunk->data = (uint8_t*)((address + COLUMN_ALIGNMENT - 1) & ~(uintptr_t)(COLUMN_ALIGNMENT - 1));
+        archetype->chunks.push_back(std::move(chunk));
+    }
+
+    EntityChunk* chunk = archetype->chunks.back().get();
+    *chunk_index = (uint32_t)archetype->chunks.size() - 1;
+    *row = chunk->count++;
+    for (uint32_t component = 0; component < (uint32_t)_component_sizes.size(); ++component) {
+        uint8_t* column = (uint8_t*)chunk->get_column(component);
+        if (column != nullptr) {
+            memset(column + (size_t)*row * _component_sizes[component], 0, _component_sizes[component]);
+        }
+    }
+}
+
+void EntityWorld::_remove_row(uint32_t archetype_index, uint32_t chunk_index, uint32_t row)
+{
+    // Fill the hole with the archetype's last row to keep every chunk but the last full.
+    EntityArchetype* archetype = _archetypes[archetype_index].get();
+    EntityChunk* chunk = archetype->chunks[chunk_index].get();
+    EntityChunk* last_chunk = archetype->chunks.back().get();
+    uint32_t last_row = last_chunk->count - 1;
+    if (chunk != last_chunk || row != last_row) {
+        Entity moved = last_chunk->get_entities()[last_row];
+        ((Entity*)chunk->data)[row] = moved;
+        for (uint32_t component = 0; component < (uint32_t)_component_sizes.size(); ++component) {
+            uint8_t* column = (uint8_t*)chunk->get_column(component);
+            if (column != nullptr) {
+                uint32_t size = _component_sizes[component];
+                memcpy(column + (size_t)row * size, (uint8_t*)last_chunk->get_column(component) + (size_t)last_row * size, size);
+            }
+        }
+        EntityRecord& record = _records[(uint32_t)moved];
+        record.chunk = chunk_index;
+        record.row = row;
+    }
+    if (--last_chunk->count == 0) {
+        archetype->chunks.pop_back();
+    }
+}
+
+void EntityWorld::_change_signature(Entity entity, uint64_t signature)
+{
+    uint32_t slot = (uint32_t)entity;
+    EntityRecord old_record = _records[slot];
+    if (_archetypes[old_record.archetype]->signature == signature) {
+        return;
+    }
+
+    EntityRecord new_record = old_record;
+    new_record.archetype = _find_archetype(signature);
+    _allocate_row(new_record.archetype, &new_record.chunk, &new_record.row);
+    EntityChunk* from = _archetypes[old_record.archetype]->chunks[old_record.chunk].get();
+    EntityChunk* to = _archetypes[new_record.archetype]->chunks[new_record.chunk].get();
+    ((Entity*)to->data)[new_record.row] = entity;
+    for (uint32_t component = 0; component < (uint32_t)_component_sizes.size(); ++component) {
+        uint8_t* from_column = (uint8_t*)from->get_column(component);
+        uint8_t* to_column = (uint8_t*)to->get_column(component);
+        if (from_column != nullptr && to_column != nullptr) {
+            uint32_t size = _component_sizes[component];
+            memcpy(to_column + (size_t)new_record.row * size, from_column + (size_t)old_record.row * size, size);
+        }
+    }
+
+    _remove_row(old_record.archetype, old_record.chunk, old_record.row);
+    // Removing the old row never moves the new one, they sit in different archetypes.
+    _records[slot].archetype = new_record.archetype;
+    _records[slot].chunk = new_record.chunk;
+    _records[slot].row = new_record.row;
+}
+
+const EntityWorld::EntityRecord* EntityWorld::_find_record(Entity entity) const
+{
+    uint32_t slot = (uint32_t)entity;
+    uint32_t generation = (uint32_t)(entity >> 32);
+    if (slot >= _records.size() || _records[slot].archetype == NO_ARCHETYPE || _records[slot].generation != generation) {
+        return nullptr;
+    }
+    return &_records[slot];
+}
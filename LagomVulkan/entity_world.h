@@ -0,0 +1,118 @@
+#pragma once
+#include <stdint.h>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class JobSystem;
+
+// Entity handles are the slot in the low 32 bits and the slot's generation
+// above. Generations start at 1, so 0 is never a live entity.
+typedef uint64_t Entity;
+constexpr Entity NO_ENTITY = 0;
+
+constexpr uint32_t ENTITY_MAX_COMPONENTS = 64;
+constexpr uint32_t ENTITY_CHUNK_SIZE = 16 * 1024;
+constexpr uint32_t ENTITY_NO_COLUMN = UINT32_MAX;
+
+inline uint64_t component_bit(uint32_t component)
+{
+    return 1ull << component;
+}
+
+struct EntityArchetype;
+
+// Fixed size block holding up to the archetype's capacity of entities, one
+// packed array per component. Rows are kept dense, destroying an entity
+// moves the archetype's last row into its place.
+struct EntityChunk {
+    EntityArchetype* archetype = nullptr;
+    // ENTITY_CHUNK_SIZE bytes inside storage, 16 byte aligned on every platform.
+    std::unique_ptr<uint8_t[]> storage;
+    uint8_t* data = nullptr;
+    uint32_t count = 0;
+
+    const Entity* get_entities() const;
+    // Null when the archetype has no such component.
+    void* get_column(uint32_t component) const;
+
+    template<typename T>
+    T* get(uint32_t component) const
+    {
+        return (T*)get_column(component);
+    }
+};
+
+// Entities sharing one set of components.
+struct EntityArchetype {
+    uint64_t signature = 0;
+    uint32_t capacity = 0;
+    // Byte offset of each component's array in a chunk, ENTITY_NO_COLUMN when absent.
+    uint32_t offsets[ENTITY_MAX_COMPONENTS];
+    std::vector<std::unique_ptr<EntityChunk>> chunks;
+};
+
+// Archetype based entity storage (structure of arrays). Components are
+// plain data registered by size and copied with memcpy when an entity
+// changes archetype, new components start zeroed. Queries visit every
+// chunk whose archetype has the required components, so systems loop over
+// contiguous arrays, and parallel_for_each_chunk spreads the chunks over
+// the job system. Don't create, destroy or change entities inside a query.
+class EntityWorld {
+public:
+    EntityWorld();
+    ~EntityWorld();
+
+    EntityWorld(const EntityWorld&) = delete;
+    EntityWorld& operator=(const EntityWorld&) = delete;
+
+    // Returns the component index to build signatures from with component_bit().
+    uint32_t register_component(uint32_t size);
+
+    Entity create_entity(uint64_t signature);
+    void destroy_entity(Entity entity);
+    bool is_alive(Entity entity) const;
+
+    void add_component(Entity entity, uint32_t component);
+    void remove_component(Entity entity, uint32_t component);
+    // Null when the entity is dead or lacks the component.
+    void* get_component(Entity entity, uint32_t component) const;
+
+    template<typename T>
+    T* get(Entity entity, uint32_t component) const
+    {
+        return (T*)get_component(entity, component);
+    }
+
+    void for_each_chunk(uint64_t required, const std::function<void(EntityChunk&)>& function);
+    // Chunks run concurrently, function must only touch its own chunk's rows.
+    // jobs may be null to run on the calling thread.
+    void parallel_for_each_chunk(JobSystem* jobs, uint64_t required, const std::function<void(EntityChunk&)>& function);
+
+    uint32_t get_entity_count() const;
+    uint32_t get_archetype_count() const;
+
+private:
+    struct EntityRecord {
+        uint32_t archetype;
+        uint32_t chunk;
+        uint32_t row;
+        uint32_t generation;
+    };
+
+    uint32_t _find_archetype(uint64_t signature);
+    void _allocate_row(uint32_t archetype, uint32_t* chunk, uint32_t* row);
+    void _remove_row(uint32_t archetype, uint32_t chunk, uint32_t row);
+    void _change_signature(Entity entity, uint64_t signature);
+    const EntityRecord* _find_record(Entity entity) const;
+
+    std::vector<uint32_t> _component_sizes;
+    std::vector<std::unique_ptr<EntityArchetype>> _archetypes;
+    std::unordered_map<uint64_t, uint32_t> _archetype_of;
+
+    // Per entity slot, archetype is UINT32_MAX when the slot is free.
+    std::vector<EntityRecord> _records;
+    std::vector<uint32_t> _free_slots;
+    uint32_t _entity_count = 0;
+};
@@ -0,0 +1,441 @@
+#include "gpu_culling.h"
+#include "renderer.h"
+#include "hiz_pyramid.h"
+#include "shared.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+struct CullPushConstants {
+    float planes[6][4];
+    uint32_t object_count;
+};
+
+struct OcclusionUniforms {
+    float view_projection[16];
+    float pyramid_info[4];
+};
+
+GpuCulling::GpuCulling(Renderer* renderer, uint32_t max_objects)
+{
+    _renderer = renderer;
+    _max_objects = max_objects;
+
+    if (_renderer->is_device_extension_enabled("VK_KHR_draw_indirect_count")) {
+        _draw_indexed_indirect_count = (PFN_vkCmdDrawIndexedIndirectCountAMD)vkGetDeviceProcAddr(_renderer->get_vulkan_device(), "vkCmdDrawIndexedIndirectCountKHR");
+    }
+    else if (_renderer->is_device_extension_enabled("VK_AMD_draw_indirect_count")) {
+        _draw_indexed_indirect_count = (PFN_vkCmdDrawIndexedIndirectCountAMD)vkGetDeviceProcAddr(_renderer->get_vulkan_device(), "vkCmdDrawIndexedIndirectCountAMD");
+    }
+    _multi_draw_indirect = _renderer->get_vulkan_enabled_features().multiDrawIndirect == VK_TRUE;
+    if (_renderer->get_vulkan_enabled_features().drawIndirectFirstInstance != VK_TRUE) {
+        std::cout << "GPU culling: drawIndirectFirstInstance not supported, instance indices will be zero." << std::endl;
+    }
+
+    _init_buffers();
+    _init_descriptors();
+    _init_pipeline();
+}
+
+GpuCulling::~GpuCulling()
+{
+    _deinit_occlusion();
+    _deinit_pipeline();
+    _deinit_descriptors();
+    _deinit_buffers();
+}
+
+GpuCullObject * GpuCulling::get_objects() const
+{
+    return _objects;
+}
+
+void GpuCulling::set_object_count(uint32_t object_count)
+{
+    assert(object_count <= _max_objects);
+    _object_count = object_count;
+}
+
+void GpuCulling::set_frustum(const float view_projection[16])
+{
+    std::memcpy(_view_projection, view_projection, sizeof(_view_projection));
+
+    // Gribb/Hartmann plane extraction, clip space depth is [0, w].
+    const float* m = view_projection;
+    float rows[4][4];
+    for (int r = 0; r < 4; ++r) {
+        for (int c = 0; c < 4; ++c) {
+            rows[r][c] = m[c * 4 + r];
+        }
+    }
+    for (int c = 0; c < 4; ++c) {
+        _planes[0][c] = rows[3][c] + rows[0][c];
+        _planes[1][c] = rows[3][c] - rows[0][c];
+        _planes[2][c] = rows[3][c] + rows[1][c];
+        _planes[3][c] = rows[3][c] - rows[1][c];
+        _planes[4][c] = rows[2][c];
+        _planes[5][c] = rows[3][c] - rows[2][c];
+    }
+    for (int i = 0; i < 6; ++i) {
+        float length = std::sqrt(_planes[i][0] * _planes[i][0] + _planes[i][1] * _planes[i][1] + _planes[i][2] * _planes[i][2]);
+        if (length > 0.0f) {
+            for (int c = 0; c < 4; ++c) {
+                _planes[i][c] /= length;
+            }
+        }
+    }
+}
+
+void GpuCulling::enable_occlusion(HiZPyramid * pyramid, bool reverse_z)
+{
+    _deinit_occlusion();
+    _pyramid = pyramid;
+    _reverse_z = reverse_z;
+    if (_pyramid != nullptr) {
+        _init_occlusion();
+    }
+}
+
+void GpuCulling::record_cull(VkCommandBuffer command_buffer)
+{
+    // Reset the count, and the commands too when the draw has to read a fixed number of them.
+    vkCmdFillBuffer(command_buffer, _draw_count_buffer, 0, VK_WHOLE_SIZE, 0);
+    if (_draw_indexed_indirect_count == nullptr) {
+        vkCmdFillBuffer(command_buffer, _draw_buffer, 0, VK_WHOLE_SIZE, 0);
+    }
+
+    VkMemoryBarrier clear_barrier{};
+    clear_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    clear_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    clear_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(command_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 1, &clear_barrier, 0, nullptr, 0, nullptr);
+
+    if (_object_count > 0) {
+        CullPushConstants push_constants{};
+        std::copy(&_planes[0][0], &_planes[0][0] + 24, &push_constants.planes[0][0]);
+        push_constants.object_count = _object_count;
+
+        // There is nothing to test occlusion against until the pyramid has been built once.
+        if (_pyramid != nullptr && _pyramid->has_data()) {
+            OcclusionUniforms uniforms{};
+            std::memcpy(uniforms.view_projection, _previous_view_projection, sizeof(uniforms.view_projection));
+            uniforms.pyramid_info[0] = (float)_pyramid->get_size().width;
+            uniforms.pyramid_info[1] = (float)_pyramid->get_size().height;
+            uniforms.pyramid_info[2] = (float)_pyramid->get_level_count();
+            uniforms.pyramid_info[3] = _reverse_z ? 1.0f : 0.0f;
+            std::memcpy(_occlusion_uniforms, &uniforms, sizeof(uniforms));
+
+            std::array<VkDescriptorSet, 2> descriptor_sets = { _descriptor_set, _occlusion_descriptor_set };
+            vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, _occlusion_pipeline);
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, _occlusion_pipeline_layout, 0, (uint32_t)descriptor_sets.size(), descriptor_sets.data(), 0, nullptr);
+            vkCmdPushConstants(command_buffer, _occlusion_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push_constants), &push_constants);
+        }
+        else {
+            vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline);
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline_layout, 0, 1, &_descriptor_set, 0, nullptr);
+            vkCmdPushConstants(command_buffer, _pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push_constants), &push_constants);
+        }
+        vkCmdDispatch(command_buffer, (_object_count + 63) / 64, 1, 1);
+    }
+    // This frame's depth will be in next frame's pyramid.
+    std::memcpy(_previous_view_projection, _view_projection, sizeof(_previous_view_projection));
+
+    VkMemoryBarrier draw_barrier{};
+    draw_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    draw_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    draw_barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+        0, 1, &draw_barrier, 0, nullptr, 0, nullptr);
+}
+
+void GpuCulling::record_draw(VkCommandBuffer command_buffer) const
+{
+    const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    if (_draw_indexed_indirect_count != nullptr) {
+        _draw_indexed_indirect_count(command_buffer, _draw_buffer, 0, _draw_count_buffer, 0, _max_objects, stride);
+    }
+    else if (_multi_draw_indirect) {
+        // Culled slots past the count were cleared to zero instances.
+        vkCmdDrawIndexedIndirect(command_buffer, _draw_buffer, 0, _object_count, stride);
+    }
+    else {
+        for (uint32_t i = 0; i < _object_count; ++i) {
+            vkCmdDrawIndexedIndirect(command_buffer, _draw_buffer, (VkDeviceSize)i * stride, 1, stride);
+        }
+    }
+}
+
+const VkBuffer GpuCulling::get_vulkan_draw_buffer() const
+{
+    return _draw_buffer;
+}
+
+const VkBuffer GpuCulling::get_vulkan_draw_count_buffer() const
+{
+    return _draw_count_buffer;
+}
+
+const uint32_t GpuCulling::get_max_objects() const
+{
+    return _max_objects;
+}
+
+void GpuCulling::_init_buffers()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+    const VkPhysicalDeviceMemoryProperties* memory_properties = &_renderer->get_vulkan_physical_device_memory_properties();
+
+    create_buffer(device, memory_properties,
+        sizeof(GpuCullObject) * _max_objects,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        &_object_buffer, &_object_buffer_memory);
+    void* mapped = nullptr;
+    error_check(vkMapMemory(device, _object_buffer_memory, 0, VK_WHOLE_SIZE, 0, &mapped));
+    _objects = (GpuCullObject*)mapped;
+
+    create_buffer(device, memory_properties,
+        sizeof(VkDrawIndexedIndirectCommand) * _max_objects,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        &_draw_buffer, &_draw_buffer_memory);
+
+    create_buffer(device, memory_properties,
+        sizeof(uint32_t),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        &_draw_count_buffer, &_draw_count_buffer_memory);
+}
+
+void GpuCulling::_deinit_buffers()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+    vkUnmapMemory(device, _object_buffer_memory);
+    vkDestroyBuffer(device, _object_buffer, nullptr);
+    vkFreeMemory(device, _object_buffer_memory, nullptr);
+    vkDestroyBuffer(device, _draw_buffer, nullptr);
+    vkFreeMemory(device, _draw_buffer_memory, nullptr);
+    vkDestroyBuffer(device, _draw_count_buffer, nullptr);
+    vkFreeMemory(device, _draw_count_buffer_memory, nullptr);
+    _objects = nullptr;
+}
+
+void GpuCulling::_init_descriptors()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+
+    std::array<VkDescriptorSetLayoutBinding, 3> bindings{};
+    for (uint32_t i = 0; i < bindings.size(); ++i) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info{};
+    descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptor_set_layout_create_info.bindingCount = (uint32_t)bindings.size();
+    descriptor_set_layout_create_info.pBindings = bindings.data();
+    error_check(vkCreateDescriptorSetLayout(device, &descriptor_set_layout_create_info, nullptr, &_descriptor_set_layout));
+
+    VkDescriptorPoolSize pool_size{};
+    pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    pool_size.descriptorCount = (uint32_t)bindings.size();
+
+    VkDescriptorPoolCreateInfo descriptor_pool_create_info{};
+    descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptor_pool_create_info.maxSets = 1;
+    descriptor_pool_create_info.poolSizeCount = 1;
+    descriptor_pool_create_info.pPoolSizes = &pool_size;
+    error_check(vkCreateDescriptorPool(device, &descriptor_pool_create_info, nullptr, &_descriptor_pool));
+
+    VkDescriptorSetAllocateInfo descriptor_set_allocate_info{};
+    descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descriptor_set_allocate_info.descriptorPool = _descriptor_pool;
+    descriptor_set_allocate_info.descriptorSetCount = 1;
+    descriptor_set_allocate_info.pSetLayouts = &_descriptor_set_layout;
+    error_check(vkAllocateDescriptorSets(device, &descriptor_set_allocate_info, &_descriptor_set));
+
+    std::array<VkDescriptorBufferInfo, 3> buffer_infos{};
+    buffer_infos[0].buffer = _object_buffer;
+    buffer_infos[0].range = VK_WHOLE_SIZE;
+    buffer_infos[1].buffer = _draw_buffer;
+    buffer_infos[1].range = VK_WHOLE_SIZE;
+    buffer_infos[2].buffer = _draw_count_buffer;
+    buffer_infos[2].range = VK_WHOLE_SIZE;
+
+    std::array<VkWriteDescriptorSet, 3> writes{};
+    for (uint32_t i = 0; i < writes.size(); ++i) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = _descriptor_set;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].pBufferInfo = &buffer_infos[i];
+    }
+    vkUpdateDescriptorSets(device, (uint32_t)writes.size(), writes.data(), 0, nullptr);
+}
+
+void GpuCulling::_deinit_descriptors()
+{
+    vkDestroyDescriptorPool(_renderer->get_vulkan_device(), _descriptor_pool, nullptr);
+    vkDestroyDescriptorSetLayout(_renderer->get_vulkan_device(), _descriptor_set_layout, nullptr);
+}
+
+void GpuCulling::_init_pipeline()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+
+    VkPushConstantRange push_constant_range{};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(CullPushConstants);
+
+    VkPipelineLayoutCreateInfo pipeline_layout_create_info{};
+    pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_create_info.setLayoutCount = 1;
+    pipeline_layout_create_info.pSetLayouts = &_descriptor_set_layout;
+    pipeline_layout_create_info.pushConstantRangeCount = 1;
+    pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+    error_check(vkCreatePipelineLayout(device, &pipeline_layout_create_info, nullptr, &_pipeline_layout));
+
+    VkShaderModule shader_module = load_shader_module(device, "shaders/cull.comp.spv");
+
+    VkComputePipelineCreateInfo pipeline_create_info{};
+    pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_create_info.stage.module = shader_module;
+    pipeline_create_info.stage.pName = "main";
+    pipeline_create_info.layout = _pipeline_layout;
+    error_check(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeline_create_info, nullptr, &_pipeline));
+
+    vkDestroyShaderModule(device, shader_module, nullptr);
+}
+
+void GpuCulling::_deinit_pipeline()
+{
+    vkDestroyPipeline(_renderer->get_vulkan_device(), _pipeline, nullptr);
+    vkDestroyPipelineLayout(_renderer->get_vulkan_device(), _pipeline_layout, nullptr);
+}
+
+void GpuCulling::_init_occlusion()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+
+    create_buffer(device, &_renderer->get_vulkan_physical_device_memory_properties(),
+        sizeof(OcclusionUniforms),
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        &_occlusion_buffer, &_occlusion_buffer_memory);
+    error_check(vkMapMemory(device, _occlusion_buffer_memory, 0, VK_WHOLE_SIZE, 0, &_occlusion_uniforms));
+
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info{};
+    descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptor_set_layout_create_info.bindingCount = (uint32_t)bindings.size();
+    descriptor_set_layout_create_info.pBindings = bindings.data();
+    error_check(vkCreateDescriptorSetLayout(device, &descriptor_set_layout_create_info, nullptr, &_occlusion_descriptor_set_layout));
+
+    std::array<VkDescriptorPoolSize, 2> pool_sizes{};
+    pool_sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    pool_sizes[0].descriptorCount = 1;
+    pool_sizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    pool_sizes[1].descriptorCount = 1;
+
+    VkDescriptorPoolCreateInfo descriptor_pool_create_info{};
+    descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptor_pool_create_info.maxSets = 1;
+    descriptor_pool_create_info.poolSizeCount = (uint32_t)pool_sizes.size();
+    descriptor_pool_create_info.pPoolSizes = pool_sizes.data();
+    error_check(vkCreateDescriptorPool(device, &descriptor_pool_create_info, nullptr, &_occlusion_descriptor_pool));
+
+    VkDescriptorSetAllocateInfo descriptor_set_allocate_info{};
+    descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descriptor_set_allocate_info.descriptorPool = _occlusion_descriptor_pool;
+    descriptor_set_allocate_info.descriptorSetCount = 1;
+    descriptor_set_allocate_info.pSetLayouts = &_occlusion_descriptor_set_layout;
+    error_check(vkAllocateDescriptorSets(device, &descriptor_set_allocate_info, &_occlusion_descriptor_set));
+
+    VkDescriptorImageInfo pyramid_info{};
+    pyramid_info.sampler = _pyramid->get_vulkan_sampler();
+    pyramid_info.imageView = _pyramid->get_vulkan_image_view();
+    pyramid_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    VkDescriptorBufferInfo uniform_info{};
+    uniform_info.buffer = _occlusion_buffer;
+    uniform_info.range = VK_WHOLE_SIZE;
+
+    std::array<VkWriteDescriptorSet, 2> writes{};
+    writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[0].dstSet = _occlusion_descriptor_set;
+    writes[0].dstBinding = 0;
+    writes[0].descriptorCount = 1;
+    writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writes[0].pImageInfo = &pyramid_info;
+    writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[1].dstSet = _occlusion_descriptor_set;
+    writes[1].dstBinding = 1;
+    writes[1].descriptorCount = 1;
+    writes[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    writes[1].pBufferInfo = &uniform_info;
+    vkUpdateDescriptorSets(device, (uint32_t)writes.size(), writes.data(), 0, nullptr);
+
+    VkPushConstantRange push_constant_range{};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(CullPushConstants);
+
+    std::array<VkDescriptorSetLayout, 2> set_layouts = { _descriptor_set_layout, _occlusion_descriptor_set_layout };
+    VkPipelineLayoutCreateInfo pipeline_layout_create_info{};
+    pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_create_info.setLayoutCount = (uint32_t)set_layouts.size();
+    pipeline_layout_create_info.pSetLayouts = set_layouts.data();
+    pipeline_layout_create_info.pushConstantRangeCount = 1;
+    pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+    error_check(vkCreatePipelineLayout(device, &pipeline_layout_create_info, nullptr, &_occlusion_pipeline_layout));
+
+    VkShaderModule shader_module = load_shader_module(device, "shaders/cull_occlusion.comp.spv");
+
+    VkComputePipelineCreateInfo pipeline_create_info{};
+    pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_create_info.stage.module = shader_module;
+    pipeline_create_info.stage.pName = "main";
+    pipeline_create_info.layout = _occlusion_pipeline_layout;
+    error_check(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeline_create_info, nullptr, &_occlusion_pipeline));
+
+    vkDestroyShaderModule(device, shader_module, nullptr);
+}
+
+void GpuCulling::_deinit_occlusion()
+{
+    if (_pyramid == nullptr) {
+        return;
+    }
+    VkDevice device = _renderer->get_vulkan_device();
+    vkDestroyPipeline(device, _occlusion_pipeline, nullptr);
+    vkDestroyPipelineLayout(device, _occlusion_pipeline_layout, nullptr);
+    vkDestroyDescriptorPool(device, _occlusion_descriptor_pool, nullptr);
+    vkDestroyDescriptorSetLayout(device, _occlusion_descriptor_set_layout, nullptr);
+    vkUnmapMemory(device, _occlusion_buffer_memory);
+    vkDestroyBuffer(device, _occlusion_buffer, nullptr);
+    vkFreeMemory(device, _occlusion_buffer_memory, nullptr);
+    _occlusion_uniforms = nullptr;
+    _pyramid = nullptr;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include "platform.h"
+
+class Renderer;
+class HiZPyramid;
+
+// Matches CullObject in shaders/cull.comp.
+struct GpuCullObject {
+    float center[3];
+    float radius;
+    uint32_t index_count;
+    uint32_t first_index;
+    int32_t vertex_offset;
+    uint32_t instance_index;
+};
+
+// Compute based frustum culling. Objects are written by the CPU into a
+// mapped buffer, the cull pass appends a VkDrawIndexedIndirectCommand for
+// every visible object and the draw pass consumes them with a fixed number
+// of indirect draw commands. All objects share one vertex and index buffer,
+// first_instance carries the object's instance index.
+class GpuCulling {
+public:
+    GpuCulling(Renderer* renderer, uint32_t max_objects);
+    ~GpuCulling();
+
+    GpuCullObject* get_objects() const;
+    void set_object_count(uint32_t object_count);
+    // Column major view projection, Vulkan clip space.
+    void set_frustum(const float view_projection[16]);
+    // Also test against the previous frame's Hi-Z pyramid, using the view
+    // projection from the previous set_frustum call.
+    void enable_occlusion(HiZPyramid* pyramid, bool reverse_z);
+
+    // Record outside of a render pass.
+    void record_cull(VkCommandBuffer command_buffer);
+    // Record inside a render pass with the pipeline and shared mesh buffers already bound.
+    void record_draw(VkCommandBuffer command_buffer) const;
+
+    const VkBuffer get_vulkan_draw_buffer() const;
+    const VkBuffer get_vulkan_draw_count_buffer() const;
+    const uint32_t get_max_objects() const;
+
+private:
+    void _init_buffers();
+    void _deinit_buffers();
+
+    void _init_descriptors();
+    void _deinit_descriptors();
+
+    void _init_pipeline();
+    void _deinit_pipeline();
+
+    void _init_occlusion();
+    void _deinit_occlusion();
+
+    Renderer* _renderer = nullptr;
+
+    VkDescriptorSetLayout _descriptor_set_layout = VK_NULL_HANDLE;
+    VkDescriptorPool _descriptor_pool = VK_NULL_HANDLE;
+    VkDescriptorSet _descriptor_set = VK_NULL_HANDLE;
+    VkPipelineLayout _pipeline_layout = VK_NULL_HANDLE;
+    VkPipeline _pipeline = VK_NULL_HANDLE;
+
+    uint32_t _max_objects = 0;
+    uint32_t _object_count = 0;
+    float _planes[6][4] = {};
+    float _view_projection[16] = {};
+    float _previous_view_projection[16] = {};
+
+    VkBuffer _object_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory _object_buffer_memory = VK_NULL_HANDLE;
+    GpuCullObject* _objects = nullptr;
+
+    VkBuffer _draw_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory _draw_buffer_memory = VK_NULL_HANDLE;
+    VkBuffer _draw_count_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory _draw_count_buffer_memory = VK_NULL_HANDLE;
+
+    HiZPyramid* _pyramid = nullptr;
+    bool _reverse_z = false;
+    VkDescriptorSetLayout _occlusion_descriptor_set_layout = VK_NULL_HANDLE;
+    VkDescriptorPool _occlusion_descriptor_pool = VK_NULL_HANDLE;
+    VkDescriptorSet _occlusion_descriptor_set = VK_NULL_HANDLE;
+    VkPipelineLayout _occlusion_pipeline_layout = VK_NULL_HANDLE;
+    VkPipeline _occlusion_pipeline = VK_NULL_HANDLE;
+    VkBuffer _occlusion_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory _occlusion_buffer_memory = VK_NULL_HANDLE;
+    void* _occlusion_uniforms = nullptr;
+
+    PFN_vkCmdDrawIndexedIndirectCountAMD _draw_indexed_indirect_count = nullptr;
+    bool _multi_draw_indirect = false;
+};
@@ -0,0 +1,417 @@
+#include "gpu_particles.h"
+#include "renderer.h"
+#include "shared.h"
+
+#include <array>
+#include <cstring>
+
+// Matches the workgroup sizes of the particle shaders.
+constexpr uint32_t PARTICLE_GROUP_SIZE = 256;
+constexpr uint32_t PARTICLE_SIZE = 48;
+constexpr VkDeviceSize DRAW_ARGUMENTS_OFFSET = 16;
+
+struct ParticlePushConstants {
+    float gravity[3];
+    float drag;
+    float delta_time;
+    uint32_t emitter_count;
+    uint32_t max_particles;
+    uint32_t seed;
+};
+
+GpuParticles::GpuParticles(Renderer* renderer, uint32_t max_particles, uint32_t max_emitters)
+{
+    _renderer = renderer;
+    _max_particles = max_particles;
+    _max_emitters = max_emitters;
+    // The simulate dispatch covers at most 65535 groups.
+    assert(max_particles > 0 && max_particles <= 65535 * PARTICLE_GROUP_SIZE);
+
+    _init_buffers();
+    _init_descriptors();
+    _init_pipelines();
+    _init_async();
+}
+
+GpuParticles::~GpuParticles()
+{
+    _deinit_async();
+    _deinit_pipelines();
+    _deinit_descriptors();
+    _deinit_buffers();
+}
+
+ParticleEmitter * GpuParticles::get_emitters() const
+{
+    return _emitters;
+}
+
+void GpuParticles::set_emitter_count(uint32_t emitter_count)
+{
+    assert(emitter_count <= _max_emitters);
+    _emitter_count = emitter_count;
+}
+
+void GpuParticles::set_forces(const float gravity[3], float drag)
+{
+    std::memcpy(_gravity, gravity, sizeof(_gravity));
+    _drag = drag;
+}
+
+void GpuParticles::clear()
+{
+    _clear_pending = true;
+}
+
+void GpuParticles::record_update(VkCommandBuffer command_buffer, float delta_time)
+{
+    _record(command_buffer, delta_time, true);
+}
+
+void GpuParticles::submit_update(float delta_time, VkSemaphore wait_semaphore, VkSemaphore signal_semaphore)
+{
+    VkDevice device = _renderer->get_vulkan_device();
+    // Last frame's update, long done by now unless the GPU is far behind.
+    error_check(vkWaitForFences(device, 1, &_compute_fence, VK_TRUE, UINT64_MAX));
+    error_check(vkResetFences(device, 1, &_compute_fence));
+
+    VkCommandBufferBeginInfo command_buffer_begin_info{};
+    command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    error_check(vkBeginCommandBuffer(_compute_command_buffer, &command_buffer_begin_info));
+    _record(_compute_command_buffer, delta_time, !has_async_compute());
+    error_check(vkEndCommandBuffer(_compute_command_buffer));
+
+    VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    VkSubmitInfo submit_info{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.waitSemaphoreCount = wait_semaphore != VK_NULL_HANDLE ? 1 : 0;
+    submit_info.pWaitSemaphores = &wait_semaphore;
+    submit_info.pWaitDstStageMask = &wait_stage;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &_compute_command_buffer;
+    submit_info.signalSemaphoreCount = signal_semaphore != VK_NULL_HANDLE ? 1 : 0;
+    submit_info.pSignalSemaphores = &signal_semaphore;
+    error_check(vkQueueSubmit(_renderer->get_vulkan_compute_queue(), 1, &submit_info, _compute_fence));
+}
+
+bool GpuParticles::has_async_compute() const
+{
+    return _renderer->get_vulkan_compute_family_index() != _renderer->get_vulkan_graphics_family_index();
+}
+
+void GpuParticles::record_draw(VkCommandBuffer command_buffer) const
+{
+    vkCmdDrawIndirect(command_buffer, _indirect_buffer, DRAW_ARGUMENTS_OFFSET, 1, sizeof(VkDrawIndirectCommand));
+}
+
+const VkDescriptorSetLayout GpuParticles::get_vulkan_descriptor_set_layout() const
+{
+    return _descriptor_set_layout;
+}
+
+const VkDescriptorSet GpuParticles::get_vulkan_descriptor_set() const
+{
+    return _descriptor_sets[_parity];
+}
+
+const uint32_t GpuParticles::get_max_particles() const
+{
+    return _max_particles;
+}
+
+void GpuParticles::_record(VkCommandBuffer command_buffer, float delta_time, bool graphics_queue)
+{
+    ParticlePushConstants push_constants{};
+    std::memcpy(push_constants.gravity, _gravity, sizeof(push_constants.gravity));
+    push_constants.drag = _drag;
+    push_constants.delta_time = delta_time;
+    push_constants.emitter_count = _emitter_count;
+    push_constants.max_particles = _max_particles;
+    push_constants.seed = _seed++;
+
+    VkMemoryBarrier compute_barrier{};
+    compute_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    compute_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    compute_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    // Last frame's draw must be done with the lists before they are rewritten.
+    // On the compute queue the wait semaphore orders the two instead.
+    if (graphics_queue) {
+        VkMemoryBarrier draw_barrier{};
+        draw_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        draw_barrier.srcAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+        draw_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(command_buffer,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 1, &draw_barrier, 0, nullptr, 0, nullptr);
+    }
+
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline_layout, 0, 1, &_descriptor_sets[_parity], 0, nullptr);
+    vkCmdPushConstants(command_buffer, _pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push_constants), &push_constants);
+
+    if (_clear_pending) {
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, _reset_pipeline);
+        vkCmdDispatch(command_buffer, (_max_particles + PARTICLE_GROUP_SIZE - 1) / PARTICLE_GROUP_SIZE, 1, 1);
+        vkCmdPipelineBarrier(command_buffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 1, &compute_barrier, 0, nullptr, 0, nullptr);
+        _clear_pending = false;
+    }
+
+    // One workgroup per emitter pops its slots from the dead list and appends to the alive list.
+    if (_emitter_count > 0) {
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, _emit_pipeline);
+        vkCmdDispatch(command_buffer, _emitter_count, 1, 1);
+        vkCmdPipelineBarrier(command_buffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 1, &compute_barrier, 0, nullptr, 0, nullptr);
+    }
+
+    // Sizes the simulate dispatch from the alive count and clears the next list and draw.
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, _arguments_pipeline);
+    vkCmdDispatch(command_buffer, 1, 1, 1);
+
+    VkMemoryBarrier arguments_barrier{};
+    arguments_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    arguments_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    arguments_barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(command_buffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 1, &arguments_barrier, 0, nullptr, 0, nullptr);
+
+    // Integrates, retires the dead to the dead list and compacts the rest into the next list.
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, _simulate_pipeline);
+    vkCmdDispatchIndirect(command_buffer, _indirect_buffer, 0);
+
+    if (graphics_queue) {
+        VkMemoryBarrier draw_barrier{};
+        draw_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        draw_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        draw_barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(command_buffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+            0, 1, &draw_barrier, 0, nullptr, 0, nullptr);
+    }
+
+    _parity ^= 1;
+}
+
+void GpuParticles::_init_buffers()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+    const VkPhysicalDeviceMemoryProperties* memory_properties = &_renderer->get_vulkan_physical_device_memory_properties();
+
+    // Shared with the compute queue without ownership transfers.
+    uint32_t queue_families[] = { _renderer->get_vulkan_graphics_family_index(), _renderer->get_vulkan_compute_family_index() };
+    uint32_t queue_family_count = queue_families[0] != queue_families[1] ? 2 : 1;
+
+    create_buffer(device, memory_properties,
+        sizeof(ParticleEmitter) * _max_emitters,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        &_emitter_buffer, &_emitter_buffer_memory,
+        queue_family_count, queue_families);
+    void* mapped = nullptr;
+    error_check(vkMapMemory(device, _emitter_buffer_memory, 0, VK_WHOLE_SIZE, 0, &mapped));
+    _emitters = (ParticleEmitter*)mapped;
+    std::memset(_emitters, 0, sizeof(ParticleEmitter) * _max_emitters);
+
+    create_buffer(device, memory_properties,
+        (VkDeviceSize)PARTICLE_SIZE * _max_particles,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        &_particle_buffer, &_particle_buffer_memory,
+        queue_family_count, queue_families);
+
+    // Lists are a count followed by the particle indices.
+    create_buffer(device, memory_properties,
+        sizeof(uint32_t) * ((VkDeviceSize)_max_particles + 1),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        &_dead_list_buffer, &_dead_list_buffer_memory,
+        queue_family_count, queue_families);
+    for (uint32_t i = 0; i < 2; ++i) {
+        create_buffer(device, memory_properties,
+            sizeof(uint32_t) * ((VkDeviceSize)_max_particles + 1),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            &_alive_list_buffers[i], &_alive_list_buffer_memories[i],
+            queue_family_count, queue_families);
+    }
+
+    create_buffer(device, memory_properties,
+        DRAW_ARGUMENTS_OFFSET + sizeof(VkDrawIndirectCommand),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        &_indirect_buffer, &_indirect_buffer_memory,
+        queue_family_count, queue_families);
+}
+
+void GpuParticles::_deinit_buffers()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+    vkUnmapMemory(device, _emitter_buffer_memory);
+    vkDestroyBuffer(device, _emitter_buffer, nullptr);
+    vkFreeMemory(device, _emitter_buffer_memory, nullptr);
+    vkDestroyBuffer(device, _particle_buffer, nullptr);
+    vkFreeMemory(device, _particle_buffer_memory, nullptr);
+    vkDestroyBuffer(device, _dead_list_buffer, nullptr);
+    vkFreeMemory(device, _dead_list_buffer_memory, nullptr);
+    for (uint32_t i = 0; i < 2; ++i) {
+        vkDestroyBuffer(device, _alive_list_buffers[i], nullptr);
+        vkFreeMemory(device, _alive_list_buffer_memories[i], nullptr);
+    }
+    vkDestroyBuffer(device, _indirect_buffer, nullptr);
+    vkFreeMemory(device, _indirect_buffer_memory, nullptr);
+    _emitters = nullptr;
+}
+
+void GpuParticles::_init_descriptors()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+
+    std::array<VkDescriptorSetLayoutBinding, 6> bindings{};
+    for (uint32_t i = 0; i < bindings.size(); ++i) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info{};
+    descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptor_set_layout_create_info.bindingCount = (uint32_t)bindings.size();
+    descriptor_set_layout_create_info.pBindings = bindings.data();
+    error_check(vkCreateDescriptorSetLayout(device, &descriptor_set_layout_create_info, nullptr, &_descriptor_set_layout));
+
+    VkDescriptorPoolSize pool_size{};
+    pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    pool_size.descriptorCount = (uint32_t)bindings.size() * 2;
+
+    VkDescriptorPoolCreateInfo descriptor_pool_create_info{};
+    descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptor_pool_create_info.maxSets = 2;
+    descriptor_pool_create_info.poolSizeCount = 1;
+    descriptor_pool_create_info.pPoolSizes = &pool_size;
+    error_check(vkCreateDescriptorPool(device, &descriptor_pool_create_info, nullptr, &_descriptor_pool));
+
+    VkDescriptorSetLayout set_layouts[] = { _descriptor_set_layout, _descriptor_set_layout };
+    VkDescriptorSetAllocateInfo descriptor_set_allocate_info{};
+    descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descriptor_set_allocate_info.descriptorPool = _descriptor_pool;
+    descriptor_set_allocate_info.descriptorSetCount = 2;
+    descriptor_set_allocate_info.pSetLayouts = set_layouts;
+    error_check(vkAllocateDescriptorSets(device, &descriptor_set_allocate_info, _descriptor_sets));
+
+    for (uint32_t set = 0; set < 2; ++set) {
+        std::array<VkDescriptorBufferInfo, 6> buffer_infos{};
+        buffer_infos[0].buffer = _emitter_buffer;
+        buffer_infos[1].buffer = _particle_buffer;
+        buffer_infos[2].buffer = _dead_list_buffer;
+        buffer_infos[3].buffer = _alive_list_buffers[set];
+        buffer_infos[4].buffer = _alive_list_buffers[set ^ 1];
+        buffer_infos[5].buffer = _indirect_buffer;
+
+        std::array<VkWriteDescriptorSet, 6> writes{};
+        for (uint32_t i = 0; i < writes.size(); ++i) {
+            buffer_infos[i].range = VK_WHOLE_SIZE;
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = _descriptor_sets[set];
+            writes[i].dstBinding = i;
+            writes[i].descriptorCount = 1;
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[i].pBufferInfo = &buffer_infos[i];
+        }
+        vkUpdateDescriptorSets(device, (uint32_t)writes.size(), writes.data(), 0, nullptr);
+    }
+}
+
+void GpuParticles::_deinit_descriptors()
+{
+    vkDestroyDescriptorPool(_renderer->get_vulkan_device(), _descriptor_pool, nullptr);
+    vkDestroyDescriptorSetLayout(_renderer->get_vulkan_device(), _descriptor_set_layout, nullptr);
+}
+
+void GpuParticles::_init_pipelines()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+
+    VkPushConstantRange push_constant_range{};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(ParticlePushConstants);
+
+    VkPipelineLayoutCreateInfo pipeline_layout_create_info{};
+    pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_create_info.setLayoutCount = 1;
+    pipeline_layout_create_info.pSetLayouts = &_descriptor_set_layout;
+    pipeline_layout_create_info.pushConstantRangeCount = 1;
+    pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+    error_check(vkCreatePipelineLayout(device, &pipeline_layout_create_info, nullptr, &_pipeline_layout));
+
+    const char* shader_files[] = {
+        "shaders/particles_reset.comp.spv",
+        "shaders/particles_emit.comp.spv",
+        "shaders/particles_arguments.comp.spv",
+        "shaders/particles_simulate.comp.spv",
+    };
+    VkPipeline* pipelines[] = { &_reset_pipeline, &_emit_pipeline, &_arguments_pipeline, &_simulate_pipeline };
+
+    for (uint32_t i = 0; i < 4; ++i) {
+        VkShaderModule shader_module = load_shader_module(device, shader_files[i]);
+
+        VkComputePipelineCreateInfo pipeline_create_info{};
+        pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipeline_create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipeline_create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipeline_create_info.stage.module = shader_module;
+        pipeline_create_info.stage.pName = "main";
+        pipeline_create_info.layout = _pipeline_layout;
+        error_check(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeline_create_info, nullptr, pipelines[i]));
+
+        vkDestroyShaderModule(device, shader_module, nullptr);
+    }
+}
+
+void GpuParticles::_deinit_pipelines()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+    vkDestroyPipeline(device, _reset_pipeline, nullptr);
+    vkDestroyPipeline(device, _emit_pipeline, nullptr);
+    vkDestroyPipeline(device, _arguments_pipeline, nullptr);
+    vkDestroyPipeline(device, _simulate_pipeline, nullptr);
+    vkDestroyPipelineLayout(device, _pipeline_layout, nullptr);
+}
+
+void GpuParticles::_init_async()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+
+    VkCommandPoolCreateInfo pool_create_info{};
+    pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    pool_create_info.queueFamilyIndex = _renderer->get_vulkan_compute_family_index();
+    error_check(vkCreateCommandPool(device, &pool_create_info, nullptr, &_compute_command_pool));
+
+    VkCommandBufferAllocateInfo command_buffer_allocate_info{};
+    command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    command_buffer_allocate_info.commandPool = _compute_command_pool;
+    command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    command_buffer_allocate_info.commandBufferCount = 1;
+    error_check(vkAllocateCommandBuffers(device, &command_buffer_allocate_info, &_compute_command_buffer));
+
+    // Signaled, so the first submit_update does not wait.
+    VkFenceCreateInfo fence_create_info{};
+    fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fence_create_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+    error_check(vkCreateFence(device, &fence_create_info, nullptr, &_compute_fence));
+}
+
+void GpuParticles::_deinit_async()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+    error_check(vkWaitForFences(device, 1, &_compute_fence, VK_TRUE, UINT64_MAX));
+    vkDestroyFence(device, _compute_fence, nullptr);
+    vkDestroyCommandPool(device, _compute_command_pool, nullptr);
+}
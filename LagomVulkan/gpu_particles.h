@@ -0,0 +1,118 @@
+#pragma once
+#include "platform.h"
+
+class Renderer;
+
+// Matches Emitter in shaders/particles_emit.comp.
+struct ParticleEmitter {
+    float position[3];
+    // Particles spawn inside a sphere of this radius.
+    float position_spread;
+    float velocity[3];
+    float velocity_spread;
+    float color[4];
+    // Seconds.
+    float lifetime;
+    float lifetime_spread;
+    float size;
+    // Particles spawned per second, zero for an idle emitter. Each update
+    // spawns rate * delta_time with the fraction rounded at random, so low
+    // rates keep their average at any frame rate.
+    float emit_rate;
+};
+
+// Particle system that lives entirely on the GPU. The CPU only writes a
+// handful of emitters into a mapped buffer, compute passes pop free slots
+// from a dead list to spawn particles, integrate the live ones and compact
+// the survivors into the next alive list with one atomic per workgroup.
+// The live count feeds the indirect simulate dispatch and the indirect draw,
+// so nothing per-particle ever crosses the bus. The update can be recorded
+// on the graphics queue or submitted on the async compute queue when the
+// device has one.
+class GpuParticles {
+public:
+    GpuParticles(Renderer* renderer, uint32_t max_particles, uint32_t max_emitters);
+    ~GpuParticles();
+
+    // Read by the next update, write once the previous update has completed.
+    ParticleEmitter* get_emitters() const;
+    void set_emitter_count(uint32_t emitter_count);
+    // Acceleration in world units per second squared, drag per second.
+    void set_forces(const float gravity[3], float drag);
+    // Kills every particle on the next update.
+    void clear();
+
+    // Record outside of a render pass, before the pass that draws the particles.
+    void record_update(VkCommandBuffer command_buffer, float delta_time);
+    // Same work submitted on the compute queue. Wait on the semaphore of the
+    // submission that last drew the particles, the draw waits on signal_semaphore
+    // at VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT. Either semaphore may be VK_NULL_HANDLE.
+    void submit_update(float delta_time, VkSemaphore wait_semaphore, VkSemaphore signal_semaphore);
+    // True when submit_update runs on a dedicated queue and overlaps graphics work.
+    bool has_async_compute() const;
+
+    // Record inside a render pass with a pipeline bound that expands the alive
+    // list with shaders/particles.glsl, six vertices per particle, such as
+    // shaders/particles.vert and shaders/particles.frag.
+    void record_draw(VkCommandBuffer command_buffer) const;
+
+    // Particles at binding 1 and the alive list of the last update at binding 3,
+    // readable from vertex shaders. Changes after every update.
+    const VkDescriptorSetLayout get_vulkan_descriptor_set_layout() const;
+    const VkDescriptorSet get_vulkan_descriptor_set() const;
+    const uint32_t get_max_particles() const;
+
+private:
+    void _init_buffers();
+    void _deinit_buffers();
+
+    void _init_descriptors();
+    void _deinit_descriptors();
+
+    void _init_pipelines();
+    void _deinit_pipelines();
+
+    void _init_async();
+    void _deinit_async();
+
+    void _record(VkCommandBuffer command_buffer, float delta_time, bool graphics_queue);
+
+    Renderer* _renderer = nullptr;
+
+    VkDescriptorSetLayout _descriptor_set_layout = VK_NULL_HANDLE;
+    VkDescriptorPool _descriptor_pool = VK_NULL_HANDLE;
+    // Indexed by _parity, set i reads alive list i and writes alive list 1 - i.
+    VkDescriptorSet _descriptor_sets[2] = {};
+    VkPipelineLayout _pipeline_layout = VK_NULL_HANDLE;
+    VkPipeline _reset_pipeline = VK_NULL_HANDLE;
+    VkPipeline _emit_pipeline = VK_NULL_HANDLE;
+    VkPipeline _arguments_pipeline = VK_NULL_HANDLE;
+    VkPipeline _simulate_pipeline = VK_NULL_HANDLE;
+
+    uint32_t _max_particles = 0;
+    uint32_t _max_emitters = 0;
+    uint32_t _emitter_count = 0;
+    float _gravity[3] = {};
+    float _drag = 0.0f;
+    uint32_t _parity = 0;
+    uint32_t _seed = 0;
+    bool _clear_pending = true;
+
+    VkBuffer _emitter_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory _emitter_buffer_memory = VK_NULL_HANDLE;
+    ParticleEmitter* _emitters = nullptr;
+
+    VkBuffer _particle_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory _particle_buffer_memory = VK_NULL_HANDLE;
+    VkBuffer _dead_list_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory _dead_list_buffer_memory = VK_NULL_HANDLE;
+    VkBuffer _alive_list_buffers[2] = {};
+    VkDeviceMemory _alive_list_buffer_memories[2] = {};
+    // Simulate dispatch arguments followed by the draw arguments.
+    VkBuffer _indirect_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory _indirect_buffer_memory = VK_NULL_HANDLE;
+
+    VkCommandPool _compute_command_pool = VK_NULL_HANDLE;
+    VkCommandBuffer _compute_command_buffer = VK_NULL_HANDLE;
+    VkFence _compute_fence = VK_NULL_HANDLE;
+};
@@ -0,0 +1,116 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Applies a permutation to a dense array, new index i takes old index old_of_new[i].
+template<typename T>
+void reorder_array(std::vector<T>& values, const std::vector<uint32_t>& old_of_new)
+{
+    std::vector<T> reordered(old_of_new.size());
+    for (size_t i = 0; i < old_of_new.size(); ++i) {
+        reordered[i] = values[old_of_new[i]];
+    }
+    values.swap(reordered);
+}
+
+// Generational ids for objects kept as packed (dense) arrays. An id is the
+// slot in the low SLOT_BITS bits and the slot's generation above, the table
+// maps slots to dense indices and back. The owner keeps its own arrays in
+// the same order and makes the same moves on them: create() appends,
+// remove() swaps with the last entry and reorder() permutes.
+template<uint32_t SLOT_BITS>
+class HandleTable {
+public:
+    static_assert(SLOT_BITS >= 15 && SLOT_BITS < 31, "generations are 16 bits at most");
+
+    // Appends a dense entry and returns its id, -1 once every slot is taken.
+    int create()
+    {
+        uint32_t slot = 0;
+        if (!_free_slots.empty()) {
+            slot = _free_slots.back();
+            _free_slots.pop_back();
+        }
+        else {
+            slot = (uint32_t)_dense_of.size();
+            if (slot > SLOT_MASK) {
+                return -1;
+            }
+            _dense_of.push_back(UINT32_MAX);
+            _generation_of.push_back(0);
+        }
+        _dense_of[slot] = (uint32_t)_slot_of.size();
+        _slot_of.push_back(slot);
+        return _pack(slot);
+    }
+
+    // Frees the entry's slot, the entry itself stays until a reorder() leaves it out.
+    void release(uint32_t dense)
+    {
+        uint32_t slot = _slot_of[dense];
+        _dense_of[slot] = UINT32_MAX;
+        // Stale ids stop matching, the generation stops short of the sign bit.
+        _generation_of[slot] = (uint16_t)((_generation_of[slot] + 1) & GENERATION_MASK);
+        _free_slots.push_back(slot);
+        _slot_of[dense] = UINT32_MAX;
+    }
+
+    // Frees the entry and moves the last one into its place.
+    void remove(uint32_t dense)
+    {
+        release(dense);
+        uint32_t last = (uint32_t)_slot_of.size() - 1;
+        if (dense != last) {
+            _slot_of[dense] = _slot_of[last];
+            _dense_of[_slot_of[dense]] = dense;
+        }
+        _slot_of.pop_back();
+    }
+
+    // Released entries must be left out of old_of_new.
+    void reorder(const std::vector<uint32_t>& old_of_new)
+    {
+        reorder_array(_slot_of, old_of_new);
+        for (uint32_t i = 0; i < (uint32_t)_slot_of.size(); ++i) {
+            _dense_of[_slot_of[i]] = i;
+        }
+    }
+
+    // Dense index of id, UINT32_MAX for ids that are stale or were never handed out.
+    uint32_t find(int id) const
+    {
+        uint32_t slot = (uint32_t)id & SLOT_MASK;
+        uint32_t generation = (uint32_t)id >> SLOT_BITS;
+        if (id < 0 || slot >= _dense_of.size() || _generation_of[slot] != generation) {
+            return UINT32_MAX;
+        }
+        return _dense_of[slot];
+    }
+
+    int get_id(uint32_t dense) const
+    {
+        return _pack(_slot_of[dense]);
+    }
+
+    uint32_t size() const
+    {
+        return (uint32_t)_slot_of.size();
+    }
+
+private:
+    static constexpr uint32_t SLOT_MASK = (1u << SLOT_BITS) - 1;
+    static constexpr uint32_t GENERATION_MASK = (1u << (31 - SLOT_BITS)) - 1;
+
+    int _pack(uint32_t slot) const
+    {
+        return (int)(((uint32_t)_generation_of[slot] << SLOT_BITS) | slot);
+    }
+
+    // Slot -> dense index, UINT32_MAX when the slot is free.
+    std::vector<uint32_t> _dense_of;
+    std::vector<uint16_t> _generation_of;
+    std::vector<uint32_t> _free_slots;
+    // Dense index -> slot, UINT32_MAX for released entries.
+    std::vector<uint32_t> _slot_of;
+};
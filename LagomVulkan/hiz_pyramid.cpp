@@ -0,0 +1,324 @@
+#include "BUILD_OPTIONS.h"
+#include "hiz_pyramid.h"
+#include "renderer.h"
+#include "window.h"
+#include "shared.h"
+
+#include <array>
+#include <algorithm>
+
+struct ReducePushConstants {
+    int32_t source_size[2];
+    int32_t destination_size[2];
+    uint32_t copy_depth;
+};
+
+HiZPyramid::HiZPyramid(Renderer* renderer, Window* window)
+{
+    _renderer = renderer;
+    _window = window;
+
+    if (_window->get_vulkan_depth_sample_view() == VK_NULL_HANDLE) {
+        assert(0 && "Hi-Z pyramid needs BUILD_ENABLE_HIZ_OCCLUSION_CULLING");
+        std::exit(-1);
+    }
+#if BUILD_ENABLE_DYNAMIC_RESOLUTION
+    // The scene depth goes to DynamicResolution's target then, the window's depth buffer stays stale.
+    assert(0 && "Hi-Z pyramid does not support BUILD_ENABLE_DYNAMIC_RESOLUTION");
+    std::exit(-1);
+#endif
+
+    _size = _window->get_vulkan_surface_size();
+    _level_count = 1;
+    while ((std::max(_size.width, _size.height) >> _level_count) > 0) {
+        ++_level_count;
+    }
+
+    _init_image();
+    _init_descriptors();
+    _init_pipeline();
+}
+
+HiZPyramid::~HiZPyramid()
+{
+    _deinit_pipeline();
+    _deinit_descriptors();
+    _deinit_image();
+}
+
+void HiZPyramid::record_build(VkCommandBuffer command_buffer)
+{
+    // The first build moves the whole chain into GENERAL, later builds wait for last frame's cull reads.
+    VkImageMemoryBarrier begin_barrier{};
+    begin_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    begin_barrier.srcAccessMask = _has_data ? VK_ACCESS_SHADER_READ_BIT : 0;
+    begin_barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    begin_barrier.oldLayout = _has_data ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_UNDEFINED;
+    begin_barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    begin_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    begin_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    begin_barrier.image = _image;
+    begin_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    begin_barrier.subresourceRange.levelCount = _level_count;
+    begin_barrier.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(command_buffer,
+        _has_data ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &begin_barrier);
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline);
+
+    VkExtent2D source_size = _size;
+    for (uint32_t level = 0; level < _level_count; ++level) {
+        VkExtent2D level_size = { std::max(_size.width >> level, 1u), std::max(_size.height >> level, 1u) };
+
+        ReducePushConstants push_constants{};
+        push_constants.source_size[0] = (int32_t)source_size.width;
+        push_constants.source_size[1] = (int32_t)source_size.height;
+        push_constants.destination_size[0] = (int32_t)level_size.width;
+        push_constants.destination_size[1] = (int32_t)level_size.height;
+        push_constants.copy_depth = level == 0 ? 1 : 0;
+
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline_layout, 0, 1, &_descriptor_sets[level], 0, nullptr);
+        vkCmdPushConstants(command_buffer, _pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push_constants), &push_constants);
+        vkCmdDispatch(command_buffer, (level_size.width + 7) / 8, (level_size.height + 7) / 8, 1);
+
+        // The next level, and next frame's cull pass, read what was just written.
+        VkImageMemoryBarrier level_barrier = begin_barrier;
+        level_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        level_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        level_barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        level_barrier.subresourceRange.baseMipLevel = level;
+        level_barrier.subresourceRange.levelCount = 1;
+        vkCmdPipelineBarrier(command_buffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &level_barrier);
+
+        source_size = level_size;
+    }
+
+    _has_data = true;
+}
+
+bool HiZPyramid::has_data() const
+{
+    return _has_data;
+}
+
+const VkImageView HiZPyramid::get_vulkan_image_view() const
+{
+    return _image_view;
+}
+
+const VkSampler HiZPyramid::get_vulkan_sampler() const
+{
+    return _sampler;
+}
+
+const VkExtent2D HiZPyramid::get_size() const
+{
+    return _size;
+}
+
+const uint32_t HiZPyramid::get_level_count() const
+{
+    return _level_count;
+}
+
+void HiZPyramid::_init_image()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+
+    VkImageCreateInfo image_create_info{};
+    image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_create_info.imageType = VK_IMAGE_TYPE_2D;
+    image_create_info.format = VK_FORMAT_R32G32_SFLOAT;
+    image_create_info.extent.width = _size.width;
+    image_create_info.extent.height = _size.height;
+    image_create_info.extent.depth = 1;
+    image_create_info.mipLevels = _level_count;
+    image_create_info.arrayLayers = 1;
+    image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_create_info.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    error_check(vkCreateImage(device, &image_create_info, nullptr, &_image));
+
+    VkMemoryRequirements image_memory_requirements{};
+    vkGetImageMemoryRequirements(device, _image, &image_memory_requirements);
+    VkMemoryAllocateInfo memory_allocate_info{};
+    memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    memory_allocate_info.allocationSize = image_memory_requirements.size;
+    memory_allocate_info.memoryTypeIndex = find_memory_type_index(&_renderer->get_vulkan_physical_device_memory_properties(), &image_memory_requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    error_check(vkAllocateMemory(device, &memory_allocate_info, nullptr, &_image_memory));
+    error_check(vkBindImageMemory(device, _image, _image_memory, 0));
+
+    VkImageViewCreateInfo image_view_create_info{};
+    image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    image_view_create_info.image = _image;
+    image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    image_view_create_info.format = VK_FORMAT_R32G32_SFLOAT;
+    image_view_create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+    image_view_create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+    image_view_create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+    image_view_create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    image_view_create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    image_view_create_info.subresourceRange.baseMipLevel = 0;
+    image_view_create_info.subresourceRange.levelCount = _level_count;
+    image_view_create_info.subresourceRange.baseArrayLayer = 0;
+    image_view_create_info.subresourceRange.layerCount = 1;
+    error_check(vkCreateImageView(device, &image_view_create_info, nullptr, &_image_view));
+
+    _level_views.resize(_level_count);
+    for (uint32_t level = 0; level < _level_count; ++level) {
+        image_view_create_info.subresourceRange.baseMipLevel = level;
+        image_view_create_info.subresourceRange.levelCount = 1;
+        error_check(vkCreateImageView(device, &image_view_create_info, nullptr, &_level_views[level]));
+    }
+
+    VkSamplerCreateInfo sampler_create_info{};
+    sampler_create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_create_info.magFilter = VK_FILTER_NEAREST;
+    sampler_create_info.minFilter = VK_FILTER_NEAREST;
+    sampler_create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sampler_create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_create_info.maxAnisotropy = 1.0f;
+    sampler_create_info.compareOp = VK_COMPARE_OP_NEVER;
+    sampler_create_info.minLod = 0.0f;
+    sampler_create_info.maxLod = (float)_level_count;
+    sampler_create_info.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+    error_check(vkCreateSampler(device, &sampler_create_info, nullptr, &_sampler));
+}
+
+void HiZPyramid::_deinit_image()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+    vkDestroySampler(device, _sampler, nullptr);
+    for (VkImageView level_view : _level_views) {
+        vkDestroyImageView(device, level_view, nullptr);
+    }
+    vkDestroyImageView(device, _image_view, nullptr);
+    vkFreeMemory(device, _image_memory, nullptr);
+    vkDestroyImage(device, _image, nullptr);
+}
+
+void HiZPyramid::_init_descriptors()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info{};
+    descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptor_set_layout_create_info.bindingCount = (uint32_t)bindings.size();
+    descriptor_set_layout_create_info.pBindings = bindings.data();
+    error_check(vkCreateDescriptorSetLayout(device, &descriptor_set_layout_create_info, nullptr, &_descriptor_set_layout));
+
+    std::array<VkDescriptorPoolSize, 2> pool_sizes{};
+    pool_sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    pool_sizes[0].descriptorCount = _level_count;
+    pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    pool_sizes[1].descriptorCount = _level_count;
+
+    VkDescriptorPoolCreateInfo descriptor_pool_create_info{};
+    descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptor_pool_create_info.maxSets = _level_count;
+    descriptor_pool_create_info.poolSizeCount = (uint32_t)pool_sizes.size();
+    descriptor_pool_create_info.pPoolSizes = pool_sizes.data();
+    error_check(vkCreateDescriptorPool(device, &descriptor_pool_create_info, nullptr, &_descriptor_pool));
+
+    std::vector<VkDescriptorSetLayout> set_layouts(_level_count, _descriptor_set_layout);
+    _descriptor_sets.resize(_level_count);
+    VkDescriptorSetAllocateInfo descriptor_set_allocate_info{};
+    descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descriptor_set_allocate_info.descriptorPool = _descriptor_pool;
+    descriptor_set_allocate_info.descriptorSetCount = _level_count;
+    descriptor_set_allocate_info.pSetLayouts = set_layouts.data();
+    error_check(vkAllocateDescriptorSets(device, &descriptor_set_allocate_info, _descriptor_sets.data()));
+
+    // Level 0 reads the depth buffer, every other level reads the one above it.
+    for (uint32_t level = 0; level < _level_count; ++level) {
+        VkDescriptorImageInfo source_info{};
+        source_info.sampler = _sampler;
+        if (level == 0) {
+            source_info.imageView = _window->get_vulkan_depth_sample_view();
+            source_info.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        }
+        else {
+            source_info.imageView = _level_views[level - 1];
+            source_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        }
+
+        VkDescriptorImageInfo destination_info{};
+        destination_info.imageView = _level_views[level];
+        destination_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        std::array<VkWriteDescriptorSet, 2> writes{};
+        writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[0].dstSet = _descriptor_sets[level];
+        writes[0].dstBinding = 0;
+        writes[0].descriptorCount = 1;
+        writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes[0].pImageInfo = &source_info;
+        writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[1].dstSet = _descriptor_sets[level];
+        writes[1].dstBinding = 1;
+        writes[1].descriptorCount = 1;
+        writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[1].pImageInfo = &destination_info;
+        vkUpdateDescriptorSets(device, (uint32_t)writes.size(), writes.data(), 0, nullptr);
+    }
+}
+
+void HiZPyramid::_deinit_descriptors()
+{
+    vkDestroyDescriptorPool(_renderer->get_vulkan_device(), _descriptor_pool, nullptr);
+    vkDestroyDescriptorSetLayout(_renderer->get_vulkan_device(), _descriptor_set_layout, nullptr);
+}
+
+void HiZPyramid::_init_pipeline()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+
+    VkPushConstantRange push_constant_range{};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(ReducePushConstants);
+
+    VkPipelineLayoutCreateInfo pipeline_layout_create_info{};
+    pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_create_info.setLayoutCount = 1;
+    pipeline_layout_create_info.pSetLayouts = &_descriptor_set_layout;
+    pipeline_layout_create_info.pushConstantRangeCount = 1;
+    pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+    error_check(vkCreatePipelineLayout(device, &pipeline_layout_create_info, nullptr, &_pipeline_layout));
+
+    VkShaderModule shader_module = load_shader_module(device, "shaders/hiz_build.comp.spv");
+
+    VkComputePipelineCreateInfo pipeline_create_info{};
+    pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_create_info.stage.module = shader_module;
+    pipeline_create_info.stage.pName = "main";
+    pipeline_create_info.layout = _pipeline_layout;
+    error_check(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeline_create_info, nullptr, &_pipeline));
+
+    vkDestroyShaderModule(device, shader_module, nullptr);
+}
+
+void HiZPyramid::_deinit_pipeline()
+{
+    vkDestroyPipeline(_renderer->get_vulkan_device(), _pipeline, nullptr);
+    vkDestroyPipelineLayout(_renderer->get_vulkan_device(), _pipeline_layout, nullptr);
+}
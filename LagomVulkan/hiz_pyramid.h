@@ -0,0 +1,60 @@
+#pragma once
+#include "platform.h"
+
+#include <vector>
+
+class Renderer;
+class Window;
+
+// Hierarchical-Z pyramid built in compute from the window's depth buffer.
+// Every level holds the min and max depth (RG32F) of the area it covers and
+// is read by the occlusion variant of the GPU cull pass one frame later.
+// Requires BUILD_ENABLE_HIZ_OCCLUSION_CULLING so the depth buffer is kept,
+// and is rejected with BUILD_ENABLE_DYNAMIC_RESOLUTION, which renders the
+// scene depth into its own target instead of the window's.
+class HiZPyramid {
+public:
+    HiZPyramid(Renderer* renderer, Window* window);
+    ~HiZPyramid();
+
+    // Record after the render pass that wrote the window's depth buffer.
+    void record_build(VkCommandBuffer command_buffer);
+
+    // False until the first build has been recorded.
+    bool has_data() const;
+
+    const VkImageView get_vulkan_image_view() const;
+    const VkSampler get_vulkan_sampler() const;
+    const VkExtent2D get_size() const;
+    const uint32_t get_level_count() const;
+
+private:
+    void _init_image();
+    void _deinit_image();
+
+    void _init_descriptors();
+    void _deinit_descriptors();
+
+    void _init_pipeline();
+    void _deinit_pipeline();
+
+    Renderer* _renderer = nullptr;
+    Window* _window = nullptr;
+
+    VkExtent2D _size = {};
+    uint32_t _level_count = 0;
+
+    VkImage _image = VK_NULL_HANDLE;
+    VkDeviceMemory _image_memory = VK_NULL_HANDLE;
+    VkImageView _image_view = VK_NULL_HANDLE;
+    std::vector<VkImageView> _level_views;
+    VkSampler _sampler = VK_NULL_HANDLE;
+
+    VkDescriptorSetLayout _descriptor_set_layout = VK_NULL_HANDLE;
+    VkDescriptorPool _descriptor_pool = VK_NULL_HANDLE;
+    std::vector<VkDescriptorSet> _descriptor_sets;
+    VkPipelineLayout _pipeline_layout = VK_NULL_HANDLE;
+    VkPipeline _pipeline = VK_NULL_HANDLE;
+
+    bool _has_data = false;
+};
@@ -0,0 +1,97 @@
+#include "job_system.h"
+
+JobSystem::JobSystem(uint32_t worker_count)
+{
+    if (worker_count == 0) {
+        uint32_t hardware_threads = std::thread::hardware_concurrency();
+        worker_count = hardware_threads > 1 ? hardware_threads - 1 : 0;
+    }
+    for (uint32_t i = 0; i < worker_count; ++i) {
+        _workers.emplace_back(&JobSystem::_worker_main, this);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _quit = true;
+    }
+    _jobs_ready.notify_all();
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+}
+
+void JobSystem::parallel_for(uint32_t count, uint32_t chunk_size, const std::function<void(uint32_t, uint32_t)>& job)
+{
+    if (count == 0) {
+        return;
+    }
+    chunk_size = chunk_size > 0 ? chunk_size : 1;
+    // Waking the workers costs more than a single chunk.
+    if (_workers.empty() || count <= chunk_size) {
+        job(0, count);
+        return;
+    }
+
+    {
+        // A worker that woke late for the previous range may still be checking its counter.
+        std::unique_lock<std::mutex> lock(_mutex);
+        _jobs_done.wait(lock, [this]() { return _active_workers == 0; });
+        _job = &job;
+        _count = count;
+        _chunk_size = chunk_size;
+        _chunk_count = (count + chunk_size - 1) / chunk_size;
+        _next_chunk.store(0);
+        ++_generation;
+    }
+    _jobs_ready.notify_all();
+
+    _run_chunks();
+
+    // Every chunk is claimed once the caller runs out, wait for the ones still running.
+    std::unique_lock<std::mutex> lock(_mutex);
+    _jobs_done.wait(lock, [this]() { return _active_workers == 0; });
+    _job = nullptr;
+}
+
+uint32_t JobSystem::get_worker_count() const
+{
+    return (uint32_t)_workers.size();
+}
+
+void JobSystem::_worker_main()
+{
+    uint64_t seen_generation = 0;
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (;;) {
+        _jobs_ready.wait(lock, [&]() { return _quit || _generation != seen_generation; });
+        if (_quit) {
+            return;
+        }
+        seen_generation = _generation;
+        ++_active_workers;
+        lock.unlock();
+
+        _run_chunks();
+
+        lock.lock();
+        if (--_active_workers == 0) {
+            _jobs_done.notify_all();
+        }
+    }
+}
+
+void JobSystem::_run_chunks()
+{
+    for (;;) {
+        uint32_t chunk = _next_chunk.fetch_add(1);
+        if (chunk >= _chunk_count) {
+            return;
+        }
+        uint32_t begin = chunk * _chunk_size;
+        uint32_t end = begin + _chunk_size < _count ? begin + _chunk_size : _count;
+        (*_job)(begin, end);
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed pool of worker threads for data parallel frame work. parallel_for
+// splits a range into chunks that the workers and the calling thread claim
+// with an atomic counter, and returns once every chunk has run. Only one
+// parallel_for runs at a time, call it from one thread.
+class JobSystem {
+public:
+    // 0 workers uses one less than the hardware threads, the caller makes up the last one.
+    JobSystem(uint32_t worker_count = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Calls job(begin, end) for chunks of chunk_size covering [0, count).
+    void parallel_for(uint32_t count, uint32_t chunk_size, const std::function<void(uint32_t, uint32_t)>& job);
+
+    uint32_t get_worker_count() const;
+
+private:
+    void _worker_main();
+    void _run_chunks();
+
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _jobs_ready;
+    std::condition_variable _jobs_done;
+    bool _quit = false;
+    uint64_t _generation = 0;
+    uint32_t _active_workers = 0;
+
+    // The current range, written under the mutex before _generation moves.
+    const std::function<void(uint32_t, uint32_t)>* _job = nullptr;
+    uint32_t _count = 0;
+    uint32_t _chunk_size = 0;
+    uint32_t _chunk_count = 0;
+    std::atomic<uint32_t> _next_chunk { 0 };
+};
@@ -0,0 +1,173 @@
+#include "lod_selector.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define LOD_SELECTOR_SSE 1
+#include <emmintrin.h>
+#endif
+
+constexpr uint32_t NO_OBJECT = UINT32_MAX;
+// Cameras inside an object's bounds see it at this distance.
+constexpr float LOD_NEAR_DISTANCE = 0.01f;
+
+LodSelector::LodSelector()
+{
+}
+
+LodSelector::~LodSelector()
+{
+}
+
+int LodSelector::create_object(const float* lod_errors, uint32_t lod_count, float radius)
+{
+    int objectID = _handles.create();
+    if (objectID < 0) {
+        return -1;
+    }
+    _x.push_back(0.0f);
+    _y.push_back(0.0f);
+    _z.push_back(0.0f);
+    _radius.push_back(radius);
+    _scale.push_back(1.0f);
+    // Selection counts passing levels, which needs errors that never shrink down the chain.
+    float error = 0.0f;
+    for (uint32_t level = 1; level < MESH_MAX_LODS; ++level) {
+        if (level < lod_count) {
+            error = std::max(error, lod_errors[level]);
+            _error[level - 1].push_back(error);
+        }
+        else {
+            _error[level - 1].push_back(INFINITY);
+        }
+    }
+    _lod.push_back(0);
+    return objectID;
+}
+
+void LodSelector::destroy_object(int objectID)
+{
+    uint32_t dense = _handles.find(objectID);
+    if (dense != NO_OBJECT) {
+        _remove_dense(dense);
+    }
+}
+
+void LodSelector::set_object_transform(int objectID, float x, float y, float z, float scale)
+{
+    uint32_t dense = _handles.find(objectID);
+    if (dense == NO_OBJECT) {
+        return;
+    }
+    _x[dense] = x;
+    _y[dense] = y;
+    _z[dense] = z;
+    _scale[dense] = scale;
+}
+
+void LodSelector::set_view(const float position[3], float viewport_height, float vertical_fov)
+{
+    for (uint32_t i = 0; i < 3; ++i) {
+        _view_position[i] = position[i];
+    }
+    _projection_scale = viewport_height / (2.0f * std::tan(vertical_fov * 0.5f));
+}
+
+void LodSelector::set_threshold(float pixels, float hysteresis)
+{
+    _threshold = pixels;
+    _hysteresis = hysteresis;
+}
+
+void LodSelector::select()
+{
+    // A level's error covers error * scale * projection_scale / distance pixels, distance taken
+    // to the bounding sphere. The chosen level is the number of coarser levels within the
+    // threshold. Levels past the current one must also clear the hysteresis margin.
+    uint32_t count = _handles.size();
+    float coarsen_threshold = _threshold * (1.0f - _hysteresis);
+    uint32_t i = 0;
+#if LOD_SELECTOR_SSE
+    __m128 view_x = _mm_set1_ps(_view_position[0]);
+    __m128 view_y = _mm_set1_ps(_view_position[1]);
+    __m128 view_z = _mm_set1_ps(_view_position[2]);
+    __m128 projection_scale = _mm_set1_ps(_projection_scale);
+    __m128 near_distance = _mm_set1_ps(LOD_NEAR_DISTANCE);
+    __m128 threshold = _mm_set1_ps(_threshold);
+    __m128 coarsen = _mm_set1_ps(coarsen_threshold);
+    for (; i + 4 <= count; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(&_x[i]), view_x);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(&_y[i]), view_y);
+        __m128 dz = _mm_sub_ps(_mm_loadu_ps(&_z[i]), view_z);
+        __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+        __m128 radius = _mm_mul_ps(_mm_loadu_ps(&_radius[i]), _mm_loadu_ps(&_scale[i]));
+        distance = _mm_max_ps(_mm_sub_ps(distance, radius), near_distance);
+        __m128 pixels_per_unit = _mm_div_ps(_mm_mul_ps(projection_scale, _mm_loadu_ps(&_scale[i])), distance);
+
+        __m128i current = _mm_loadu_si128((const __m128i*)&_lod[i]);
+        __m128i selected = _mm_setzero_si128();
+        for (uint32_t level = 1; level < MESH_MAX_LODS; ++level) {
+            __m128 pixels = _mm_mul_ps(_mm_loadu_ps(&_error[level - 1][i]), pixels_per_unit);
+            __m128 coarser = _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_set1_epi32((int)level), current));
+            __m128 limit = _mm_or_ps(_mm_and_ps(coarser, coarsen), _mm_andnot_ps(coarser, threshold));
+            // The mask is -1 per passing lane.
+            selected = _mm_sub_epi32(selected, _mm_castps_si128(_mm_cmple_ps(pixels, limit)));
+        }
+        _mm_storeu_si128((__m128i*)&_lod[i], selected);
+    }
+#endif
+    for (; i < count; ++i) {
+        float dx = _x[i] - _view_position[0];
+        float dy = _y[i] - _view_position[1];
+        float dz = _z[i] - _view_position[2];
+        float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+        distance = std::max(distance - _radius[i] * _scale[i], LOD_NEAR_DISTANCE);
+        float pixels_per_unit = _projection_scale * _scale[i] / distance;
+
+        int32_t selected = 0;
+        for (uint32_t level = 1; level < MESH_MAX_LODS; ++level) {
+            float limit = (int32_t)level > _lod[i] ? coarsen_threshold : _threshold;
+            selected += _error[level - 1][i] * pixels_per_unit <= limit ? 1 : 0;
+        }
+        _lod[i] = selected;
+    }
+}
+
+uint32_t LodSelector::get_lod(int objectID) const
+{
+    uint32_t dense = _handles.find(objectID);
+    return dense != NO_OBJECT ? (uint32_t)_lod[dense] : 0;
+}
+
+uint32_t LodSelector::get_object_count() const
+{
+    return _handles.size();
+}
+
+void LodSelector::_remove_dense(uint32_t dense)
+{
+    // Swap with the last object to keep the arrays packed.
+    uint32_t last = _handles.size() - 1;
+    if (dense != last) {
+        _x[dense] = _x[last];
+        _y[dense] = _y[last];
+        _z[dense] = _z[last];
+        _radius[dense] = _radius[last];
+        _scale[dense] = _scale[last];
+        for (auto& error : _error) {
+            error[dense] = error[last];
+        }
+        _lod[dense] = _lod[last];
+    }
+    _x.pop_back();
+    _y.pop_back();
+    _z.pop_back();
+    _radius.pop_back();
+    _scale.pop_back();
+    for (auto& error : _error) {
+        error.pop_back();
+    }
+    _lod.pop_back();
+    _handles.remove(dense);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "handle_table.h"
+#include "mesh_file.h"
+
+// Pixel error above which a coarser level is not used.
+constexpr float LOD_DEFAULT_THRESHOLD = 1.0f;
+// A level is only taken coarser once its error is this share below the
+// threshold, so objects near the switch distance don't flip every frame.
+constexpr float LOD_DEFAULT_HYSTERESIS = 0.25f;
+
+// Picks a level of detail per object from the screen space size of each
+// level's simplification error. Objects are kept as packed arrays
+// (structure of arrays) and select() projects the errors of four objects
+// at a time with SSE. Call select() once per frame while building the draw
+// list and submit the DrawMesh of get_lod() for each object.
+class LodSelector {
+public:
+    LodSelector();
+    ~LodSelector();
+
+    // lod_errors holds lod_count object space errors, as from Mesh::get_lod_error().
+    // radius bounds the mesh around position, scale is its uniform world scale.
+    int create_object(const float* lod_errors, uint32_t lod_count, float radius);
+    void destroy_object(int objectID);
+    void set_object_transform(int objectID, float x, float y, float z, float scale);
+
+    void set_view(const float position[3], float viewport_height, float vertical_fov);
+    void set_threshold(float pixels, float hysteresis);
+
+    void select();
+
+    uint32_t get_lod(int objectID) const;
+    uint32_t get_object_count() const;
+
+private:
+    void _remove_dense(uint32_t dense);
+
+    HandleTable<16> _handles;
+
+    // Dense arrays, one entry per live object.
+    std::vector<float> _x;
+    std::vector<float> _y;
+    std::vector<float> _z;
+    std::vector<float> _radius;
+    std::vector<float> _scale;
+    // Error of level l + 1 per object, infinite past the object's last level.
+    std::vector<float> _error[MESH_MAX_LODS - 1];
+    std::vector<int32_t> _lod;
+
+    float _view_position[3] = {};
+    // Pixels covered by one unit at distance one.
+    float _projection_scale = 1.0f;
+    float _threshold = LOD_DEFAULT_THRESHOLD;
+    float _hysteresis = LOD_DEFAULT_HYSTERESIS;
+};
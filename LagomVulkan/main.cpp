@@ -1,8 +1,12 @@
+#include "BUILD_OPTIONS.h"
 #include "renderer.h"
 #include "window.h"
 #include "shared.h"
 #include "locator.h"
 #include "audio_open_al.h"
+#include "uniform_ring.h"
+#include "draw_list.h"
+#include "dynamic_resolution.h"
 #include <array>
 #include <chrono>
 
@@ -42,6 +46,15 @@ int main() {
     semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
     vkCreateSemaphore(r.get_vulkan_device(), &semaphore_create_info, nullptr, &render_complete_semaphore);
 
+    // Per-draw constants, 1 MB per frame.
+    UniformRing uniform_ring(&r, 1 << 20, 2);
+    DrawList draw_list(&uniform_ring, 64);
+
+#if BUILD_ENABLE_DYNAMIC_RESOLUTION
+    // Same attachment formats as the window's render pass, so pipelines stay compatible.
+    DynamicResolution dynamic_resolution(&r, w, 1000.0f / 60.0f, 0.5f);
+#endif
+
     float color_rotation = 0.0f;
     auto timer = std::chrono::steady_clock();
     auto last_time = timer.now();
@@ -60,19 +73,28 @@ int main() {
 
         // Begin render
         w->begin_render();
+        uniform_ring.begin_frame();
+        draw_list.clear();
         // Record command buffer
         VkCommandBufferBeginInfo command_buffer_begin_info{};
         command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
         command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
         error_check(vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info));
 
+#if BUILD_ENABLE_DYNAMIC_RESOLUTION
+        dynamic_resolution.begin_frame(command_buffer);
+        VkRect2D render_area = dynamic_resolution.get_render_area();
+#else
         VkRect2D render_area{};
         render_area.offset.x = 0;
         render_area.offset.y = 0;
         render_area.extent = w->get_vulkan_surface_size();
+#endif
 
         color_rotation += 0.01f;
 
+        draw_list.build();
+
         std::array<VkClearValue, 2> clear_values{};
         clear_values[0].depthStencil.depth = 0.0f;
         clear_values[0].depthStencil.stencil = 0;
@@ -83,17 +105,29 @@ int main() {
 
         VkRenderPassBeginInfo render_pass_begin_info{};
         render_pass_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+#if BUILD_ENABLE_DYNAMIC_RESOLUTION
+        render_pass_begin_info.renderPass = dynamic_resolution.get_vulkan_render_pass();
+        render_pass_begin_info.framebuffer = dynamic_resolution.get_vulkan_framebuffer();
+#else
         render_pass_begin_info.renderPass = w->get_vulkan_render_pass();
         render_pass_begin_info.framebuffer = w->get_vulkan_active_framebuffer();
+#endif
         render_pass_begin_info.renderArea = render_area;
         render_pass_begin_info.clearValueCount = (uint32_t)clear_values.size();
         render_pass_begin_info.pClearValues = clear_values.data();
 
         vkCmdBeginRenderPass(command_buffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
 
+        draw_list.record(command_buffer);
+
         vkCmdEndRenderPass(command_buffer);
 
+#if BUILD_ENABLE_DYNAMIC_RESOLUTION
+        dynamic_resolution.end_frame(command_buffer);
+#endif
+
         error_check(vkEndCommandBuffer(command_buffer));
+        uniform_ring.flush();
         // Submit command buffer
         VkSubmitInfo submit_info{};
         submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
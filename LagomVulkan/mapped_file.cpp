@@ -0,0 +1,128 @@
+#include "mapped_file.h"
+
+#if defined( _WIN32 )
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#if defined( _WIN32 )
+
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER file_size{};
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    _file = file;
+    _mapping = mapping;
+    _data = (const uint8_t*)view;
+    _size = (size_t)file_size.QuadPart;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (_data != nullptr) {
+        UnmapViewOfFile(_data);
+    }
+    if (_mapping != nullptr) {
+        CloseHandle(_mapping);
+    }
+    if (_file != nullptr) {
+        CloseHandle(_file);
+    }
+    _data = nullptr;
+    _size = 0;
+    _mapping = nullptr;
+    _file = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+
+    int file = ::open(filename.c_str(), O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+
+    struct stat file_stat{};
+    if (fstat(file, &file_stat) != 0 || file_stat.st_size == 0) {
+        ::close(file);
+        return false;
+    }
+
+    void* view = mmap(nullptr, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    // The mapping keeps its own reference to the file.
+    ::close(file);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+
+    _data = (const uint8_t*)view;
+    _size = (size_t)file_stat.st_size;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (_data != nullptr) {
+        munmap((void*)_data, _size);
+    }
+    _data = nullptr;
+    _size = 0;
+}
+
+#endif
+
+bool MappedFile::is_open() const
+{
+    return _data != nullptr;
+}
+
+const uint8_t* MappedFile::get_data() const
+{
+    return _data;
+}
+
+size_t MappedFile::get_size() const
+{
+    return _size;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// Read-only memory mapping of a whole file. The mapping stays valid until
+// close() or destruction, so parsers can hand out pointers straight into it.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& filename);
+    void close();
+
+    bool is_open() const;
+    const uint8_t* get_data() const;
+    size_t get_size() const;
+
+private:
+    const uint8_t* _data = nullptr;
+    size_t _size = 0;
+
+#if defined( _WIN32 )
+    void* _file = nullptr;
+    void* _mapping = nullptr;
+#endif
+};
@@ -0,0 +1,165 @@
+#include "mesh.h"
+#include "renderer.h"
+#include "shared.h"
+
+#include <cstddef>
+#include <cstring>
+
+Mesh::Mesh(Renderer* renderer, const MeshFile& file)
+{
+    _renderer = renderer;
+    _lod_count = file.header->lod_count;
+    for (uint32_t lod = 0; lod < _lod_count; ++lod) {
+        _lods[lod] = file.lods[lod];
+    }
+    for (int i = 0; i < 3; ++i) {
+        _position_center[i] = file.header->position_center[i];
+        _position_extent[i] = file.header->position_extent[i];
+    }
+    _index_type = file.header->index_size == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+
+    _init_buffers(file);
+}
+
+Mesh::~Mesh()
+{
+    _deinit_buffers();
+}
+
+uint32_t Mesh::get_lod_count() const
+{
+    return _lod_count;
+}
+
+float Mesh::get_lod_error(uint32_t lod) const
+{
+    return _lods[lod].error;
+}
+
+DrawMesh Mesh::get_draw_mesh(uint32_t lod) const
+{
+    DrawMesh draw_mesh;
+    draw_mesh.vertex_buffer = _vertex_buffer;
+    draw_mesh.index_buffer = _index_buffer;
+    draw_mesh.index_type = _index_type;
+    draw_mesh.index_count = _lods[lod].index_count;
+    draw_mesh.first_index = _lods[lod].first_index;
+    draw_mesh.vertex_offset = 0;
+    return draw_mesh;
+}
+
+const float * Mesh::get_position_center() const
+{
+    return _position_center;
+}
+
+const float * Mesh::get_position_extent() const
+{
+    return _position_extent;
+}
+
+VkVertexInputBindingDescription Mesh::get_vulkan_binding_description(uint32_t binding)
+{
+    VkVertexInputBindingDescription binding_description{};
+    binding_description.binding = binding;
+    binding_description.stride = sizeof(MeshVertex);
+    binding_description.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    return binding_description;
+}
+
+std::array<VkVertexInputAttributeDescription, 3> Mesh::get_vulkan_attribute_descriptions(uint32_t binding)
+{
+    std::array<VkVertexInputAttributeDescription, 3> attribute_descriptions{};
+    attribute_descriptions[0].location = 0;
+    attribute_descriptions[0].binding = binding;
+    attribute_descriptions[0].format = VK_FORMAT_R16G16B16A16_SNORM;
+    attribute_descriptions[0].offset = offsetof(MeshVertex, position);
+    attribute_descriptions[1].location = 1;
+    attribute_descriptions[1].binding = binding;
+    attribute_descriptions[1].format = VK_FORMAT_R16G16_SNORM;
+    attribute_descriptions[1].offset = offsetof(MeshVertex, normal);
+    attribute_descriptions[2].location = 2;
+    attribute_descriptions[2].binding = binding;
+    attribute_descriptions[2].format = VK_FORMAT_R16G16_SFLOAT;
+    attribute_descriptions[2].offset = offsetof(MeshVertex, uv);
+    return attribute_descriptions;
+}
+
+void Mesh::_init_buffers(const MeshFile& file)
+{
+    VkDevice device = _renderer->get_vulkan_device();
+    const VkPhysicalDeviceMemoryProperties* memory_properties = &_renderer->get_vulkan_physical_device_memory_properties();
+    VkDeviceSize vertex_bytes = (VkDeviceSize)file.header->vertex_count * sizeof(MeshVertex);
+    VkDeviceSize index_bytes = (VkDeviceSize)file.header->index_count * file.header->index_size;
+
+    create_buffer(device, memory_properties, vertex_bytes, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &_vertex_buffer, &_vertex_buffer_memory);
+    create_buffer(device, memory_properties, index_bytes, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &_index_buffer, &_index_buffer_memory);
+
+    VkBuffer staging_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory staging_memory = VK_NULL_HANDLE;
+    create_buffer(device, memory_properties, vertex_bytes + index_bytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &staging_buffer, &staging_memory);
+    unsigned char* mapped = nullptr;
+    error_check(vkMapMemory(device, staging_memory, 0, VK_WHOLE_SIZE, 0, (void**)&mapped));
+    std::memcpy(mapped, file.vertices, (size_t)vertex_bytes);
+    std::memcpy(mapped + vertex_bytes, file.indices, (size_t)index_bytes);
+    vkUnmapMemory(device, staging_memory);
+
+    VkCommandPool command_pool = VK_NULL_HANDLE;
+    VkCommandPoolCreateInfo pool_create_info{};
+    pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    pool_create_info.queueFamilyIndex = _renderer->get_vulkan_graphics_family_index();
+    error_check(vkCreateCommandPool(device, &pool_create_info, nullptr, &command_pool));
+
+    VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+    VkCommandBufferAllocateInfo command_buffer_allocate_info{};
+    command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    command_buffer_allocate_info.commandPool = command_pool;
+    command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    command_buffer_allocate_info.commandBufferCount = 1;
+    error_check(vkAllocateCommandBuffers(device, &command_buffer_allocate_info, &command_buffer));
+
+    VkCommandBufferBeginInfo command_buffer_begin_info{};
+    command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    error_check(vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info));
+
+    VkBufferCopy vertex_copy{};
+    vertex_copy.size = vertex_bytes;
+    vkCmdCopyBuffer(command_buffer, staging_buffer, _vertex_buffer, 1, &vertex_copy);
+    VkBufferCopy index_copy{};
+    index_copy.srcOffset = vertex_bytes;
+    index_copy.size = index_bytes;
+    vkCmdCopyBuffer(command_buffer, staging_buffer, _index_buffer, 1, &index_copy);
+
+    error_check(vkEndCommandBuffer(command_buffer));
+
+    VkFence fence = VK_NULL_HANDLE;
+    VkFenceCreateInfo fence_create_info{};
+    fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    error_check(vkCreateFence(device, &fence_create_info, nullptr, &fence));
+
+    VkSubmitInfo submit_info{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &command_buffer;
+    error_check(vkQueueSubmit(_renderer->get_vulkan_queue(), 1, &submit_info, fence));
+    error_check(vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX));
+
+    vkDestroyFence(device, fence, nullptr);
+    vkDestroyCommandPool(device, command_pool, nullptr);
+    vkFreeMemory(device, staging_memory, nullptr);
+    vkDestroyBuffer(device, staging_buffer, nullptr);
+}
+
+void Mesh::_deinit_buffers()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+    vkFreeMemory(device, _index_buffer_memory, nullptr);
+    vkDestroyBuffer(device, _index_buffer, nullptr);
+    vkFreeMemory(device, _vertex_buffer_memory, nullptr);
+    vkDestroyBuffer(device, _vertex_buffer, nullptr);
+}
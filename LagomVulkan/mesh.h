@@ -0,0 +1,49 @@
+#pragma once
+#include "platform.h"
+#include "draw_list.h"
+#include "mesh_file.h"
+
+#include <array>
+
+class Renderer;
+
+// Baked mesh in device local vertex and index buffers. The constructor
+// uploads through a staging buffer and waits for the copy, so load
+// meshes at level load rather than mid frame.
+class Mesh {
+public:
+    Mesh(Renderer* renderer, const MeshFile& file);
+    ~Mesh();
+
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+
+    uint32_t get_lod_count() const;
+    float get_lod_error(uint32_t lod) const;
+    DrawMesh get_draw_mesh(uint32_t lod) const;
+
+    // Dequantization for the vertex shader: position = center + snorm * extent.
+    const float* get_position_center() const;
+    const float* get_position_extent() const;
+
+    // Vertex input for pipelines drawing MeshVertex: position at location 0, normal 1, uv 2.
+    static VkVertexInputBindingDescription get_vulkan_binding_description(uint32_t binding);
+    static std::array<VkVertexInputAttributeDescription, 3> get_vulkan_attribute_descriptions(uint32_t binding);
+
+private:
+    void _init_buffers(const MeshFile& file);
+    void _deinit_buffers();
+
+    Renderer* _renderer = nullptr;
+
+    VkBuffer _vertex_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory _vertex_buffer_memory = VK_NULL_HANDLE;
+    VkBuffer _index_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory _index_buffer_memory = VK_NULL_HANDLE;
+    VkIndexType _index_type = VK_INDEX_TYPE_UINT16;
+
+    uint32_t _lod_count = 0;
+    std::array<MeshFileLod, MESH_MAX_LODS> _lods = {};
+    float _position_center[3] = {};
+    float _position_extent[3] = {};
+};
@@ -0,0 +1,164 @@
+#include "mesh_file.h"
+
+#include <cmath>
+#include <string.h>
+
+size_t get_mesh_vertex_offset(uint32_t lod_count)
+{
+    size_t offset = sizeof(MeshFileHeader) + lod_count * sizeof(MeshFileLod);
+    return (offset + 15) & ~(size_t)15;
+}
+
+bool parse_mesh(const uint8_t* data, size_t size, MeshFile* mesh)
+{
+    if (size < sizeof(MeshFileHeader)) {
+        return false;
+    }
+    const MeshFileHeader* header = (const MeshFileHeader*)data;
+    if (header->magic != MESH_FILE_MAGIC || header->version != MESH_FILE_VERSION ||
+        (header->index_size != 2 && header->index_size != 4) ||
+        header->lod_count == 0 || header->lod_count > MESH_MAX_LODS) {
+        return false;
+    }
+
+    // 64-bit so the sizes can't wrap on 32-bit builds.
+    uint64_t vertex_offset = get_mesh_vertex_offset(header->lod_count);
+    uint64_t index_offset = vertex_offset + (uint64_t)header->vertex_count * sizeof(MeshVertex);
+    if (header->vertex_count == 0 || header->index_count == 0 ||
+        index_offset + (uint64_t)header->index_count * header->index_size > size) {
+        return false;
+    }
+
+    // Checked once here, draws index the vertex buffer without further checks.
+    const uint8_t* indices = data + index_offset;
+    for (uint32_t i = 0; i < header->index_count; ++i) {
+        uint32_t index = header->index_size == 2 ? ((const uint16_t*)indices)[i] : ((const uint32_t*)indices)[i];
+        if (index >= header->vertex_count) {
+            return false;
+        }
+    }
+
+    const MeshFileLod* lods = (const MeshFileLod*)(data + sizeof(MeshFileHeader));
+    for (uint32_t lod = 0; lod < header->lod_count; ++lod) {
+        if (lods[lod].first_index > header->index_count || lods[lod].index_count > header->index_count - lods[lod].first_index) {
+            return false;
+        }
+    }
+
+    mesh->header = header;
+    mesh->lods = lods;
+    mesh->vertices = (const MeshVertex*)(data + vertex_offset);
+    mesh->indices = indices;
+    return true;
+}
+
+static int16_t to_snorm16(float value)
+{
+    value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+    return (int16_t)std::lround(value * 32767.0f);
+}
+
+void encode_octahedral(const float normal[3], int16_t encoded[2])
+{
+    float length = std::fabs(normal[0]) + std::fabs(normal[1]) + std::fabs(normal[2]);
+    if (length <= 0.0f) {
+        encoded[0] = 0;
+        encoded[1] = 0;
+        return;
+    }
+    float x = normal[0] / length;
+    float y = normal[1] / length;
+    // Fold the lower hemisphere over the diagonals.
+    if (normal[2] < 0.0f) {
+        float folded_x = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float folded_y = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = folded_x;
+        y = folded_y;
+    }
+    encoded[0] = to_snorm16(x);
+    encoded[1] = to_snorm16(y);
+}
+
+void decode_octahedral(const int16_t encoded[2], float normal[3])
+{
+    float x = encoded[0] / 32767.0f;
+    float y = encoded[1] / 32767.0f;
+    float z = 1.0f - std::fabs(x) - std::fabs(y);
+    if (z < 0.0f) {
+        float unfolded_x = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float unfolded_y = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = unfolded_x;
+        y = unfolded_y;
+    }
+    float length = std::sqrt(x * x + y * y + z * z);
+    normal[0] = x / length;
+    normal[1] = y / length;
+    normal[2] = z / length;
+}
+
+uint16_t float_to_half(float value)
+{
+    uint32_t bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (((bits >> 23) & 0xFF) == 0xFF) {
+        return (uint16_t)(sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0));
+    }
+    if (exponent >= 31) {
+        return (uint16_t)(sign | 0x7C00);
+    }
+    if (exponent <= 0) {
+        // Denormal or zero.
+        if (exponent < -10) {
+            return (uint16_t)sign;
+        }
+        mantissa |= 0x800000;
+        uint32_t shift = (uint32_t)(14 - exponent);
+        uint32_t half_mantissa = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1) {
+            ++half_mantissa;
+        }
+        return (uint16_t)(sign | half_mantissa);
+    }
+
+    uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+    // Round to nearest, a carry into the exponent is still the right answer.
+    if (mantissa & 0x1000) {
+        ++half;
+    }
+    return (uint16_t)half;
+}
+
+float half_to_float(uint16_t value)
+{
+    uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x3FF;
+    uint32_t bits = 0;
+    if (exponent == 0) {
+        if (mantissa == 0) {
+            bits = sign;
+        }
+        else {
+            // Normalize the denormal.
+            exponent = 127 - 15 + 1;
+            while ((mantissa & 0x400) == 0) {
+                mantissa <<= 1;
+                --exponent;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+        }
+    }
+    else if (exponent == 31) {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+    float result = 0.0f;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+constexpr uint32_t MESH_FILE_MAGIC = 0x48534D4C; // "LMSH"
+constexpr uint32_t MESH_FILE_VERSION = 1;
+constexpr uint32_t MESH_MAX_LODS = 8;
+
+// 16 bytes per vertex against 32 for float positions, normals and UVs.
+// Positions are snorm inside the mesh bounds: center + value * extent.
+// Normals are octahedral, decode with decode_octahedral. UVs are half
+// floats so tiling coordinates outside [0, 1] survive.
+struct MeshVertex {
+    // w is padding, three component 16-bit vertex formats are poorly supported.
+    int16_t position[4];
+    int16_t normal[2];
+    uint16_t uv[2];
+};
+
+#pragma pack(push, 1)
+// Header, LOD table, vertices at a 16 byte boundary, then the indices.
+struct MeshFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertex_count;
+    uint32_t index_count;
+    // 2 or 4.
+    uint32_t index_size;
+    uint32_t lod_count;
+    float position_center[3];
+    float position_extent[3];
+};
+
+// Index range of one level of detail, all levels share the vertices.
+struct MeshFileLod {
+    uint32_t first_index;
+    uint32_t index_count;
+    // Object space error of the simplified level, 0 for the full mesh.
+    float error;
+    uint32_t reserved;
+};
+#pragma pack(pop)
+
+// Points into the memory that was parsed, nothing is copied.
+struct MeshFile {
+    const MeshFileHeader* header = nullptr;
+    const MeshFileLod* lods = nullptr;
+    const MeshVertex* vertices = nullptr;
+    const uint8_t* indices = nullptr;
+};
+
+size_t get_mesh_vertex_offset(uint32_t lod_count);
+
+// Rejects empty meshes and indices past the vertex count.
+bool parse_mesh(const uint8_t* data, size_t size, MeshFile* mesh);
+
+void encode_octahedral(const float normal[3], int16_t encoded[2]);
+void decode_octahedral(const int16_t encoded[2], float normal[3]);
+uint16_t float_to_half(float value);
+float half_to_float(uint16_t value);
@@ -0,0 +1,88 @@
+#include "mix_kernels.h"
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define MIX_KERNELS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined( __AVX__ )
+#define MIX_KERNELS_AVX 1
+#include <immintrin.h>
+#endif
+
+void mix_mono_to_stereo(float* bus, const float* source, uint32_t frame_count, float gain_left, float gain_right)
+{
+    uint32_t i = 0;
+#if MIX_KERNELS_AVX
+    __m256 gains8 = _mm256_setr_ps(gain_left, gain_right, gain_left, gain_right, gain_left, gain_right, gain_left, gain_right);
+    for (; i + 8 <= frame_count; i += 8) {
+        __m256 samples = _mm256_loadu_ps(source + i);
+        // Duplicate every sample into a left/right pair, unpack works per 128-bit lane.
+        __m256 low = _mm256_unpacklo_ps(samples, samples);
+        __m256 high = _mm256_unpackhi_ps(samples, samples);
+        __m256 first = _mm256_permute2f128_ps(low, high, 0x20);
+        __m256 second = _mm256_permute2f128_ps(low, high, 0x31);
+        float* out = bus + i * 2;
+        _mm256_storeu_ps(out, _mm256_add_ps(_mm256_loadu_ps(out), _mm256_mul_ps(first, gains8)));
+        _mm256_storeu_ps(out + 8, _mm256_add_ps(_mm256_loadu_ps(out + 8), _mm256_mul_ps(second, gains8)));
+    }
+#endif
+#if MIX_KERNELS_SSE2
+    __m128 gains = _mm_setr_ps(gain_left, gain_right, gain_left, gain_right);
+    for (; i + 4 <= frame_count; i += 4) {
+        __m128 samples = _mm_loadu_ps(source + i);
+        __m128 low = _mm_unpacklo_ps(samples, samples);
+        __m128 high = _mm_unpackhi_ps(samples, samples);
+        float* out = bus + i * 2;
+        _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_mul_ps(low, gains)));
+        _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_mul_ps(high, gains)));
+    }
+#endif
+    for (; i < frame_count; ++i) {
+        bus[i * 2 + 0] += source[i] * gain_left;
+        bus[i * 2 + 1] += source[i] * gain_right;
+    }
+}
+
+void mix_stereo_to_stereo(float* bus, const float* source, uint32_t frame_count, float gain_left, float gain_right)
+{
+    uint32_t i = 0;
+    uint32_t sample_count = frame_count * 2;
+#if MIX_KERNELS_AVX
+    __m256 gains8 = _mm256_setr_ps(gain_left, gain_right, gain_left, gain_right, gain_left, gain_right, gain_left, gain_right);
+    for (; i + 8 <= sample_count; i += 8) {
+        _mm256_storeu_ps(bus + i, _mm256_add_ps(_mm256_loadu_ps(bus + i), _mm256_mul_ps(_mm256_loadu_ps(source + i), gains8)));
+    }
+#endif
+#if MIX_KERNELS_SSE2
+    __m128 gains = _mm_setr_ps(gain_left, gain_right, gain_left, gain_right);
+    for (; i + 4 <= sample_count; i += 4) {
+        _mm_storeu_ps(bus + i, _mm_add_ps(_mm_loadu_ps(bus + i), _mm_mul_ps(_mm_loadu_ps(source + i), gains)));
+    }
+#endif
+    for (; i < sample_count; i += 2) {
+        bus[i + 0] += source[i + 0] * gain_left;
+        bus[i + 1] += source[i + 1] * gain_right;
+    }
+}
+
+void convert_float_to_s16(int16_t* output, const float* input, uint32_t sample_count)
+{
+    uint32_t i = 0;
+#if MIX_KERNELS_SSE2
+    __m128 scale = _mm_set1_ps(32767.0f);
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 minus_one = _mm_set1_ps(-1.0f);
+    for (; i + 8 <= sample_count; i += 8) {
+        __m128 a = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(input + i), minus_one), one);
+        __m128 b = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(input + i + 4), minus_one), one);
+        __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(a, scale)), _mm_cvtps_epi32(_mm_mul_ps(b, scale)));
+        _mm_storeu_si128((__m128i*)(output + i), packed);
+    }
+#endif
+    for (; i < sample_count; ++i) {
+        float sample = input[i];
+        sample = sample > 1.0f ? 1.0f : (sample < -1.0f ? -1.0f : sample);
+        output[i] = (int16_t)(sample * 32767.0f + (sample >= 0.0f ? 0.5f : -0.5f));
+    }
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <stdint.h>
+
+// Accumulation kernels for the software mixer. The bus is interleaved
+// stereo float. SSE versions are used wherever SSE2 is available and AVX
+// ones when the compiler targets AVX, the scalar code handles the tails.
+
+// bus[2i] += source[i] * gain_left, bus[2i + 1] += source[i] * gain_right
+void mix_mono_to_stereo(float* bus, const float* source, uint32_t frame_count, float gain_left, float gain_right);
+
+// bus[2i] += source[2i] * gain_left, bus[2i + 1] += source[2i + 1] * gain_right
+void mix_stereo_to_stereo(float* bus, const float* source, uint32_t frame_count, float gain_left, float gain_right);
+
+// Clamps to [-1, 1] and scales to signed 16-bit.
+void convert_float_to_s16(int16_t* output, const float* input, uint32_t sample_count);
@@ -8,6 +8,7 @@
 #include <iostream>
 #include <assert.h>
 #include <sstream>
+#include <cstring>
 
 Renderer::Renderer()
 {
@@ -66,6 +67,16 @@ const uint32_t Renderer::get_vulkan_graphics_family_index() const
     return _graphics_family_index;
 }
 
+const VkQueue Renderer::get_vulkan_compute_queue() const
+{
+    return _compute_queue;
+}
+
+const uint32_t Renderer::get_vulkan_compute_family_index() const
+{
+    return _compute_family_index;
+}
+
 const VkPhysicalDeviceProperties & Renderer::get_vulkan_physical_device_properties() const
 {
     return _gpu_properties;
@@ -76,6 +87,21 @@ const VkPhysicalDeviceMemoryProperties & Renderer::get_vulkan_physical_device_me
     return _gpu_memory_properties;
 }
 
+const VkPhysicalDeviceFeatures & Renderer::get_vulkan_enabled_features() const
+{
+    return _enabled_features;
+}
+
+bool Renderer::is_device_extension_enabled(const char * extension_name) const
+{
+    for (const char* extension : _device_extensions) {
+        if (std::strcmp(extension, extension_name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void Renderer::_setup_layers_and_extensions()
 {
     //_instance_extensions.push_back(VK_KHR_DISPLAY_EXTENSION_NAME);
@@ -83,6 +109,10 @@ void Renderer::_setup_layers_and_extensions()
     _instance_extensions.push_back(PLATFORM_SURFACE_EXTENSION_NAME);
 
     _device_extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+
+    // Enabled only when the device supports them.
+    _optional_device_extensions.push_back("VK_KHR_draw_indirect_count");
+    _optional_device_extensions.push_back("VK_AMD_draw_indirect_count");
 }
 
 void Renderer::_init_instance()
@@ -142,6 +172,16 @@ void Renderer::_init_device()
             assert(0 && "[Vulkan:Error] Queue family supporting graphics bit not found.");
             std::exit(-1);
         }
+
+        // A compute only family runs alongside graphics work, fall back to the graphics queue.
+        _compute_family_index = _graphics_family_index;
+        for (size_t i = 0; i < family_count; ++i) {
+            VkQueueFlags flags = family_property_list[i].queueFlags;
+            if ((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT)) {
+                _compute_family_index = (uint32_t)i;
+                break;
+            }
+        }
     }
     // List available instance layers installed in the system
     {
@@ -167,26 +207,53 @@ void Renderer::_init_device()
         }
         std::cout << std::endl;
     }
+    // Enable the optional device extensions we can get
+    {
+        uint32_t extension_count = 0;
+        vkEnumerateDeviceExtensionProperties(_gpu, nullptr, &extension_count, nullptr);
+        std::vector<VkExtensionProperties> extension_property_list(extension_count);
+        vkEnumerateDeviceExtensionProperties(_gpu, nullptr, &extension_count, extension_property_list.data());
+        for (const char* optional_extension : _optional_device_extensions) {
+            for (uint32_t i = 0; i < extension_count; ++i) {
+                if (std::strcmp(extension_property_list[i].extensionName, optional_extension) == 0) {
+                    _device_extensions.push_back(optional_extension);
+                    break;
+                }
+            }
+        }
+    }
+    // Enable the optional features we can get
+    {
+        VkPhysicalDeviceFeatures supported_features{};
+        vkGetPhysicalDeviceFeatures(_gpu, &supported_features);
+        _enabled_features.multiDrawIndirect = supported_features.multiDrawIndirect;
+        _enabled_features.drawIndirectFirstInstance = supported_features.drawIndirectFirstInstance;
+        _enabled_features.textureCompressionBC = supported_features.textureCompressionBC;
+    }
 
     float queue_priorities[] = { 1.0f };
-    VkDeviceQueueCreateInfo device_queue_create_info {};
-    device_queue_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-    device_queue_create_info.queueFamilyIndex = _graphics_family_index;
-    device_queue_create_info.queueCount = 1;
-    device_queue_create_info.pQueuePriorities = queue_priorities;
+    VkDeviceQueueCreateInfo device_queue_create_infos[2] {};
+    device_queue_create_infos[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    device_queue_create_infos[0].queueFamilyIndex = _graphics_family_index;
+    device_queue_create_infos[0].queueCount = 1;
+    device_queue_create_infos[0].pQueuePriorities = queue_priorities;
+    device_queue_create_infos[1] = device_queue_create_infos[0];
+    device_queue_create_infos[1].queueFamilyIndex = _compute_family_index;
 
     VkDeviceCreateInfo device_create_info{};
     device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-    device_create_info.queueCreateInfoCount = 1;
-    device_create_info.pQueueCreateInfos = &device_queue_create_info;
+    device_create_info.queueCreateInfoCount = _compute_family_index != _graphics_family_index ? 2 : 1;
+    device_create_info.pQueueCreateInfos = device_queue_create_infos;
     device_create_info.enabledLayerCount = (uint32_t)_device_layers.size();
     device_create_info.ppEnabledLayerNames = _device_layers.data();
     device_create_info.enabledExtensionCount = (uint32_t)_device_extensions.size();
     device_create_info.ppEnabledExtensionNames = _device_extensions.data();
+    device_create_info.pEnabledFeatures = &_enabled_features;
 
     error_check(vkCreateDevice(_gpu, &device_create_info, nullptr, &_device));
 
     vkGetDeviceQueue(_device, _graphics_family_index, 0, &_queue);
+    vkGetDeviceQueue(_device, _compute_family_index, 0, &_compute_queue);
 
 }
 
@@ -18,9 +18,15 @@ public:
     const VkDevice get_vulkan_device() const;
     const VkQueue get_vulkan_queue() const;
     const uint32_t get_vulkan_graphics_family_index() const;
+    // Dedicated compute queue when the device has one, the graphics queue otherwise.
+    const VkQueue get_vulkan_compute_queue() const;
+    const uint32_t get_vulkan_compute_family_index() const;
 
     const VkPhysicalDeviceProperties& get_vulkan_physical_device_properties() const;
     const VkPhysicalDeviceMemoryProperties &get_vulkan_physical_device_memory_properties() const;
+    const VkPhysicalDeviceFeatures& get_vulkan_enabled_features() const;
+
+    bool is_device_extension_enabled(const char* extension_name) const;
 
 private:
     void _setup_layers_and_extensions();
@@ -37,9 +43,12 @@ private:
     VkInstance _instance = VK_NULL_HANDLE;
     VkDevice _device = VK_NULL_HANDLE;
     VkQueue _queue = VK_NULL_HANDLE;
+    VkQueue _compute_queue = VK_NULL_HANDLE;
     VkPhysicalDeviceProperties _gpu_properties = {};
     VkPhysicalDeviceMemoryProperties _gpu_memory_properties = {};
+    VkPhysicalDeviceFeatures _enabled_features = {};
     uint32_t _graphics_family_index = 0;
+    uint32_t _compute_family_index = 0;
 
     Window* _window = nullptr;
 
@@ -47,6 +56,7 @@ private:
     std::vector<const char*> _instance_extensions;
     std::vector<const char*> _device_layers;
     std::vector<const char*> _device_extensions;
+    std::vector<const char*> _optional_device_extensions;
 
     VkDebugReportCallbackEXT _debug_report = VK_NULL_HANDLE;
     VkDebugReportCallbackCreateInfoEXT _debug_callback_create_info{};
@@ -0,0 +1,24 @@
+// Fragment side of clustered lighting, for #include (GL_GOOGLE_include_directive).
+// Bind ClusteredLighting's descriptor set and declare its buffers readonly
+// with the same layouts as cluster_lights.comp:
+//
+//     uint cluster = get_cluster_index(gl_FragCoord.xy, -view_position.z, ...);
+//     uvec2 range = clusters[cluster];
+//     for (uint i = 0; i < range.y; ++i) {
+//         Light light = lights[light_indices[range.x + i]];
+//         ...
+//     }
+
+struct Light {
+    vec4 position_radius;
+    vec4 color;
+};
+
+// view_depth is the positive distance along the view direction.
+uint get_cluster_index(vec2 frag_coord, float view_depth, vec2 viewport_size, uvec3 grid, float near, float far)
+{
+    uvec2 tile = min(uvec2(frag_coord / viewport_size * vec2(grid.xy)), grid.xy - 1);
+    float slice = log(max(view_depth, near) / near) / log(far / near) * float(grid.z);
+    uint z = min(uint(slice), grid.z - 1);
+    return tile.x + (tile.y + z * grid.y) * grid.x;
+}
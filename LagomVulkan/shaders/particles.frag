@@ -0,0 +1,18 @@
+#version 450
+
+// Round soft edged sprite for shaders/particles.vert, meant for additive or
+// alpha blending without depth writes.
+
+layout(location = 0) in vec4 in_color;
+layout(location = 1) in vec2 in_corner;
+
+layout(location = 0) out vec4 out_color;
+
+void main()
+{
+    float alpha = in_color.a * (1.0 - smoothstep(0.5, 1.0, length(in_corner)));
+    if (alpha <= 0.0) {
+        discard;
+    }
+    out_color = vec4(in_color.rgb, alpha);
+}
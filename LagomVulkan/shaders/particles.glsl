@@ -0,0 +1,27 @@
+// Vertex side of GpuParticles, for #include (GL_GOOGLE_include_directive).
+// Bind GpuParticles's descriptor set, declare the particles and the alive
+// list readonly with the same layouts as particles_simulate.comp, and draw
+// with GpuParticles::record_draw:
+//
+//     layout(std430, set = 0, binding = 1) readonly buffer Particles { Particle particles[]; };
+//     layout(std430, set = 0, binding = 3) readonly buffer AliveList { uint alive_count; uint alive_indices[]; };
+//
+//     Particle particle = particles[alive_indices[gl_InstanceIndex]];
+//     vec2 corner = get_particle_corner(gl_VertexIndex);
+//     vec3 position = particle.position_size.xyz + (camera_right * corner.x + camera_up * corner.y) * particle.position_size.w;
+
+struct Particle {
+    vec4 position_size;
+    // w is the remaining life in seconds.
+    vec4 velocity_life;
+    vec4 color;
+};
+
+// Two counter clockwise triangles spanning [-1, 1].
+vec2 get_particle_corner(uint vertex_index)
+{
+    const vec2 corners[6] = vec2[6](
+        vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+        vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+    return corners[vertex_index];
+}
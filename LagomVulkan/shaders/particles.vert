@@ -0,0 +1,37 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+// Camera facing quads for GpuParticles, drawn with GpuParticles::record_draw
+// and its descriptor set at set 0. One instance per live particle.
+
+#include "particles.glsl"
+
+layout(std430, set = 0, binding = 1) readonly buffer Particles {
+    Particle particles[];
+};
+
+layout(std430, set = 0, binding = 3) readonly buffer AliveList {
+    uint alive_count;
+    uint alive_indices[];
+};
+
+layout(push_constant) uniform Camera {
+    mat4 view_projection;
+    // World space axes of the screen, w unused.
+    vec4 right;
+    vec4 up;
+} camera;
+
+layout(location = 0) out vec4 out_color;
+layout(location = 1) out vec2 out_corner;
+
+void main()
+{
+    Particle particle = particles[alive_indices[gl_InstanceIndex]];
+    vec2 corner = get_particle_corner(gl_VertexIndex);
+    vec3 position = particle.position_size.xyz + (camera.right.xyz * corner.x + camera.up.xyz * corner.y) * particle.position_size.w;
+
+    out_color = particle.color;
+    out_corner = corner;
+    gl_Position = camera.view_projection * vec4(position, 1.0);
+}
@@ -1,6 +1,9 @@
 #include "BUILD_OPTIONS.h"
 #include "shared.h"
 
+#include <fstream>
+#include <vector>
+
 #if BUILD_ENABLE_VULKAN_RUNTIME_DEBUG
 void error_check(VkResult result) {
     if (result < 0) {
@@ -90,4 +93,79 @@ uint32_t find_memory_type_index(
 
 void error_check(VkResult result) {};
 
-#endif
\ No newline at end of file
+#endif
+
+void create_buffer(
+    VkDevice device,
+    const VkPhysicalDeviceMemoryProperties * gpu_memory_properties,
+    VkDeviceSize size,
+    VkBufferUsageFlags usage,
+    VkMemoryPropertyFlags required_properties,
+    VkBuffer * buffer,
+    VkDeviceMemory * memory,
+    uint32_t queue_family_count,
+    const uint32_t * queue_family_indices)
+{
+    VkBufferCreateInfo buffer_create_info{};
+    buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_create_info.size = size;
+    buffer_create_info.usage = usage;
+    buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (queue_family_count > 1) {
+        buffer_create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        buffer_create_info.queueFamilyIndexCount = queue_family_count;
+        buffer_create_info.pQueueFamilyIndices = queue_family_indices;
+    }
+    error_check(vkCreateBuffer(device, &buffer_create_info, nullptr, buffer));
+
+    VkMemoryRequirements memory_requirements{};
+    vkGetBufferMemoryRequirements(device, *buffer, &memory_requirements);
+    VkMemoryAllocateInfo memory_allocate_info{};
+    memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    memory_allocate_info.allocationSize = memory_requirements.size;
+    memory_allocate_info.memoryTypeIndex = find_memory_type_index(gpu_memory_properties, &memory_requirements, required_properties);
+    error_check(vkAllocateMemory(device, &memory_allocate_info, nullptr, memory));
+    error_check(vkBindBufferMemory(device, *buffer, *memory, 0));
+}
+
+VkShaderModule load_shader_module(VkDevice device, const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        std::cout << "Unable to open shader: " << filename << std::endl;
+        assert(0 && "Unable to open shader");
+        std::exit(-1);
+    }
+
+    // SPIR-V is a stream of 32 bit words.
+    size_t size = (size_t)file.tellg();
+    std::vector<uint32_t> code((size + 3) / 4);
+    file.seekg(0);
+    file.read((char*)code.data(), size);
+
+    return create_shader_module(device, code.data(), size);
+}
+
+VkShaderModule load_shader_module(VkDevice device, const AssetPack& pack, const std::string& name)
+{
+    AssetView view = pack.find(name);
+    if (!view.is_valid() || view.type != ASSET_TYPE_SPIRV) {
+        std::cout << "Shader not in asset pack: " << name << std::endl;
+        assert(0 && "Shader not in asset pack");
+        std::exit(-1);
+    }
+    // Blobs are pack aligned, so the words can be used in place.
+    return create_shader_module(device, (const uint32_t*)view.data, view.size);
+}
+
+VkShaderModule create_shader_module(VkDevice device, const uint32_t* code, size_t size)
+{
+    VkShaderModuleCreateInfo shader_module_create_info{};
+    shader_module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    shader_module_create_info.codeSize = size;
+    shader_module_create_info.pCode = code;
+
+    VkShaderModule shader_module = VK_NULL_HANDLE;
+    error_check(vkCreateShaderModule(device, &shader_module_create_info, nullptr, &shader_module));
+    return shader_module;
+}
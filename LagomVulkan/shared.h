@@ -1,32 +1,22 @@
 #pragma once
 
 #include "platform.h"
+#include "asset_pack.h"
 
 #include <iostream>
 #include <assert.h>
+#include <string>
 
 void error_check(VkResult result);
 
 uint32_t find_memory_type_index(const VkPhysicalDeviceMemoryProperties* gpu_memory_properties, const VkMemoryRequirements* memory_requirements, const VkMemoryPropertyFlags required_properties);
 
-struct RIFFHeader {
-    char chunk_id[4];
-    long chunk_size;
-    char format[4];
-};
-
-struct WAVEFormat {
-    char sub_chunk_id[4];
-    long sub_chunk_size;
-    short audio_format;
-    short num_channels;
-    long sample_rate;
-    long byte_rate;
-    short block_align;
-    short bits_per_sample;
-};
-
-struct WAVEData {
-    char sub_chunk_id[4];
-    long sub_chunk_2_size;
-};
\ No newline at end of file
+// Buffers used from more than one queue family list the families and are created concurrent.
+void create_buffer(VkDevice device, const VkPhysicalDeviceMemoryProperties* gpu_memory_properties, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags required_properties, VkBuffer* buffer, VkDeviceMemory* memory, uint32_t queue_family_count = 0, const uint32_t* queue_family_indices = nullptr);
+
+VkShaderModule create_shader_module(VkDevice device, const uint32_t* code, size_t size);
+
+VkShaderModule load_shader_module(VkDevice device, const std::string& filename);
+
+// SPIR-V straight out of the mapped pack.
+VkShaderModule load_shader_module(VkDevice device, const AssetPack& pack, const std::string& name);
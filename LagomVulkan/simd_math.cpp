@@ -0,0 +1,243 @@
+#include "simd_math.h"
+
+#include <cmath>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define SIMD_MATH_SSE 1
+#include <xmmintrin.h>
+#elif defined( __ARM_NEON ) || defined( _M_ARM64 )
+#define SIMD_MATH_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Four lane helpers so each kernel is written once for both instruction sets.
+#if SIMD_MATH_SSE
+typedef __m128 float4;
+
+static inline float4 load4(const float* p) { return _mm_loadu_ps(p); }
+static inline void store4(float* p, float4 v) { _mm_storeu_ps(p, v); }
+static inline float4 splat4(float value) { return _mm_set1_ps(value); }
+static inline float4 add4(float4 a, float4 b) { return _mm_add_ps(a, b); }
+static inline float4 sub4(float4 a, float4 b) { return _mm_sub_ps(a, b); }
+static inline float4 mul4(float4 a, float4 b) { return _mm_mul_ps(a, b); }
+static inline float4 abs4(float4 v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+static inline void transpose4(float4& a, float4& b, float4& c, float4& d) { _MM_TRANSPOSE4_PS(a, b, c, d); }
+#elif SIMD_MATH_NEON
+typedef float32x4_t float4;
+
+static inline float4 load4(const float* p) { return vld1q_f32(p); }
+static inline void store4(float* p, float4 v) { vst1q_f32(p, v); }
+static inline float4 splat4(float value) { return vdupq_n_f32(value); }
+static inline float4 add4(float4 a, float4 b) { return vaddq_f32(a, b); }
+static inline float4 sub4(float4 a, float4 b) { return vsubq_f32(a, b); }
+static inline float4 mul4(float4 a, float4 b) { return vmulq_f32(a, b); }
+static inline float4 abs4(float4 v) { return vabsq_f32(v); }
+static inline void transpose4(float4& a, float4& b, float4& c, float4& d)
+{
+    float32x4x2_t ab = vtrnq_f32(a, b);
+    float32x4x2_t cd = vtrnq_f32(c, d);
+    a = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+    b = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+    c = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+    d = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+}
+#endif
+
+#define SIMD_MATH_VECTOR ( SIMD_MATH_SSE || SIMD_MATH_NEON )
+
+Mat4 mat4_identity()
+{
+    Mat4 result = {};
+    result.m[0] = result.m[5] = result.m[10] = result.m[15] = 1.0f;
+    return result;
+}
+
+static void multiply_matrix(Mat4* out, const Mat4& a, const Mat4& b)
+{
+    // Summed in pairs like the SIMD path.
+    Mat4 result;
+    for (uint32_t column = 0; column < 4; ++column) {
+        const float* weights = &b.m[column * 4];
+        for (uint32_t row = 0; row < 4; ++row) {
+            result.m[column * 4 + row] = (a.m[row] * weights[0] + a.m[4 + row] * weights[1]) +
+                (a.m[8 + row] * weights[2] + a.m[12 + row] * weights[3]);
+        }
+    }
+    *out = result;
+}
+
+void multiply_matrices(Mat4* out, const Mat4* a, const Mat4* b, uint32_t count)
+{
+#if SIMD_MATH_VECTOR
+    // Each result column is the columns of a weighted by one column of b.
+    for (uint32_t i = 0; i < count; ++i) {
+        float4 a0 = load4(&a[i].m[0]);
+        float4 a1 = load4(&a[i].m[4]);
+        float4 a2 = load4(&a[i].m[8]);
+        float4 a3 = load4(&a[i].m[12]);
+        float4 columns[4];
+        for (uint32_t column = 0; column < 4; ++column) {
+            const float* weights = &b[i].m[column * 4];
+            columns[column] = add4(add4(mul4(a0, splat4(weights[0])), mul4(a1, splat4(weights[1]))),
+                add4(mul4(a2, splat4(weights[2])), mul4(a3, splat4(weights[3]))));
+        }
+        // Stored after all loads so out may alias a or b.
+        for (uint32_t column = 0; column < 4; ++column) {
+            store4(&out[i].m[column * 4], columns[column]);
+        }
+    }
+#else
+    multiply_matrices_reference(out, a, b, count);
+#endif
+}
+
+void multiply_matrices_reference(Mat4* out, const Mat4* a, const Mat4* b, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        multiply_matrix(&out[i], a[i], b[i]);
+    }
+}
+
+Mat4 compose_matrix(const Vec3& position, const Quat& rotation, float scale)
+{
+    // Same expressions as the SIMD path.
+    float x = rotation.x;
+    float y = rotation.y;
+    float z = rotation.z;
+    float w = rotation.w;
+    float s = scale;
+    float two_s = 2.0f * s;
+    Mat4 result;
+    float* m = result.m;
+    m[0] = s - two_s * (y * y + z * z);
+    m[1] = two_s * (x * y + w * z);
+    m[2] = two_s * (x * z - w * y);
+    m[3] = 0.0f;
+    m[4] = two_s * (x * y - w * z);
+    m[5] = s - two_s * (x * x + z * z);
+    m[6] = two_s * (y * z + w * x);
+    m[7] = 0.0f;
+    m[8] = two_s * (x * z + w * y);
+    m[9] = two_s * (y * z - w * x);
+    m[10] = s - two_s * (x * x + y * y);
+    m[11] = 0.0f;
+    m[12] = position.x;
+    m[13] = position.y;
+    m[14] = position.z;
+    m[15] = 1.0f;
+    return result;
+}
+
+Vec4 transform_vector(const Mat4& matrix, const Vec4& vector)
+{
+    const float* m = matrix.m;
+    Vec4 result;
+    result.x = (m[0] * vector.x + m[4] * vector.y) + (m[8] * vector.z + m[12] * vector.w);
+    result.y = (m[1] * vector.x + m[5] * vector.y) + (m[9] * vector.z + m[13] * vector.w);
+    result.z = (m[2] * vector.x + m[6] * vector.y) + (m[10] * vector.z + m[14] * vector.w);
+    result.w = (m[3] * vector.x + m[7] * vector.y) + (m[11] * vector.z + m[15] * vector.w);
+    return result;
+}
+
+static void compose_matrix(Mat4* out, const TransformArrays& transforms, uint32_t i)
+{
+    Vec3 position = { transforms.position[0][i], transforms.position[1][i], transforms.position[2][i] };
+    Quat rotation = { transforms.rotation[0][i], transforms.rotation[1][i], transforms.rotation[2][i], transforms.rotation[3][i] };
+    *out = compose_matrix(position, rotation, transforms.scale[i]);
+}
+
+void compose_matrices(Mat4* out, const TransformArrays& transforms, uint32_t count)
+{
+    uint32_t i = 0;
+#if SIMD_MATH_VECTOR
+    float4 one = splat4(1.0f);
+    float4 two = splat4(2.0f);
+    float4 zero = splat4(0.0f);
+    for (; i + 4 <= count; i += 4) {
+        float4 x = load4(&transforms.rotation[0][i]);
+        float4 y = load4(&transforms.rotation[1][i]);
+        float4 z = load4(&transforms.rotation[2][i]);
+        float4 w = load4(&transforms.rotation[3][i]);
+        float4 s = load4(&transforms.scale[i]);
+        float4 two_s = mul4(two, s);
+        float4 xx = mul4(x, x), yy = mul4(y, y), zz = mul4(z, z);
+        float4 xy = mul4(x, y), xz = mul4(x, z), yz = mul4(y, z);
+        float4 wx = mul4(w, x), wy = mul4(w, y), wz = mul4(w, z);
+
+        // Lanes are the four transforms, transposing turns each set of rows into matrix columns.
+        float4 c0[4] = { sub4(s, mul4(two_s, add4(yy, zz))), mul4(two_s, add4(xy, wz)), mul4(two_s, sub4(xz, wy)), zero };
+        float4 c1[4] = { mul4(two_s, sub4(xy, wz)), sub4(s, mul4(two_s, add4(xx, zz))), mul4(two_s, add4(yz, wx)), zero };
+        float4 c2[4] = { mul4(two_s, add4(xz, wy)), mul4(two_s, sub4(yz, wx)), sub4(s, mul4(two_s, add4(xx, yy))), zero };
+        float4 c3[4] = { load4(&transforms.position[0][i]), load4(&transforms.position[1][i]), load4(&transforms.position[2][i]), one };
+        float4* columns[4] = { c0, c1, c2, c3 };
+        for (uint32_t column = 0; column < 4; ++column) {
+            float4* rows = columns[column];
+            transpose4(rows[0], rows[1], rows[2], rows[3]);
+            for (uint32_t k = 0; k < 4; ++k) {
+                store4(&out[i + k].m[column * 4], rows[k]);
+            }
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        compose_matrix(&out[i], transforms, i);
+    }
+}
+
+void compose_matrices_reference(Mat4* out, const TransformArrays& transforms, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        compose_matrix(&out[i], transforms, i);
+    }
+}
+
+static void transform_box(const BoxArrays& out, const Mat4& matrix, const BoxArrays& boxes, uint32_t i)
+{
+    // The new half extent is the absolute upper 3x3 applied to the old one (Arvo).
+    const float* m = matrix.m;
+    float center[3] = { boxes.center[0][i], boxes.center[1][i], boxes.center[2][i] };
+    float extent[3] = { boxes.extent[0][i], boxes.extent[1][i], boxes.extent[2][i] };
+    for (uint32_t row = 0; row < 3; ++row) {
+        out.center[row][i] = (m[row] * center[0] + m[4 + row] * center[1]) + (m[8 + row] * center[2] + m[12 + row]);
+        out.extent[row][i] = (std::fabs(m[row]) * extent[0] + std::fabs(m[4 + row]) * extent[1]) + std::fabs(m[8 + row]) * extent[2];
+    }
+}
+
+void transform_boxes(const BoxArrays& out, const Mat4* matrices, const BoxArrays& boxes, uint32_t count)
+{
+    uint32_t i = 0;
+#if SIMD_MATH_VECTOR
+    for (; i + 4 <= count; i += 4) {
+        // m[column][row] holds that element of the four matrices.
+        float4 m[4][4];
+        for (uint32_t column = 0; column < 4; ++column) {
+            for (uint32_t k = 0; k < 4; ++k) {
+                m[column][k] = load4(&matrices[i + k].m[column * 4]);
+            }
+            transpose4(m[column][0], m[column][1], m[column][2], m[column][3]);
+        }
+        float4 cx = load4(&boxes.center[0][i]);
+        float4 cy = load4(&boxes.center[1][i]);
+        float4 cz = load4(&boxes.center[2][i]);
+        float4 ex = load4(&boxes.extent[0][i]);
+        float4 ey = load4(&boxes.extent[1][i]);
+        float4 ez = load4(&boxes.extent[2][i]);
+        for (uint32_t row = 0; row < 3; ++row) {
+            float4 center = add4(add4(mul4(m[0][row], cx), mul4(m[1][row], cy)), add4(mul4(m[2][row], cz), m[3][row]));
+            float4 extent = add4(add4(mul4(abs4(m[0][row]), ex), mul4(abs4(m[1][row]), ey)), mul4(abs4(m[2][row]), ez));
+            store4(&out.center[row][i], center);
+            store4(&out.extent[row][i], extent);
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        transform_box(out, matrices[i], boxes, i);
+    }
+}
+
+void transform_boxes_reference(const BoxArrays& out, const Mat4* matrices, const BoxArrays& boxes, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        transform_box(out, matrices[i], boxes, i);
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <stdint.h>
+
+// Column major 4x4 matrix, m[column * 4 + row], laid out like a GLSL mat4.
+struct alignas(16) Mat4 {
+    float m[16];
+};
+
+struct Vec3 {
+    float x, y, z;
+};
+
+struct alignas(16) Vec4 {
+    float x, y, z, w;
+};
+
+// Unit quaternion for rotations.
+struct Quat {
+    float x, y, z, w;
+};
+
+// Translation, rotation (unit quaternion xyzw) and uniform scale, one array per component.
+struct TransformArrays {
+    float* position[3];
+    float* rotation[4];
+    float* scale;
+};
+
+// Axis aligned boxes as center and half extent, one array per component.
+struct BoxArrays {
+    float* center[3];
+    float* extent[3];
+};
+
+// Batched math kernels. The SoA kernels work on four elements at a time
+// with SSE, or NEON on ARM, and finish the tail with scalar code. The
+// _reference versions are plain scalar loops that evaluate the same
+// expressions in the same order, so results match bit for bit unless the
+// compiler fuses multiply-adds (MSVC doesn't under /fp:precise). They are
+// kept to check the SIMD paths and to measure them against.
+
+Mat4 mat4_identity();
+// translate * rotate * scale for a single transform, what compose_matrices does per element.
+Mat4 compose_matrix(const Vec3& position, const Quat& rotation, float scale);
+Vec4 transform_vector(const Mat4& matrix, const Vec4& vector);
+
+// out[i] = a[i] * b[i]. Matrices stay whole (AoS): every column already fills
+// a register, and callers keep Mat4 arrays for the hierarchy and uploads.
+void multiply_matrices(Mat4* out, const Mat4* a, const Mat4* b, uint32_t count);
+void multiply_matrices_reference(Mat4* out, const Mat4* a, const Mat4* b, uint32_t count);
+
+// out[i] = translate * rotate * scale
+void compose_matrices(Mat4* out, const TransformArrays& transforms, uint32_t count);
+void compose_matrices_reference(Mat4* out, const TransformArrays& transforms, uint32_t count);
+
+// Bounds of each box after its matrix, out may alias boxes.
+void transform_boxes(const BoxArrays& out, const Mat4* matrices, const BoxArrays& boxes, uint32_t count);
+void transform_boxes_reference(const BoxArrays& out, const Mat4* matrices, const BoxArrays& boxes, uint32_t count);
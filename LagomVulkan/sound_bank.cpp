@@ -0,0 +1,242 @@
+#include "sound_bank.h"
+#include "wave_file.h"
+
+#include <algorithm>
+#include <iostream>
+
+SoundBank::SoundBank(size_t budget_bytes)
+{
+    _budget_bytes = budget_bytes;
+    for (uint32_t i = 0; i < SOUND_BANK_WORKERS; ++i) {
+        _workers.emplace_back(&SoundBank::_worker_main, this);
+    }
+}
+
+SoundBank::~SoundBank()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _quit = true;
+        _jobs.clear();
+    }
+    _jobs_ready.notify_all();
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+
+    for (auto& entry : _entries) {
+        if (entry.buffer != 0) {
+            alDeleteBuffers(1, &entry.buffer);
+        }
+    }
+}
+
+void SoundBank::set_asset_pack(const AssetPack* pack)
+{
+    _pack = pack;
+}
+
+int SoundBank::acquire(const std::string& filename)
+{
+    int sound = -1;
+    auto found = _ids.find(filename);
+    if (found != _ids.end()) {
+        sound = found->second;
+    }
+    else {
+        sound = (int)_entries.size();
+        _entries.emplace_back();
+        _entries.back().filename = filename;
+        _entries.back().state = State::EVICTED;
+        _ids[filename] = sound;
+    }
+
+    Entry& entry = _entries[sound];
+    ++entry.references;
+    entry.last_used = _frame;
+    if (entry.state == State::EVICTED) {
+        _queue_load(sound);
+    }
+    return sound;
+}
+
+void SoundBank::release(int soundID)
+{
+    if (soundID < 0 || soundID >= (int)_entries.size() || _entries[soundID].references == 0) {
+        return;
+    }
+    // Kept cached, _evict decides when it goes.
+    --_entries[soundID].references;
+}
+
+ALuint SoundBank::get_buffer(int soundID)
+{
+    if (soundID < 0 || soundID >= (int)_entries.size()) {
+        return 0;
+    }
+    Entry& entry = _entries[soundID];
+    entry.last_used = _frame;
+    return entry.state == State::READY ? entry.buffer : 0;
+}
+
+void SoundBank::update()
+{
+    ++_frame;
+
+    std::vector<Result> results;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        results.swap(_results);
+    }
+    for (auto& result : results) {
+        _upload(result);
+    }
+
+    if (_resident_bytes > _budget_bytes) {
+        _evict();
+    }
+}
+
+size_t SoundBank::get_resident_bytes() const
+{
+    return _resident_bytes;
+}
+
+void SoundBank::_worker_main()
+{
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _jobs_ready.wait(lock, [this]() { return _quit || !_jobs.empty(); });
+            if (_quit) {
+                return;
+            }
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+
+        Result result;
+        result.sound = job.sound;
+        if (_pack != nullptr && _load_from_pack(job.filename, result)) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _results.push_back(std::move(result));
+            continue;
+        }
+
+        result.file.reset(new MappedFile());
+        WaveFile wave;
+        if (result.file->open(job.filename) &&
+            parse_wave(result.file->get_data(), result.file->get_size(), &wave) &&
+            import_wave(wave, &result.imported)) {
+            result.loaded = true;
+        }
+        else {
+            std::cout << "Unable to load sound: " << job.filename << std::endl;
+        }
+        // Converted sounds don't need the mapping anymore.
+        if (!result.imported.converted.empty()) {
+            result.file.reset();
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _results.push_back(std::move(result));
+    }
+}
+
+bool SoundBank::_load_from_pack(const std::string& name, Result& result)
+{
+    AssetView view = _pack->find(name);
+    if (!view.is_valid() || view.type != ASSET_TYPE_SOUND || view.size < sizeof(AssetSoundHeader)) {
+        return false;
+    }
+    const AssetSoundHeader* header = (const AssetSoundHeader*)view.data;
+    size_t pcm_size = (size_t)header->frame_count * header->channels * sizeof(int16_t);
+    if (header->sample_rate != CANONICAL_SAMPLE_RATE || header->channels == 0 || header->channels > 2 ||
+        pcm_size > view.size - sizeof(AssetSoundHeader)) {
+        return false;
+    }
+
+    result.imported.channels = header->channels;
+    result.imported.frame_count = header->frame_count;
+    result.imported.passthrough = (const int16_t*)(view.data + sizeof(AssetSoundHeader));
+
+    // Fault the pages in here so the upload on the AL thread doesn't wait on the disk.
+    volatile uint8_t touch = 0;
+    for (size_t offset = 0; offset < view.size; offset += 4096) {
+        touch += view.data[offset];
+    }
+    result.loaded = true;
+    return true;
+}
+
+void SoundBank::_upload(Result& result)
+{
+    Entry& entry = _entries[result.sound];
+    if (!result.loaded) {
+        entry.state = State::FAILED;
+        return;
+    }
+
+    alGetError();
+    alGenBuffers(1, &entry.buffer);
+    ALenum format = result.imported.channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+    alBufferData(entry.buffer, format, result.imported.get_samples(), (ALsizei)result.imported.get_byte_size(), CANONICAL_SAMPLE_RATE);
+    if (alGetError() != AL_NO_ERROR) {
+        alDeleteBuffers(1, &entry.buffer);
+        entry.buffer = 0;
+        entry.state = State::FAILED;
+        return;
+    }
+
+    entry.state = State::READY;
+    entry.bytes = result.imported.get_byte_size();
+    _resident_bytes += entry.bytes;
+}
+
+void SoundBank::_evict()
+{
+    if (_resident_bytes <= _budget_bytes) {
+        return;
+    }
+
+    // Linear scan, banks hold hundreds of sounds at most.
+    std::vector<Entry*> candidates;
+    for (auto& entry : _entries) {
+        if (entry.state == State::READY && entry.references == 0) {
+            candidates.push_back(&entry);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Entry* a, const Entry* b) {
+        return a->last_used < b->last_used;
+    });
+
+    for (Entry* entry : candidates) {
+        if (_resident_bytes <= _budget_bytes) {
+            return;
+        }
+        // Fails while a source still plays the buffer, skip it and try again next update.
+        alGetError();
+        alDeleteBuffers(1, &entry->buffer);
+        if (alGetError() != AL_NO_ERROR) {
+            continue;
+        }
+        entry->buffer = 0;
+        entry->state = State::EVICTED;
+        _resident_bytes -= entry->bytes;
+        entry->bytes = 0;
+    }
+}
+
+void SoundBank::_queue_load(int sound)
+{
+    _entries[sound].state = State::LOADING;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        Job job;
+        job.sound = sound;
+        job.filename = _entries[sound].filename;
+        _jobs.push_back(std::move(job));
+    }
+    _jobs_ready.notify_one();
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <al.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "asset_pack.h"
+#include "audio_import.h"
+#include "mapped_file.h"
+
+constexpr uint32_t SOUND_BANK_WORKERS = 2;
+
+// Maps file names to refcounted OpenAL buffers. Files are mapped, parsed
+// and converted on worker threads; update() uploads finished ones on the
+// AL thread. Asking for a file twice shares one buffer. Unreferenced
+// buffers stay cached until the resident size goes over the budget, then
+// the least recently used ones are deleted.
+class SoundBank {
+public:
+    // Needs a current AL context for everything but the workers.
+    SoundBank(size_t budget_bytes);
+    ~SoundBank();
+
+    SoundBank(const SoundBank&) = delete;
+    SoundBank& operator=(const SoundBank&) = delete;
+
+    // Sounds found in the pack are used in place instead of loading the file.
+    // Set before the first acquire, the pack must outlive the bank.
+    void set_asset_pack(const AssetPack* pack);
+
+    // Returns the sound id and adds a reference, starts loading if needed.
+    int acquire(const std::string& filename);
+    void release(int soundID);
+
+    // 0 while the sound is still loading or failed to load.
+    ALuint get_buffer(int soundID);
+
+    // Uploads finished loads and evicts down to the budget.
+    void update();
+
+    size_t get_resident_bytes() const;
+
+private:
+    enum class State {
+        LOADING,
+        READY,
+        FAILED,
+        EVICTED,
+    };
+
+    struct Entry {
+        std::string filename;
+        State state = State::LOADING;
+        ALuint buffer = 0;
+        size_t bytes = 0;
+        uint32_t references = 0;
+        uint64_t last_used = 0;
+    };
+
+    struct Job {
+        int sound = -1;
+        std::string filename;
+    };
+
+    struct Result {
+        int sound = -1;
+        bool loaded = false;
+        // Keeps passthrough samples alive until they are uploaded.
+        std::unique_ptr<MappedFile> file;
+        ImportedSound imported;
+    };
+
+    void _worker_main();
+    bool _load_from_pack(const std::string& name, Result& result);
+    void _upload(Result& result);
+    void _evict();
+    void _queue_load(int sound);
+
+    std::vector<Entry> _entries;
+    std::unordered_map<std::string, int> _ids;
+    size_t _budget_bytes = 0;
+    size_t _resident_bytes = 0;
+    uint64_t _frame = 0;
+    const AssetPack* _pack = nullptr;
+
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _jobs_ready;
+    std::deque<Job> _jobs;
+    std::vector<Result> _results;
+    bool _quit = false;
+};
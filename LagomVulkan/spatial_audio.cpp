@@ -0,0 +1,208 @@
+#include "spatial_audio.h"
+#include "sound_bank.h"
+#include "voice_pool.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define SPATIAL_AUDIO_SSE 1
+#include <xmmintrin.h>
+#endif
+
+constexpr uint32_t NO_EMITTER = UINT32_MAX;
+
+SpatialAudio::SpatialAudio(VoicePool* voices, SoundBank* sound_bank)
+{
+    _voices = voices;
+    _sound_bank = sound_bank;
+}
+
+SpatialAudio::~SpatialAudio()
+{
+    for (auto voice : _voice) {
+        _voices->stop(voice);
+    }
+}
+
+int SpatialAudio::create_emitter(int soundID, float gain, float max_distance, int priority, bool loop)
+{
+    int emitterID = _handles.create();
+    if (emitterID < 0) {
+        return -1;
+    }
+    _x.push_back(0.0f);
+    _y.push_back(0.0f);
+    _z.push_back(0.0f);
+    _gain.push_back(gain);
+    _max_distance_squared.push_back(max_distance * max_distance);
+    _attenuation.push_back(0.0f);
+    _sound.push_back(soundID);
+    _priority.push_back(priority);
+    _loop.push_back(loop ? 1 : 0);
+    _started.push_back(0);
+    _voice.push_back(SoundHandle());
+    return emitterID;
+}
+
+void SpatialAudio::destroy_emitter(int emitterID)
+{
+    uint32_t dense = _handles.find(emitterID);
+    if (dense != NO_EMITTER) {
+        _remove_dense(dense);
+    }
+}
+
+void SpatialAudio::set_emitter_position(int emitterID, float x, float y, float z)
+{
+    uint32_t dense = _handles.find(emitterID);
+    if (dense == NO_EMITTER) {
+        return;
+    }
+    _x[dense] = x;
+    _y[dense] = y;
+    _z[dense] = z;
+}
+
+void SpatialAudio::set_listener(const float position[3], const float forward[3], const float up[3])
+{
+    for (uint32_t i = 0; i < 3; ++i) {
+        _listener_position[i] = position[i];
+        _listener_orientation[i] = forward[i];
+        _listener_orientation[i + 3] = up[i];
+    }
+    _listener_dirty = true;
+}
+
+void SpatialAudio::update(ALCcontext* context)
+{
+    _compute_attenuation();
+
+    // Everything below is applied by OpenAL at once when the context resumes.
+    alcSuspendContext(context);
+
+    if (_listener_dirty) {
+        alListenerfv(AL_POSITION, _listener_position);
+        alListenerfv(AL_ORIENTATION, _listener_orientation);
+        _listener_dirty = false;
+    }
+
+    _audible_count = 0;
+    uint32_t dense = 0;
+    while (dense < _handles.size()) {
+        float attenuation = _attenuation[dense];
+        if (attenuation < SPATIAL_AUDIBLE_GAIN) {
+            // Virtualize, the voice goes back to the pool. A one-shot nobody can hear is dropped.
+            if (_voice[dense].is_valid()) {
+                _voices->stop(_voice[dense]);
+                _voice[dense] = SoundHandle();
+            }
+            if (!_loop[dense]) {
+                _remove_dense(dense);
+                continue;
+            }
+            ++dense;
+            continue;
+        }
+
+        bool playing = _voices->is_playing(_voice[dense]);
+        if (!playing) {
+            if (!_loop[dense] && _started[dense]) {
+                _remove_dense(dense);
+                continue;
+            }
+            ALuint buffer = _sound_bank->get_buffer(_sound[dense]);
+            if (buffer != 0) {
+                _voice[dense] = _voices->play(buffer, attenuation, _priority[dense], _loop[dense] != 0);
+                _started[dense] = _voice[dense].is_valid() ? 1 : 0;
+            }
+        }
+        else {
+            _voices->set_gain(_voice[dense], attenuation);
+        }
+
+        if (_voice[dense].is_valid()) {
+            _voices->set_position(_voice[dense], _x[dense], _y[dense], _z[dense]);
+            ++_audible_count;
+        }
+        ++dense;
+    }
+
+    alcProcessContext(context);
+}
+
+uint32_t SpatialAudio::get_emitter_count() const
+{
+    return _handles.size();
+}
+
+uint32_t SpatialAudio::get_audible_count() const
+{
+    return _audible_count;
+}
+
+void SpatialAudio::_compute_attenuation()
+{
+    // Inverse distance clamped below the reference distance, zero beyond the max distance:
+    // gain * reference / max(distance, reference), with a reciprocal square root on the squared distance.
+    uint32_t count = _handles.size();
+    uint32_t i = 0;
+#if SPATIAL_AUDIO_SSE
+    __m128 listener_x = _mm_set1_ps(_listener_position[0]);
+    __m128 listener_y = _mm_set1_ps(_listener_position[1]);
+    __m128 listener_z = _mm_set1_ps(_listener_position[2]);
+    __m128 reference = _mm_set1_ps(SPATIAL_REFERENCE_DISTANCE);
+    __m128 reference_squared = _mm_set1_ps(SPATIAL_REFERENCE_DISTANCE * SPATIAL_REFERENCE_DISTANCE);
+    for (; i + 4 <= count; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(&_x[i]), listener_x);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(&_y[i]), listener_y);
+        __m128 dz = _mm_sub_ps(_mm_loadu_ps(&_z[i]), listener_z);
+        __m128 distance_squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        __m128 in_range = _mm_cmplt_ps(distance_squared, _mm_loadu_ps(&_max_distance_squared[i]));
+        __m128 falloff = _mm_mul_ps(reference, _mm_rsqrt_ps(_mm_max_ps(distance_squared, reference_squared)));
+        __m128 attenuation = _mm_mul_ps(_mm_loadu_ps(&_gain[i]), falloff);
+        _mm_storeu_ps(&_attenuation[i], _mm_and_ps(attenuation, in_range));
+    }
+#endif
+    for (; i < count; ++i) {
+        float dx = _x[i] - _listener_position[0];
+        float dy = _y[i] - _listener_position[1];
+        float dz = _z[i] - _listener_position[2];
+        float distance_squared = dx * dx + dy * dy + dz * dz;
+        float falloff = SPATIAL_REFERENCE_DISTANCE / std::sqrt(std::max(distance_squared, SPATIAL_REFERENCE_DISTANCE * SPATIAL_REFERENCE_DISTANCE));
+        _attenuation[i] = distance_squared < _max_distance_squared[i] ? _gain[i] * falloff : 0.0f;
+    }
+}
+
+void SpatialAudio::_remove_dense(uint32_t dense)
+{
+    _voices->stop(_voice[dense]);
+
+    // Swap with the last emitter to keep the arrays packed.
+    uint32_t last = _handles.size() - 1;
+    if (dense != last) {
+        _x[dense] = _x[last];
+        _y[dense] = _y[last];
+        _z[dense] = _z[last];
+        _gain[dense] = _gain[last];
+        _max_distance_squared[dense] = _max_distance_squared[last];
+        _attenuation[dense] = _attenuation[last];
+        _sound[dense] = _sound[last];
+        _priority[dense] = _priority[last];
+        _loop[dense] = _loop[last];
+        _started[dense] = _started[last];
+        _voice[dense] = _voice[last];
+    }
+    _x.pop_back();
+    _y.pop_back();
+    _z.pop_back();
+    _gain.pop_back();
+    _max_distance_squared.pop_back();
+    _attenuation.pop_back();
+    _sound.pop_back();
+    _priority.pop_back();
+    _loop.pop_back();
+    _started.pop_back();
+    _voice.pop_back();
+    _handles.remove(dense);
+}
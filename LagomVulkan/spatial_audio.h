@@ -0,0 +1,66 @@
+#pragma once
+#include <al.h>
+#include <alc.h>
+#include <stdint.h>
+#include <vector>
+#include "audio.h"
+#include "handle_table.h"
+
+class SoundBank;
+class VoicePool;
+
+constexpr float SPATIAL_REFERENCE_DISTANCE = 1.0f;
+// Below -60 dB an emitter is treated as silent.
+constexpr float SPATIAL_AUDIBLE_GAIN = 0.001f;
+
+// 3D emitters kept as packed arrays (structure of arrays). update() computes
+// every emitter's distance attenuation with SSE in one pass, gives voices
+// only to the audible ones and takes them from the rest (virtualized
+// emitters keep their state and come back when audible again). All AL
+// parameter changes of a frame go out in one suspended-context batch, so
+// AL work scales with audible voices instead of emitters.
+class SpatialAudio {
+public:
+    SpatialAudio(VoicePool* voices, SoundBank* sound_bank);
+    ~SpatialAudio();
+
+    // Non-looping emitters remove themselves once played or when out of earshot.
+    int create_emitter(int soundID, float gain, float max_distance, int priority, bool loop);
+    void destroy_emitter(int emitterID);
+    void set_emitter_position(int emitterID, float x, float y, float z);
+    void set_listener(const float position[3], const float forward[3], const float up[3]);
+
+    // Once per frame on the AL thread.
+    void update(ALCcontext* context);
+
+    uint32_t get_emitter_count() const;
+    uint32_t get_audible_count() const;
+
+private:
+    void _compute_attenuation();
+    void _remove_dense(uint32_t dense);
+
+    VoicePool* _voices = nullptr;
+    SoundBank* _sound_bank = nullptr;
+
+    HandleTable<16> _handles;
+
+    // Dense arrays, one entry per live emitter.
+    std::vector<float> _x;
+    std::vector<float> _y;
+    std::vector<float> _z;
+    std::vector<float> _gain;
+    std::vector<float> _max_distance_squared;
+    std::vector<float> _attenuation;
+    std::vector<int> _sound;
+    std::vector<int> _priority;
+    std::vector<uint8_t> _loop;
+    std::vector<uint8_t> _started;
+    std::vector<SoundHandle> _voice;
+
+    float _listener_position[3] = {};
+    float _listener_orientation[6] = { 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f };
+    bool _listener_dirty = true;
+
+    uint32_t _audible_count = 0;
+};
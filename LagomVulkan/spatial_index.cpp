@@ -0,0 +1,401 @@
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define SPATIAL_INDEX_SSE 1
+#include <emmintrin.h>
+#endif
+
+constexpr uint32_t NO_OBJECT = UINT32_MAX;
+constexpr uint32_t NO_CHILD = UINT32_MAX;
+constexpr uint32_t LEAF_SIZE = 8;
+constexpr uint32_t MAX_DEPTH = 64;
+constexpr float REBUILD_AREA_RATIO = 2.0f;
+
+enum {
+    CLASSIFY_OUTSIDE,
+    CLASSIFY_INTERSECTING,
+    CLASSIFY_INSIDE,
+};
+
+// Six inward facing planes as arrays, padded to eight with planes everything is inside of.
+struct FrustumPlanes {
+    alignas(16) float x[8];
+    alignas(16) float y[8];
+    alignas(16) float z[8];
+    alignas(16) float w[8];
+};
+
+static void extract_planes(const float view_projection[16], FrustumPlanes* planes)
+{
+    // Gribb/Hartmann plane extraction, clip space depth is [0, w].
+    const float* m = view_projection;
+    float rows[4][4];
+    for (int r = 0; r < 4; ++r) {
+        for (int c = 0; c < 4; ++c) {
+            rows[r][c] = m[c * 4 + r];
+        }
+    }
+    float extracted[6][4];
+    for (int c = 0; c < 4; ++c) {
+        extracted[0][c] = rows[3][c] + rows[0][c];
+        extracted[1][c] = rows[3][c] - rows[0][c];
+        extracted[2][c] = rows[3][c] + rows[1][c];
+        extracted[3][c] = rows[3][c] - rows[1][c];
+        extracted[4][c] = rows[2][c];
+        extracted[5][c] = rows[3][c] - rows[2][c];
+    }
+    for (int i = 0; i < 8; ++i) {
+        if (i < 6) {
+            float length = std::sqrt(extracted[i][0] * extracted[i][0] + extracted[i][1] * extracted[i][1] + extracted[i][2] * extracted[i][2]);
+            float scale = length > 0.0f ? 1.0f / length : 1.0f;
+            planes->x[i] = extracted[i][0] * scale;
+            planes->y[i] = extracted[i][1] * scale;
+            planes->z[i] = extracted[i][2] * scale;
+            planes->w[i] = extracted[i][3] * scale;
+        }
+        else {
+            planes->x[i] = planes->y[i] = planes->z[i] = 0.0f;
+            planes->w[i] = 1.0f;
+        }
+    }
+}
+
+// A box is outside once it is fully behind any plane and inside when fully in front of all.
+static int classify_box(const FrustumPlanes& planes, const float center[3], const float extent[3])
+{
+#if SPATIAL_INDEX_SSE
+    // Four planes per pass.
+    __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 cx = _mm_set1_ps(center[0]), cy = _mm_set1_ps(center[1]), cz = _mm_set1_ps(center[2]);
+    __m128 ex = _mm_set1_ps(extent[0]), ey = _mm_set1_ps(extent[1]), ez = _mm_set1_ps(extent[2]);
+    int outside = 0;
+    int inside = 0;
+    for (int i = 0; i < 8; i += 4) {
+        __m128 px = _mm_load_ps(&planes.x[i]), py = _mm_load_ps(&planes.y[i]), pz = _mm_load_ps(&planes.z[i]);
+        __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, cx), _mm_mul_ps(py, cy)), _mm_add_ps(_mm_mul_ps(pz, cz), _mm_load_ps(&planes.w[i])));
+        __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign, px), ex), _mm_mul_ps(_mm_andnot_ps(sign, py), ey)), _mm_mul_ps(_mm_andnot_ps(sign, pz), ez));
+        outside |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+        inside |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(distance, radius), _mm_setzero_ps()));
+    }
+    if (outside != 0) {
+        return CLASSIFY_OUTSIDE;
+    }
+    return inside == 0 ? CLASSIFY_INSIDE : CLASSIFY_INTERSECTING;
+#else
+    bool intersecting = false;
+    for (int i = 0; i < 6; ++i) {
+        float distance = planes.x[i] * center[0] + planes.y[i] * center[1] + planes.z[i] * center[2] + planes.w[i];
+        float radius = std::fabs(planes.x[i]) * extent[0] + std::fabs(planes.y[i]) * extent[1] + std::fabs(planes.z[i]) * extent[2];
+        if (distance + radius < 0.0f) {
+            return CLASSIFY_OUTSIDE;
+        }
+        intersecting |= distance - radius < 0.0f;
+    }
+    return intersecting ? CLASSIFY_INTERSECTING : CLASSIFY_INSIDE;
+#endif
+}
+
+SpatialIndex::SpatialIndex()
+{
+}
+
+SpatialIndex::~SpatialIndex()
+{
+}
+
+int SpatialIndex::create_object(const float center[3], const float extent[3])
+{
+    int objectID = _handles.create();
+    if (objectID < 0) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < 3; ++i) {
+        _center[i].push_back(center[i]);
+        _extent[i].push_back(extent[i]);
+    }
+    _structure_dirty = true;
+    return objectID;
+}
+
+void SpatialIndex::destroy_object(int objectID)
+{
+    uint32_t dense = _handles.find(objectID);
+    if (dense == NO_OBJECT) {
+        return;
+    }
+
+    // Swap with the last object, the tree is rebuilt before the next query anyway.
+    uint32_t last = _handles.size() - 1;
+    for (uint32_t i = 0; i < 3; ++i) {
+        _center[i][dense] = _center[i][last];
+        _extent[i][dense] = _extent[i][last];
+        _center[i].pop_back();
+        _extent[i].pop_back();
+    }
+    _handles.remove(dense);
+    _structure_dirty = true;
+}
+
+void SpatialIndex::set_object_bounds(int objectID, const float center[3], const float extent[3])
+{
+    uint32_t dense = _handles.find(objectID);
+    if (dense == NO_OBJECT) {
+        return;
+    }
+    for (uint32_t i = 0; i < 3; ++i) {
+        _center[i][dense] = center[i];
+        _extent[i][dense] = extent[i];
+    }
+    _bounds_dirty = true;
+}
+
+void SpatialIndex::update()
+{
+    if (_structure_dirty) {
+        _rebuild();
+    }
+    else if (_bounds_dirty) {
+        _refit();
+    }
+    _structure_dirty = false;
+    _bounds_dirty = false;
+}
+
+void SpatialIndex::query_frustum(const float view_projection[16], std::vector<int>* objectIDs) const
+{
+    if (_nodes.empty()) {
+        return;
+    }
+    FrustumPlanes planes;
+    extract_planes(view_projection, &planes);
+
+    uint32_t stack[MAX_DEPTH];
+    uint32_t stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0) {
+        const Node& node = _nodes[stack[--stack_size]];
+        int classification = classify_box(planes, node.center, node.extent);
+        if (classification == CLASSIFY_OUTSIDE) {
+            continue;
+        }
+        if (classification == CLASSIFY_INSIDE) {
+            _append_range(node.first, node.count, objectIDs);
+            continue;
+        }
+        if (node.left != NO_CHILD) {
+            stack[stack_size++] = node.left;
+            stack[stack_size++] = node.left + 1;
+            continue;
+        }
+
+        uint32_t i = node.first;
+        uint32_t end = node.first + node.count;
+#if SPATIAL_INDEX_SSE
+        // Four objects against one plane per step.
+        __m128 sign = _mm_set1_ps(-0.0f);
+        for (; i + 4 <= end; i += 4) {
+            __m128 cx = _mm_loadu_ps(&_center[0][i]), cy = _mm_loadu_ps(&_center[1][i]), cz = _mm_loadu_ps(&_center[2][i]);
+            __m128 ex = _mm_loadu_ps(&_extent[0][i]), ey = _mm_loadu_ps(&_extent[1][i]), ez = _mm_loadu_ps(&_extent[2][i]);
+            __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int plane = 0; plane < 6; ++plane) {
+                __m128 px = _mm_set1_ps(planes.x[plane]), py = _mm_set1_ps(planes.y[plane]), pz = _mm_set1_ps(planes.z[plane]);
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, cx), _mm_mul_ps(py, cy)), _mm_add_ps(_mm_mul_ps(pz, cz), _mm_set1_ps(planes.w[plane])));
+                __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign, px), ex), _mm_mul_ps(_mm_andnot_ps(sign, py), ey)), _mm_mul_ps(_mm_andnot_ps(sign, pz), ez));
+                visible = _mm_and_ps(visible, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+            }
+            int mask = _mm_movemask_ps(visible);
+            for (uint32_t lane = 0; lane < 4; ++lane) {
+                if (mask & (1 << lane)) {
+                    _append_range(i + lane, 1, objectIDs);
+                }
+            }
+        }
+#endif
+        for (; i < end; ++i) {
+            float center[3] = { _center[0][i], _center[1][i], _center[2][i] };
+            float extent[3] = { _extent[0][i], _extent[1][i], _extent[2][i] };
+            if (classify_box(planes, center, extent) != CLASSIFY_OUTSIDE) {
+                _append_range(i, 1, objectIDs);
+            }
+        }
+    }
+}
+
+void SpatialIndex::query_sphere(const float center[3], float radius, std::vector<int>* objectIDs) const
+{
+    if (_nodes.empty()) {
+        return;
+    }
+    float radius_squared = radius * radius;
+
+    uint32_t stack[MAX_DEPTH];
+    uint32_t stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0) {
+        const Node& node = _nodes[stack[--stack_size]];
+        // Squared distance from the sphere center to the box.
+        float distance_squared = 0.0f;
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            float outside = std::max(std::fabs(center[axis] - node.center[axis]) - node.extent[axis], 0.0f);
+            distance_squared += outside * outside;
+        }
+        if (distance_squared > radius_squared) {
+            continue;
+        }
+        if (node.left != NO_CHILD) {
+            stack[stack_size++] = node.left;
+            stack[stack_size++] = node.left + 1;
+            continue;
+        }
+
+        uint32_t i = node.first;
+        uint32_t end = node.first + node.count;
+#if SPATIAL_INDEX_SSE
+        __m128 sign = _mm_set1_ps(-0.0f);
+        __m128 zero = _mm_setzero_ps();
+        __m128 sx = _mm_set1_ps(center[0]), sy = _mm_set1_ps(center[1]), sz = _mm_set1_ps(center[2]);
+        __m128 limit = _mm_set1_ps(radius_squared);
+        for (; i + 4 <= end; i += 4) {
+            __m128 dx = _mm_max_ps(_mm_sub_ps(_mm_andnot_ps(sign, _mm_sub_ps(sx, _mm_loadu_ps(&_center[0][i]))), _mm_loadu_ps(&_extent[0][i])), zero);
+            __m128 dy = _mm_max_ps(_mm_sub_ps(_mm_andnot_ps(sign, _mm_sub_ps(sy, _mm_loadu_ps(&_center[1][i]))), _mm_loadu_ps(&_extent[1][i])), zero);
+            __m128 dz = _mm_max_ps(_mm_sub_ps(_mm_andnot_ps(sign, _mm_sub_ps(sz, _mm_loadu_ps(&_center[2][i]))), _mm_loadu_ps(&_extent[2][i])), zero);
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            int mask = _mm_movemask_ps(_mm_cmple_ps(distance, limit));
+            for (uint32_t lane = 0; lane < 4; ++lane) {
+                if (mask & (1 << lane)) {
+                    _append_range(i + lane, 1, objectIDs);
+                }
+            }
+        }
+#endif
+        for (; i < end; ++i) {
+            float object_distance = 0.0f;
+            for (uint32_t axis = 0; axis < 3; ++axis) {
+                float outside = std::max(std::fabs(center[axis] - _center[axis][i]) - _extent[axis][i], 0.0f);
+                object_distance += outside * outside;
+            }
+            if (object_distance <= radius_squared) {
+                _append_range(i, 1, objectIDs);
+            }
+        }
+    }
+}
+
+uint32_t SpatialIndex::get_object_count() const
+{
+    return _handles.size();
+}
+
+uint32_t SpatialIndex::get_node_count() const
+{
+    return (uint32_t)_nodes.size();
+}
+
+void SpatialIndex::_rebuild()
+{
+    _nodes.clear();
+    uint32_t count = _handles.size();
+    if (count == 0) {
+        return;
+    }
+
+    // Median split along the widest axis of the centers, building the object order as it goes.
+    std::vector<uint32_t> order(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        order[i] = i;
+    }
+    _nodes.reserve(count / LEAF_SIZE * 2 + 1);
+    _nodes.push_back({ { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, NO_CHILD, 0, count });
+    for (uint32_t node_index = 0; node_index < (uint32_t)_nodes.size(); ++node_index) {
+        uint32_t first = _nodes[node_index].first;
+        uint32_t node_count = _nodes[node_index].count;
+        if (node_count <= LEAF_SIZE) {
+            continue;
+        }
+        float low[3] = { INFINITY, INFINITY, INFINITY };
+        float high[3] = { -INFINITY, -INFINITY, -INFINITY };
+        for (uint32_t i = first; i < first + node_count; ++i) {
+            for (uint32_t axis = 0; axis < 3; ++axis) {
+                low[axis] = std::min(low[axis], _center[axis][order[i]]);
+                high[axis] = std::max(high[axis], _center[axis][order[i]]);
+            }
+        }
+        uint32_t axis = 0;
+        for (uint32_t a = 1; a < 3; ++a) {
+            if (high[a] - low[a] > high[axis] - low[axis]) {
+                axis = a;
+            }
+        }
+        const std::vector<float>& keys = _center[axis];
+        uint32_t half = node_count / 2;
+        std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + node_count,
+            [&keys](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+
+        // Breadth first, so children always come after their parent.
+        _nodes[node_index].left = (uint32_t)_nodes.size();
+        _nodes.push_back({ { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, NO_CHILD, first, half });
+        _nodes.push_back({ { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, NO_CHILD, first + half, node_count - half });
+    }
+
+    _handles.reorder(order);
+    for (uint32_t i = 0; i < 3; ++i) {
+        reorder_array(_center[i], order);
+        reorder_array(_extent[i], order);
+    }
+
+    _built_leaf_area = 0.0f;
+    _refit();
+}
+
+void SpatialIndex::_refit()
+{
+    float leaf_area = 0.0f;
+    for (uint32_t node_index = (uint32_t)_nodes.size(); node_index-- > 0;) {
+        Node& node = _nodes[node_index];
+        if (node.left == NO_CHILD) {
+            _compute_bounds(node.first, node.count, node.center, node.extent);
+            leaf_area += node.extent[0] * node.extent[1] + node.extent[1] * node.extent[2] + node.extent[2] * node.extent[0];
+            continue;
+        }
+        const Node& left = _nodes[node.left];
+        const Node& right = _nodes[node.left + 1];
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            float low = std::min(left.center[axis] - left.extent[axis], right.center[axis] - right.extent[axis]);
+            float high = std::max(left.center[axis] + left.extent[axis], right.center[axis] + right.extent[axis]);
+            node.center[axis] = (low + high) * 0.5f;
+            node.extent[axis] = (high - low) * 0.5f;
+        }
+    }
+
+    // Leaves that spread out overlap more and more, past a point a fresh split pays off.
+    if (_built_leaf_area == 0.0f) {
+        _built_leaf_area = leaf_area;
+    }
+    else if (leaf_area > _built_leaf_area * REBUILD_AREA_RATIO) {
+        _rebuild();
+    }
+}
+
+void SpatialIndex::_compute_bounds(uint32_t first, uint32_t count, float center[3], float extent[3]) const
+{
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        float low = INFINITY;
+        float high = -INFINITY;
+        for (uint32_t i = first; i < first + count; ++i) {
+            low = std::min(low, _center[axis][i] - _extent[axis][i]);
+            high = std::max(high, _center[axis][i] + _extent[axis][i]);
+        }
+        center[axis] = (low + high) * 0.5f;
+        extent[axis] = (high - low) * 0.5f;
+    }
+}
+
+void SpatialIndex::_append_range(uint32_t first, uint32_t count, std::vector<int>* objectIDs) const
+{
+    for (uint32_t i = first; i < first + count; ++i) {
+        objectIDs->push_back(_handles.get_id(i));
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "handle_table.h"
+
+// Bounding volume hierarchy over object boxes (center and half extent).
+// Objects are kept as packed arrays in tree order, so every node covers a
+// contiguous range of them: leaves test their objects four at a time with
+// SSE, and nodes fully inside a query take their whole range untested.
+// Moving objects only refit the node bounds; adding or removing objects,
+// or refits that loosen the tree too much, rebuild it in update(). Call
+// update() once after the frame's changes and before querying.
+class SpatialIndex {
+public:
+    SpatialIndex();
+    ~SpatialIndex();
+
+    int create_object(const float center[3], const float extent[3]);
+    void destroy_object(int objectID);
+    void set_object_bounds(int objectID, const float center[3], const float extent[3]);
+
+    void update();
+
+    // Append the ids of objects overlapping the query to objectIDs.
+    // Column major view projection, Vulkan clip space.
+    void query_frustum(const float view_projection[16], std::vector<int>* objectIDs) const;
+    void query_sphere(const float center[3], float radius, std::vector<int>* objectIDs) const;
+
+    uint32_t get_object_count() const;
+    uint32_t get_node_count() const;
+
+private:
+    struct Node {
+        float center[3];
+        float extent[3];
+        // Children are left and left + 1, NO_CHILD for leaves.
+        uint32_t left;
+        // Objects under the node, in tree order.
+        uint32_t first;
+        uint32_t count;
+    };
+
+    void _rebuild();
+    void _refit();
+    void _compute_bounds(uint32_t first, uint32_t count, float center[3], float extent[3]) const;
+    void _append_range(uint32_t first, uint32_t count, std::vector<int>* objectIDs) const;
+
+    // Scenes outgrow the 16 bit slots used for other handles.
+    HandleTable<20> _handles;
+
+    // Dense arrays, one entry per live object, in tree order after update().
+    std::vector<float> _center[3];
+    std::vector<float> _extent[3];
+
+    std::vector<Node> _nodes;
+    bool _structure_dirty = false;
+    bool _bounds_dirty = false;
+    // Summed leaf surface area right after the last build, refits past a multiple of it rebuild.
+    float _built_leaf_area = 0.0f;
+};
@@ -0,0 +1,370 @@
+#include "texture_compress.h"
+#include "texture_file.h"
+
+#include <cmath>
+#include <string.h>
+
+static uint16_t pack_565(const float color[3])
+{
+    uint32_t packed[3];
+    const float scales[3] = { 31.0f, 63.0f, 31.0f };
+    for (int c = 0; c < 3; ++c) {
+        float value = color[c] < 0.0f ? 0.0f : (color[c] > 255.0f ? 255.0f : color[c]);
+        packed[c] = (uint32_t)(value * scales[c] / 255.0f + 0.5f);
+    }
+    return (uint16_t)((packed[0] << 11) | (packed[1] << 5) | packed[2]);
+}
+
+static void unpack_565(uint16_t packed, int color[3])
+{
+    int r = (packed >> 11) & 31;
+    int g = (packed >> 5) & 63;
+    int b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+static void write_u16(uint8_t* bytes, uint16_t value)
+{
+    bytes[0] = (uint8_t)value;
+    bytes[1] = (uint8_t)(value >> 8);
+}
+
+static uint16_t read_u16(const uint8_t* bytes)
+{
+    return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+// Endpoints along the principal axis of the block's colors, then the nearest palette entry per texel.
+static void encode_color_block(const uint8_t rgba[64], uint8_t output[8])
+{
+    float mean[3] = {};
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            mean[c] += rgba[i * 4 + c];
+        }
+    }
+    for (int c = 0; c < 3; ++c) {
+        mean[c] /= 16.0f;
+    }
+
+    float covariance[6] = {};
+    for (int i = 0; i < 16; ++i) {
+        float r = rgba[i * 4 + 0] - mean[0];
+        float g = rgba[i * 4 + 1] - mean[1];
+        float b = rgba[i * 4 + 2] - mean[2];
+        covariance[0] += r * r;
+        covariance[1] += r * g;
+        covariance[2] += r * b;
+        covariance[3] += g * g;
+        covariance[4] += g * b;
+        covariance[5] += b * b;
+    }
+
+    // A few power iterations are plenty for a 3x3 matrix.
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+        float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+        float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+        float length = std::sqrt(x * x + y * y + z * z);
+        if (length < 1e-6f) {
+            break;
+        }
+        axis[0] = x / length;
+        axis[1] = y / length;
+        axis[2] = z / length;
+    }
+
+    float min_t = 0.0f;
+    float max_t = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        float t = (rgba[i * 4 + 0] - mean[0]) * axis[0] + (rgba[i * 4 + 1] - mean[1]) * axis[1] + (rgba[i * 4 + 2] - mean[2]) * axis[2];
+        min_t = t < min_t ? t : min_t;
+        max_t = t > max_t ? t : max_t;
+    }
+
+    float high[3];
+    float low[3];
+    for (int c = 0; c < 3; ++c) {
+        high[c] = mean[c] + axis[c] * max_t;
+        low[c] = mean[c] + axis[c] * min_t;
+    }
+    uint16_t color0 = pack_565(high);
+    uint16_t color1 = pack_565(low);
+    // color0 > color1 selects the four color mode.
+    if (color0 < color1) {
+        uint16_t swap = color0;
+        color0 = color1;
+        color1 = swap;
+    }
+    write_u16(output + 0, color0);
+    write_u16(output + 2, color1);
+
+    uint32_t indices = 0;
+    if (color0 != color1) {
+        int palette[4][3];
+        unpack_565(color0, palette[0]);
+        unpack_565(color1, palette[1]);
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for (int i = 0; i < 16; ++i) {
+            uint32_t best = 0;
+            int best_error = 0x7FFFFFFF;
+            for (uint32_t p = 0; p < 4; ++p) {
+                int r = rgba[i * 4 + 0] - palette[p][0];
+                int g = rgba[i * 4 + 1] - palette[p][1];
+                int b = rgba[i * 4 + 2] - palette[p][2];
+                int error = r * r + g * g + b * b;
+                if (error < best_error) {
+                    best_error = error;
+                    best = p;
+                }
+            }
+            indices |= best << (i * 2);
+        }
+    }
+    output[4] = (uint8_t)indices;
+    output[5] = (uint8_t)(indices >> 8);
+    output[6] = (uint8_t)(indices >> 16);
+    output[7] = (uint8_t)(indices >> 24);
+}
+
+static void decode_color_block(const uint8_t input[8], bool force_four_colors, uint8_t rgba[64])
+{
+    uint16_t color0 = read_u16(input + 0);
+    uint16_t color1 = read_u16(input + 2);
+    int palette[4][4];
+    unpack_565(color0, palette[0]);
+    unpack_565(color1, palette[1]);
+    palette[0][3] = 255;
+    palette[1][3] = 255;
+    palette[2][3] = 255;
+    palette[3][3] = 255;
+    if (force_four_colors || color0 > color1) {
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+    }
+    else {
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+        palette[3][3] = 0;
+    }
+
+    uint32_t indices = (uint32_t)input[4] | ((uint32_t)input[5] << 8) | ((uint32_t)input[6] << 16) | ((uint32_t)input[7] << 24);
+    for (int i = 0; i < 16; ++i) {
+        const int* color = palette[(indices >> (i * 2)) & 3];
+        for (int c = 0; c < 4; ++c) {
+            rgba[i * 4 + c] = (uint8_t)color[c];
+        }
+    }
+}
+
+// Eight value ramp between the channel's minimum and maximum.
+static void encode_channel_block(const uint8_t rgba[64], uint32_t channel, uint8_t output[8])
+{
+    int low = 255;
+    int high = 0;
+    for (int i = 0; i < 16; ++i) {
+        int value = rgba[i * 4 + channel];
+        low = value < low ? value : low;
+        high = value > high ? value : high;
+    }
+    output[0] = (uint8_t)high;
+    output[1] = (uint8_t)low;
+
+    uint64_t indices = 0;
+    if (high > low) {
+        int range = high - low;
+        for (int i = 0; i < 16; ++i) {
+            // Position on the ramp from low (0) to high (7), remapped to the index order.
+            int step = ((rgba[i * 4 + channel] - low) * 7 + range / 2) / range;
+            uint64_t index = step == 7 ? 0 : (step == 0 ? 1 : (uint64_t)(8 - step));
+            indices |= index << (i * 3);
+        }
+    }
+    for (int b = 0; b < 6; ++b) {
+        output[2 + b] = (uint8_t)(indices >> (b * 8));
+    }
+}
+
+static void decode_channel_block(const uint8_t input[8], uint32_t channel, uint8_t rgba[64])
+{
+    int values[8];
+    values[0] = input[0];
+    values[1] = input[1];
+    if (values[0] > values[1]) {
+        for (int i = 2; i < 8; ++i) {
+            values[i] = ((8 - i) * values[0] + (i - 1) * values[1]) / 7;
+        }
+    }
+    else {
+        for (int i = 2; i < 6; ++i) {
+            values[i] = ((6 - i) * values[0] + (i - 1) * values[1]) / 5;
+        }
+        values[6] = 0;
+        values[7] = 255;
+    }
+
+    uint64_t indices = 0;
+    for (int b = 0; b < 6; ++b) {
+        indices |= (uint64_t)input[2 + b] << (b * 8);
+    }
+    for (int i = 0; i < 16; ++i) {
+        rgba[i * 4 + channel] = (uint8_t)values[(indices >> (i * 3)) & 7];
+    }
+}
+
+static size_t get_block_bytes(uint32_t vk_format)
+{
+    switch (vk_format) {
+    case TEXTURE_FORMAT_BC1_RGB_UNORM:
+    case TEXTURE_FORMAT_BC1_RGB_SRGB:
+    case TEXTURE_FORMAT_BC4_UNORM:
+        return 8;
+    case TEXTURE_FORMAT_BC3_UNORM:
+    case TEXTURE_FORMAT_BC3_SRGB:
+    case TEXTURE_FORMAT_BC5_UNORM:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+bool is_texture_format_known(uint32_t vk_format)
+{
+    return vk_format == TEXTURE_FORMAT_R8G8B8A8_UNORM || vk_format == TEXTURE_FORMAT_R8G8B8A8_SRGB || is_texture_format_compressed(vk_format);
+}
+
+bool is_texture_format_compressed(uint32_t vk_format)
+{
+    return get_block_bytes(vk_format) != 0;
+}
+
+bool is_texture_format_srgb(uint32_t vk_format)
+{
+    return vk_format == TEXTURE_FORMAT_R8G8B8A8_SRGB || vk_format == TEXTURE_FORMAT_BC1_RGB_SRGB || vk_format == TEXTURE_FORMAT_BC3_SRGB;
+}
+
+size_t get_texture_level_size(uint32_t vk_format, uint32_t width, uint32_t height)
+{
+    size_t block_bytes = get_block_bytes(vk_format);
+    if (block_bytes == 0) {
+        return (size_t)width * height * 4;
+    }
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * block_bytes;
+}
+
+uint32_t get_texture_decoded_format(uint32_t vk_format)
+{
+    return is_texture_format_srgb(vk_format) ? TEXTURE_FORMAT_R8G8B8A8_SRGB : TEXTURE_FORMAT_R8G8B8A8_UNORM;
+}
+
+bool compress_texture_level(uint32_t vk_format, const uint8_t* rgba, uint32_t width, uint32_t height, std::vector<uint8_t>* output)
+{
+    if (!is_texture_format_known(vk_format)) {
+        return false;
+    }
+    output->resize(get_texture_level_size(vk_format, width, height));
+    if (!is_texture_format_compressed(vk_format)) {
+        memcpy(output->data(), rgba, output->size());
+        return true;
+    }
+
+    size_t block_bytes = get_block_bytes(vk_format);
+    uint8_t* block_output = output->data();
+    uint8_t block[64];
+    for (uint32_t block_y = 0; block_y < height; block_y += 4) {
+        for (uint32_t block_x = 0; block_x < width; block_x += 4) {
+            for (uint32_t y = 0; y < 4; ++y) {
+                uint32_t source_y = block_y + y < height ? block_y + y : height - 1;
+                for (uint32_t x = 0; x < 4; ++x) {
+                    uint32_t source_x = block_x + x < width ? block_x + x : width - 1;
+                    memcpy(block + (y * 4 + x) * 4, rgba + ((size_t)source_y * width + source_x) * 4, 4);
+                }
+            }
+
+            switch (vk_format) {
+            case TEXTURE_FORMAT_BC1_RGB_UNORM:
+            case TEXTURE_FORMAT_BC1_RGB_SRGB:
+                encode_color_block(block, block_output);
+                break;
+            case TEXTURE_FORMAT_BC3_UNORM:
+            case TEXTURE_FORMAT_BC3_SRGB:
+                encode_channel_block(block, 3, block_output);
+                encode_color_block(block, block_output + 8);
+                break;
+            case TEXTURE_FORMAT_BC4_UNORM:
+                encode_channel_block(block, 0, block_output);
+                break;
+            case TEXTURE_FORMAT_BC5_UNORM:
+                encode_channel_block(block, 0, block_output);
+                encode_channel_block(block, 1, block_output + 8);
+                break;
+            }
+            block_output += block_bytes;
+        }
+    }
+    return true;
+}
+
+bool decompress_texture_level(uint32_t vk_format, const uint8_t* data, size_t size, uint32_t width, uint32_t height, uint8_t* rgba)
+{
+    if (!is_texture_format_known(vk_format) || size < get_texture_level_size(vk_format, width, height)) {
+        return false;
+    }
+    if (!is_texture_format_compressed(vk_format)) {
+        memcpy(rgba, data, (size_t)width * height * 4);
+        return true;
+    }
+
+    size_t block_bytes = get_block_bytes(vk_format);
+    const uint8_t* block_input = data;
+    uint8_t block[64];
+    for (uint32_t block_y = 0; block_y < height; block_y += 4) {
+        for (uint32_t block_x = 0; block_x < width; block_x += 4) {
+            switch (vk_format) {
+            case TEXTURE_FORMAT_BC1_RGB_UNORM:
+            case TEXTURE_FORMAT_BC1_RGB_SRGB:
+                decode_color_block(block_input, false, block);
+                // The RGB formats ignore the punch-through alpha.
+                for (int i = 0; i < 16; ++i) {
+                    block[i * 4 + 3] = 255;
+                }
+                break;
+            case TEXTURE_FORMAT_BC3_UNORM:
+            case TEXTURE_FORMAT_BC3_SRGB:
+                decode_color_block(block_input + 8, true, block);
+                decode_channel_block(block_input, 3, block);
+                break;
+            case TEXTURE_FORMAT_BC4_UNORM:
+            case TEXTURE_FORMAT_BC5_UNORM:
+                for (int i = 0; i < 16; ++i) {
+                    block[i * 4 + 1] = 0;
+                    block[i * 4 + 2] = 0;
+                    block[i * 4 + 3] = 255;
+                }
+                decode_channel_block(block_input, 0, block);
+                if (vk_format == TEXTURE_FORMAT_BC5_UNORM) {
+                    decode_channel_block(block_input + 8, 1, block);
+                }
+                break;
+            }
+
+            for (uint32_t y = 0; y < 4 && block_y + y < height; ++y) {
+                for (uint32_t x = 0; x < 4 && block_x + x < width; ++x) {
+                    memcpy(rgba + ((size_t)(block_y + y) * width + block_x + x) * 4, block + (y * 4 + x) * 4, 4);
+                }
+            }
+            block_input += block_bytes;
+        }
+    }
+    return true;
+}
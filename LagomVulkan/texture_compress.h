@@ -0,0 +1,21 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Block compression for the TEXTURE_FORMAT_* values in texture_file.h.
+// Blocks are 4x4 texels; edge blocks repeat the last row and column.
+// Uncompressed levels are tightly packed RGBA8 rows.
+
+bool is_texture_format_known(uint32_t vk_format);
+bool is_texture_format_compressed(uint32_t vk_format);
+bool is_texture_format_srgb(uint32_t vk_format);
+// Byte size of one level in the given format.
+size_t get_texture_level_size(uint32_t vk_format, uint32_t width, uint32_t height);
+// RGBA8 format with the same color space, what compressed textures decode to.
+uint32_t get_texture_decoded_format(uint32_t vk_format);
+
+// Fills output with one level compressed from RGBA8 texels.
+bool compress_texture_level(uint32_t vk_format, const uint8_t* rgba, uint32_t width, uint32_t height, std::vector<uint8_t>* output);
+// Writes width * height RGBA8 texels. BC4 and BC5 fill the missing channels with 0 and alpha with 255.
+bool decompress_texture_level(uint32_t vk_format, const uint8_t* data, size_t size, uint32_t width, uint32_t height, uint8_t* rgba);
@@ -0,0 +1,83 @@
+#include "texture_file.h"
+#include "texture_compress.h"
+
+#include <algorithm>
+#include <string.h>
+
+static const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+// Identifier, nine header words, then the data format, key/value and supercompression index.
+constexpr size_t KTX2_LEVEL_INDEX_OFFSET = 80;
+constexpr size_t KTX2_LEVEL_INDEX_SIZE = 24;
+
+static uint32_t read_u32(const uint8_t* bytes)
+{
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+static uint64_t read_u64(const uint8_t* bytes)
+{
+    return (uint64_t)read_u32(bytes) | ((uint64_t)read_u32(bytes + 4) << 32);
+}
+
+bool parse_ktx2(const uint8_t* data, size_t size, TextureFile* texture)
+{
+    if (size < KTX2_LEVEL_INDEX_OFFSET || memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0) {
+        return false;
+    }
+
+    texture->vk_format = read_u32(data + 12);
+    texture->width = read_u32(data + 20);
+    texture->height = read_u32(data + 24);
+    uint32_t depth = read_u32(data + 28);
+    uint32_t layer_count = read_u32(data + 32);
+    uint32_t face_count = read_u32(data + 36);
+    texture->level_count = read_u32(data + 40);
+    uint32_t supercompression = read_u32(data + 44);
+
+    // A level count of 0 asks the loader to generate mips, we just use the base level.
+    if (texture->level_count == 0) {
+        texture->level_count = 1;
+    }
+    if (!is_texture_format_known(texture->vk_format) || texture->width == 0 || texture->height == 0 ||
+        texture->width > TEXTURE_MAX_SIZE || texture->height > TEXTURE_MAX_SIZE || depth > 1 ||
+        layer_count > 1 || face_count != 1 || supercompression != 0 || texture->level_count > TEXTURE_MAX_LEVELS ||
+        size < KTX2_LEVEL_INDEX_OFFSET + texture->level_count * KTX2_LEVEL_INDEX_SIZE) {
+        return false;
+    }
+
+    // The chain ends at 1x1, deeper levels would be invalid mipLevels for the image.
+    uint32_t max_level_count = 1;
+    for (uint32_t extent = std::max(texture->width, texture->height); extent > 1; extent >>= 1) {
+        ++max_level_count;
+    }
+    if (texture->level_count > max_level_count) {
+        return false;
+    }
+
+    for (uint32_t level = 0; level < texture->level_count; ++level) {
+        const uint8_t* index = data + KTX2_LEVEL_INDEX_OFFSET + level * KTX2_LEVEL_INDEX_SIZE;
+        uint64_t offset = read_u64(index);
+        uint64_t length = read_u64(index + 8);
+        size_t level_size = get_texture_level_size(texture->vk_format,
+            get_texture_level_width(*texture, level), get_texture_level_height(*texture, level));
+        if (length < level_size || offset > size || length > size - offset) {
+            return false;
+        }
+        texture->levels[level].data = data + offset;
+        texture->levels[level].size = (size_t)length;
+    }
+    return true;
+}
+
+uint32_t get_texture_level_width(const TextureFile& texture, uint32_t level)
+{
+    uint32_t width = texture.width >> level;
+    return width > 0 ? width : 1;
+}
+
+uint32_t get_texture_level_height(const TextureFile& texture, uint32_t level)
+{
+    uint32_t height = texture.height >> level;
+    return height > 0 ? height : 1;
+}
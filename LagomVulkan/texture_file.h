@@ -0,0 +1,41 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+constexpr uint32_t TEXTURE_MAX_LEVELS = 16;
+// Largest width or height accepted, keeps level sizes in 32 bits.
+constexpr uint32_t TEXTURE_MAX_SIZE = 16384;
+
+// VkFormat values the baker writes and the streamer can decode.
+constexpr uint32_t TEXTURE_FORMAT_R8G8B8A8_UNORM = 37;
+constexpr uint32_t TEXTURE_FORMAT_R8G8B8A8_SRGB = 43;
+constexpr uint32_t TEXTURE_FORMAT_BC1_RGB_UNORM = 131;
+constexpr uint32_t TEXTURE_FORMAT_BC1_RGB_SRGB = 132;
+constexpr uint32_t TEXTURE_FORMAT_BC3_UNORM = 137;
+constexpr uint32_t TEXTURE_FORMAT_BC3_SRGB = 138;
+constexpr uint32_t TEXTURE_FORMAT_BC4_UNORM = 139;
+constexpr uint32_t TEXTURE_FORMAT_BC5_UNORM = 141;
+
+struct TextureLevel {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+// Format and mip chain of a KTX2 file. Level 0 is the most detailed one,
+// level data points into the memory that was parsed, nothing is copied.
+struct TextureFile {
+    // VkFormat value, kept as a plain integer so tools don't need Vulkan headers.
+    uint32_t vk_format = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t level_count = 0;
+    TextureLevel levels[TEXTURE_MAX_LEVELS];
+};
+
+// Single layer, single face 2D textures without supercompression only, in a
+// format is_texture_format_known() accepts. Every level must hold at least
+// get_texture_level_size() bytes, so it can be copied to an image as is.
+bool parse_ktx2(const uint8_t* data, size_t size, TextureFile* texture);
+
+uint32_t get_texture_level_width(const TextureFile& texture, uint32_t level);
+uint32_t get_texture_level_height(const TextureFile& texture, uint32_t level);
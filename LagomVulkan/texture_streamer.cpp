@@ -0,0 +1,625 @@
+#include "texture_streamer.h"
+#include "renderer.h"
+#include "shared.h"
+#include "texture_compress.h"
+
+#include <cstring>
+#include <iostream>
+
+// Keeps staging offsets valid for every texel and block size the baker writes.
+constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static uint32_t get_largest_size(const TextureFile& texture, uint32_t level)
+{
+    uint32_t width = get_texture_level_width(texture, level);
+    uint32_t height = get_texture_level_height(texture, level);
+    return width > height ? width : height;
+}
+
+static uint32_t get_tail_level(const TextureFile& texture)
+{
+    uint32_t tail_level = texture.level_count - 1;
+    while (tail_level > 0 && get_largest_size(texture, tail_level - 1) <= TEXTURE_MIN_RESIDENT_SIZE) {
+        --tail_level;
+    }
+    return tail_level;
+}
+
+static void touch_pages(const uint8_t* data, size_t size)
+{
+    volatile uint8_t touch = 0;
+    for (size_t offset = 0; offset < size; offset += 4096) {
+        touch += data[offset];
+    }
+}
+
+TextureStreamer::TextureStreamer(Renderer* renderer, VkDeviceSize budget_bytes, VkDeviceSize staging_frame_size, uint32_t frame_count)
+{
+    _renderer = renderer;
+    _budget_bytes = budget_bytes;
+    _staging_frame_size = align_up(staging_frame_size, STAGING_ALIGNMENT);
+    _frame_count = frame_count > 0 ? frame_count : 1;
+
+    _init_staging();
+    _init_sampler();
+
+    for (uint32_t i = 0; i < TEXTURE_STREAMER_WORKERS; ++i) {
+        _workers.emplace_back(&TextureStreamer::_worker_main, this);
+    }
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _quit = true;
+        _jobs.clear();
+    }
+    _jobs_ready.notify_all();
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+
+    VkDevice device = _renderer->get_vulkan_device();
+    for (auto& retired : _retired) {
+        vkDestroyImageView(device, retired.view, nullptr);
+        vkFreeMemory(device, retired.memory, nullptr);
+        vkDestroyImage(device, retired.image, nullptr);
+    }
+    for (auto& entry : _entries) {
+        if (entry.image != VK_NULL_HANDLE) {
+            vkDestroyImageView(device, entry.view, nullptr);
+            vkFreeMemory(device, entry.memory, nullptr);
+            vkDestroyImage(device, entry.image, nullptr);
+        }
+    }
+
+    _deinit_sampler();
+    _deinit_staging();
+}
+
+void TextureStreamer::set_asset_pack(const AssetPack* pack)
+{
+    _pack = pack;
+}
+
+int TextureStreamer::load_texture(const std::string& filename)
+{
+    auto found = _ids.find(filename);
+    if (found != _ids.end()) {
+        return found->second;
+    }
+
+    int texture = (int)_entries.size();
+    _entries.emplace_back();
+    _entries.back().filename = filename;
+    _ids[filename] = texture;
+
+    Job job;
+    job.texture = texture;
+    job.filename = filename;
+    _queue_job(std::move(job));
+    return texture;
+}
+
+void TextureStreamer::request(int textureID, float screen_size)
+{
+    if (textureID < 0 || textureID >= (int)_entries.size()) {
+        return;
+    }
+    Entry& entry = _entries[textureID];
+    if (entry.last_requested != _frame || screen_size > entry.demand) {
+        entry.demand = screen_size;
+    }
+    entry.last_requested = _frame;
+}
+
+void TextureStreamer::update(VkCommandBuffer command_buffer)
+{
+    _frame_index = (_frame_index + 1) % _frame_count;
+    _staging_head = 0;
+
+    _retire_images();
+    _collect_results();
+    _raise_residency(command_buffer);
+    _process_uploads(command_buffer);
+
+    ++_frame;
+}
+
+const VkImageView TextureStreamer::get_vulkan_image_view(int textureID) const
+{
+    if (textureID < 0 || textureID >= (int)_entries.size()) {
+        return VK_NULL_HANDLE;
+    }
+    return _entries[textureID].view;
+}
+
+const VkSampler TextureStreamer::get_vulkan_sampler() const
+{
+    return _sampler;
+}
+
+uint32_t TextureStreamer::get_resident_level(int textureID) const
+{
+    if (textureID < 0 || textureID >= (int)_entries.size()) {
+        return 0;
+    }
+    return _entries[textureID].resident_level;
+}
+
+VkDeviceSize TextureStreamer::get_resident_bytes() const
+{
+    return _resident_bytes;
+}
+
+void TextureStreamer::_init_staging()
+{
+    create_buffer(_renderer->get_vulkan_device(), &_renderer->get_vulkan_physical_device_memory_properties(),
+        _staging_frame_size * _frame_count, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        &_staging_buffer, &_staging_memory);
+    error_check(vkMapMemory(_renderer->get_vulkan_device(), _staging_memory, 0, VK_WHOLE_SIZE, 0, (void**)&_staging_mapped));
+}
+
+void TextureStreamer::_deinit_staging()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+    vkUnmapMemory(device, _staging_memory);
+    vkFreeMemory(device, _staging_memory, nullptr);
+    vkDestroyBuffer(device, _staging_buffer, nullptr);
+}
+
+void TextureStreamer::_init_sampler()
+{
+    VkSamplerCreateInfo sampler_create_info{};
+    sampler_create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_create_info.magFilter = VK_FILTER_LINEAR;
+    sampler_create_info.minFilter = VK_FILTER_LINEAR;
+    sampler_create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    sampler_create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    sampler_create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    sampler_create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    sampler_create_info.maxAnisotropy = 1.0f;
+    sampler_create_info.compareOp = VK_COMPARE_OP_NEVER;
+    sampler_create_info.minLod = 0.0f;
+    // Images only hold their resident levels, so the level count varies per texture.
+    sampler_create_info.maxLod = (float)TEXTURE_MAX_LEVELS;
+    sampler_create_info.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+    error_check(vkCreateSampler(_renderer->get_vulkan_device(), &sampler_create_info, nullptr, &_sampler));
+}
+
+void TextureStreamer::_deinit_sampler()
+{
+    vkDestroySampler(_renderer->get_vulkan_device(), _sampler, nullptr);
+}
+
+void TextureStreamer::_worker_main()
+{
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _jobs_ready.wait(lock, [this]() { return _quit || !_jobs.empty(); });
+            if (_quit) {
+                return;
+            }
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+
+        Result result;
+        result.texture = job.texture;
+        result.top_level = job.top_level;
+        if (!job.filename.empty()) {
+            result.opened = _open(job.filename, result);
+            if (result.opened) {
+                // Smallest levels first, so something can be drawn as early as possible.
+                result.top_level = get_tail_level(result.source);
+                for (uint32_t level = result.source.level_count; level-- > result.top_level;) {
+                    touch_pages(result.source.levels[level].data, result.source.levels[level].size);
+                }
+            }
+            else {
+                std::cout << "Unable to load texture: " << job.filename << std::endl;
+            }
+        }
+        else {
+            // Fault the pages in here so the staging copy on the render thread doesn't wait on the disk.
+            touch_pages(job.level.data, job.level.size);
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _results.push_back(std::move(result));
+    }
+}
+
+bool TextureStreamer::_open(const std::string& filename, Result& result)
+{
+    if (_pack != nullptr) {
+        AssetView view = _pack->find(filename);
+        if (view.is_valid() && view.type == ASSET_TYPE_TEXTURE) {
+            return parse_ktx2(view.data, view.size, &result.source) && _make_sampleable(result);
+        }
+    }
+
+    result.file.reset(new MappedFile());
+    if (!result.file->open(filename) || !parse_ktx2(result.file->get_data(), result.file->get_size(), &result.source) ||
+        !_make_sampleable(result)) {
+        return false;
+    }
+    // Decoded textures don't need the mapping anymore.
+    if (!result.decoded.empty()) {
+        result.file.reset();
+    }
+    return true;
+}
+
+bool TextureStreamer::_make_sampleable(Result& result)
+{
+    TextureFile& source = result.source;
+    if (_is_format_supported(source.vk_format)) {
+        return true;
+    }
+    if (!is_texture_format_compressed(source.vk_format) || !_is_format_supported(get_texture_decoded_format(source.vk_format))) {
+        std::cout << "Texture format " << source.vk_format << " is not supported by the device" << std::endl;
+        return false;
+    }
+
+    size_t decoded_size = 0;
+    for (uint32_t level = 0; level < source.level_count; ++level) {
+        decoded_size += (size_t)get_texture_level_width(source, level) * get_texture_level_height(source, level) * 4;
+    }
+    result.decoded.resize(decoded_size);
+
+    uint8_t* decoded = result.decoded.data();
+    for (uint32_t level = 0; level < source.level_count; ++level) {
+        uint32_t width = get_texture_level_width(source, level);
+        uint32_t height = get_texture_level_height(source, level);
+        if (!decompress_texture_level(source.vk_format, source.levels[level].data, source.levels[level].size, width, height, decoded)) {
+            return false;
+        }
+        source.levels[level].data = decoded;
+        source.levels[level].size = (size_t)width * height * 4;
+        decoded += source.levels[level].size;
+    }
+    source.vk_format = get_texture_decoded_format(source.vk_format);
+    return true;
+}
+
+bool TextureStreamer::_is_format_supported(uint32_t vk_format) const
+{
+    // Block compressed formats also need the device feature, whatever the format properties say.
+    if (is_texture_format_compressed(vk_format) && !_renderer->get_vulkan_enabled_features().textureCompressionBC) {
+        return false;
+    }
+    VkFormatProperties format_properties{};
+    vkGetPhysicalDeviceFormatProperties(_renderer->get_vulkan_physical_device(), (VkFormat)vk_format, &format_properties);
+    VkFormatFeatureFlags required_features = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (format_properties.optimalTilingFeatures & required_features) == required_features;
+}
+
+void TextureStreamer::_collect_results()
+{
+    std::vector<Result> results;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        results.swap(_results);
+    }
+
+    for (auto& result : results) {
+        Entry& entry = _entries[result.texture];
+        if (entry.state == State::OPENING) {
+            if (!result.opened) {
+                entry.state = State::FAILED;
+                continue;
+            }
+            entry.state = State::READY;
+            entry.file = std::move(result.file);
+            entry.decoded = std::move(result.decoded);
+            entry.source = result.source;
+            entry.resident_level = entry.source.level_count;
+            entry.tail_level = result.top_level;
+            entry.streaming = true;
+        }
+
+        Upload upload;
+        upload.texture = result.texture;
+        upload.top_level = result.top_level;
+        _uploads.push_back(upload);
+    }
+}
+
+void TextureStreamer::_process_uploads(VkCommandBuffer command_buffer)
+{
+    while (!_uploads.empty()) {
+        Upload upload = _uploads.front();
+        Entry& entry = _entries[upload.texture];
+
+        VkDeviceSize staging_bytes = 0;
+        for (uint32_t level = upload.top_level; level < entry.resident_level; ++level) {
+            staging_bytes = align_up(staging_bytes, STAGING_ALIGNMENT) + entry.source.levels[level].size;
+        }
+
+        if (staging_bytes > _staging_frame_size) {
+            // Would never fit, the texture stays at the levels it has.
+            std::cout << "Texture level too large to stream: " << entry.filename << std::endl;
+            entry.top_level_limit = entry.resident_level;
+            if (entry.image == VK_NULL_HANDLE) {
+                entry.state = State::FAILED;
+            }
+        }
+        else if (_staging_head > 0 && align_up(_staging_head, STAGING_ALIGNMENT) + staging_bytes > _staging_frame_size) {
+            // Out of staging space for this frame, carry on next frame.
+            return;
+        }
+        else {
+            _replace_image(entry, upload.top_level, command_buffer);
+        }
+
+        _pending_bytes -= entry.pending_bytes;
+        entry.pending_bytes = 0;
+        entry.streaming = false;
+        _uploads.pop_front();
+    }
+}
+
+void TextureStreamer::_raise_residency(VkCommandBuffer command_buffer)
+{
+    for (uint32_t i = 0; i < _entries.size(); ++i) {
+        Entry& entry = _entries[i];
+        if (entry.state != State::READY || entry.streaming || entry.image == VK_NULL_HANDLE) {
+            continue;
+        }
+        if (_get_wanted_level(entry) >= entry.resident_level || entry.resident_level <= entry.top_level_limit) {
+            continue;
+        }
+
+        // One level at a time, each one is drawable as soon as it lands.
+        uint32_t top_level = entry.resident_level - 1;
+        VkDeviceSize bytes = _get_level_bytes(entry, top_level, entry.resident_level);
+        if (!_make_room(bytes, (int)i, command_buffer)) {
+            continue;
+        }
+
+        entry.streaming = true;
+        entry.pending_bytes = bytes;
+        _pending_bytes += bytes;
+
+        Job job;
+        job.texture = (int)i;
+        job.top_level = top_level;
+        job.level = entry.source.levels[top_level];
+        _queue_job(std::move(job));
+    }
+}
+
+bool TextureStreamer::_make_room(VkDeviceSize bytes, int texture, VkCommandBuffer command_buffer)
+{
+    // Textures holding more than they want go first, then ones nobody asked
+    // for this frame lose their top level. Least recently requested first.
+    while (_resident_bytes + _pending_bytes + bytes > _budget_bytes) {
+        Entry* victim = nullptr;
+        bool victim_excess = false;
+        for (uint32_t i = 0; i < _entries.size(); ++i) {
+            Entry& entry = _entries[i];
+            if ((int)i == texture || entry.state != State::READY || entry.streaming || entry.image == VK_NULL_HANDLE ||
+                entry.resident_level >= entry.tail_level) {
+                continue;
+            }
+            bool excess = entry.resident_level < _get_wanted_level(entry);
+            if (!excess && entry.last_requested == _frame) {
+                continue;
+            }
+            if (victim == nullptr || (excess && !victim_excess) ||
+                (excess == victim_excess && entry.last_requested < victim->last_requested)) {
+                victim = &entry;
+                victim_excess = excess;
+            }
+        }
+        if (victim == nullptr) {
+            return false;
+        }
+
+        uint32_t top_level = victim_excess ? _get_wanted_level(*victim) : victim->resident_level + 1;
+        _replace_image(*victim, top_level, command_buffer);
+    }
+    return true;
+}
+
+void TextureStreamer::_retire_images()
+{
+    VkDevice device = _renderer->get_vulkan_device();
+    size_t kept = 0;
+    for (size_t i = 0; i < _retired.size(); ++i) {
+        Retired& retired = _retired[i];
+        if (retired.frame + _frame_count <= _frame) {
+            vkDestroyImageView(device, retired.view, nullptr);
+            vkFreeMemory(device, retired.memory, nullptr);
+            vkDestroyImage(device, retired.image, nullptr);
+        }
+        else {
+            _retired[kept++] = retired;
+        }
+    }
+    _retired.resize(kept);
+}
+
+uint32_t TextureStreamer::_get_wanted_level(const Entry& entry) const
+{
+    if (entry.demand <= 0.0f || entry.last_requested + TEXTURE_DEMAND_TIMEOUT < _frame) {
+        return entry.tail_level;
+    }
+    // Smallest level that still has at least one texel per pixel.
+    uint32_t level = 0;
+    while (level < entry.tail_level && (float)get_largest_size(entry.source, level + 1) >= entry.demand) {
+        ++level;
+    }
+    return level;
+}
+
+VkDeviceSize TextureStreamer::_get_level_bytes(const Entry& entry, uint32_t top_level, uint32_t end_level) const
+{
+    VkDeviceSize bytes = 0;
+    for (uint32_t level = top_level; level < end_level; ++level) {
+        bytes += entry.source.levels[level].size;
+    }
+    return bytes;
+}
+
+void TextureStreamer::_replace_image(Entry& entry, uint32_t top_level, VkCommandBuffer command_buffer)
+{
+    VkDevice device = _renderer->get_vulkan_device();
+    VkFormat format = (VkFormat)entry.source.vk_format;
+    uint32_t level_count = entry.source.level_count - top_level;
+
+    VkImage image = VK_NULL_HANDLE;
+    VkImageCreateInfo image_create_info{};
+    image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_create_info.imageType = VK_IMAGE_TYPE_2D;
+    image_create_info.format = format;
+    image_create_info.extent.width = get_texture_level_width(entry.source, top_level);
+    image_create_info.extent.height = get_texture_level_height(entry.source, top_level);
+    image_create_info.extent.depth = 1;
+    image_create_info.mipLevels = level_count;
+    image_create_info.arrayLayers = 1;
+    image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_create_info.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    error_check(vkCreateImage(device, &image_create_info, nullptr, &image));
+
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkMemoryRequirements image_memory_requirements{};
+    vkGetImageMemoryRequirements(device, image, &image_memory_requirements);
+    VkMemoryAllocateInfo memory_allocate_info{};
+    memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    memory_allocate_info.allocationSize = image_memory_requirements.size;
+    memory_allocate_info.memoryTypeIndex = find_memory_type_index(&_renderer->get_vulkan_physical_device_memory_properties(), &image_memory_requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    error_check(vkAllocateMemory(device, &memory_allocate_info, nullptr, &memory));
+    error_check(vkBindImageMemory(device, image, memory, 0));
+
+    VkImageView view = VK_NULL_HANDLE;
+    VkImageViewCreateInfo image_view_create_info{};
+    image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    image_view_create_info.image = image;
+    image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    image_view_create_info.format = format;
+    image_view_create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+    image_view_create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+    image_view_create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+    image_view_create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    image_view_create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    image_view_create_info.subresourceRange.baseMipLevel = 0;
+    image_view_create_info.subresourceRange.levelCount = level_count;
+    image_view_create_info.subresourceRange.baseArrayLayer = 0;
+    image_view_create_info.subresourceRange.layerCount = 1;
+    error_check(vkCreateImageView(device, &image_view_create_info, nullptr, &view));
+
+    VkImageMemoryBarrier to_transfer{};
+    to_transfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    to_transfer.srcAccessMask = 0;
+    to_transfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    to_transfer.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    to_transfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    to_transfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    to_transfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    to_transfer.image = image;
+    to_transfer.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    to_transfer.subresourceRange.levelCount = level_count;
+    to_transfer.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(command_buffer,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &to_transfer);
+
+    if (entry.image != VK_NULL_HANDLE) {
+        VkImageMemoryBarrier to_source = to_transfer;
+        to_source.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        to_source.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        to_source.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        to_source.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        to_source.image = entry.image;
+        to_source.subresourceRange.levelCount = entry.source.level_count - entry.resident_level;
+        vkCmdPipelineBarrier(command_buffer,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &to_source);
+    }
+
+    // New levels come from staging, the rest are copied over from the old image.
+    VkDeviceSize partition_offset = _frame_index * _staging_frame_size;
+    for (uint32_t level = top_level; level < entry.source.level_count; ++level) {
+        uint32_t width = get_texture_level_width(entry.source, level);
+        uint32_t height = get_texture_level_height(entry.source, level);
+        if (level < entry.resident_level) {
+            const TextureLevel& source_level = entry.source.levels[level];
+            _staging_head = align_up(_staging_head, STAGING_ALIGNMENT);
+            std::memcpy(_staging_mapped + partition_offset + _staging_head, source_level.data, source_level.size);
+
+            VkBufferImageCopy region{};
+            region.bufferOffset = partition_offset + _staging_head;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel = level - top_level;
+            region.imageSubresource.layerCount = 1;
+            region.imageExtent.width = width;
+            region.imageExtent.height = height;
+            region.imageExtent.depth = 1;
+            vkCmdCopyBufferToImage(command_buffer, _staging_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+            _staging_head += source_level.size;
+        }
+        else {
+            VkImageCopy region{};
+            region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.srcSubresource.mipLevel = level - entry.resident_level;
+            region.srcSubresource.layerCount = 1;
+            region.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.dstSubresource.mipLevel = level - top_level;
+            region.dstSubresource.layerCount = 1;
+            region.extent.width = width;
+            region.extent.height = height;
+            region.extent.depth = 1;
+            vkCmdCopyImage(command_buffer, entry.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        }
+    }
+
+    VkImageMemoryBarrier to_shader = to_transfer;
+    to_shader.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    to_shader.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    to_shader.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    to_shader.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    vkCmdPipelineBarrier(command_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &to_shader);
+
+    // Earlier frames may still sample the old image.
+    if (entry.image != VK_NULL_HANDLE) {
+        Retired retired;
+        retired.image = entry.image;
+        retired.memory = entry.memory;
+        retired.view = entry.view;
+        retired.frame = _frame;
+        _retired.push_back(retired);
+        _resident_bytes -= entry.bytes;
+    }
+
+    entry.image = image;
+    entry.memory = memory;
+    entry.view = view;
+    entry.bytes = image_memory_requirements.size;
+    entry.resident_level = top_level;
+    _resident_bytes += entry.bytes;
+}
+
+void TextureStreamer::_queue_job(Job job)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _jobs.push_back(std::move(job));
+    }
+    _jobs_ready.notify_one();
+}
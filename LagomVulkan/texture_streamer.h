@@ -0,0 +1,179 @@
+#pragma once
+#include "platform.h"
+#include "asset_pack.h"
+#include "mapped_file.h"
+#include "texture_file.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class Renderer;
+
+constexpr uint32_t TEXTURE_STREAMER_WORKERS = 2;
+// Levels this size and smaller are loaded up front and never evicted.
+constexpr uint32_t TEXTURE_MIN_RESIDENT_SIZE = 64;
+// Frames without a request before a texture only wants its smallest levels.
+constexpr uint64_t TEXTURE_DEMAND_TIMEOUT = 120;
+
+// Streams KTX2 mip chains into sampled images. Files are mapped and their
+// pages faulted in on worker threads, smallest levels first; update()
+// copies finished levels through a per frame staging partition. Every
+// texture is one image holding its resident levels, raising or dropping
+// a level swaps in a new image and copies the kept levels across on the
+// GPU. Resident levels follow the screen size passed to request(), and
+// textures that aren't needed lose levels when the budget runs out.
+// Block compressed textures the device can't sample are decoded to RGBA8
+// on the workers.
+class TextureStreamer {
+public:
+    // staging_frame_size caps the bytes uploaded per frame.
+    TextureStreamer(Renderer* renderer, VkDeviceSize budget_bytes, VkDeviceSize staging_frame_size, uint32_t frame_count);
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // Textures found in the pack are used in place instead of mapping the file.
+    // Set before the first load, the pack must outlive the streamer.
+    void set_asset_pack(const AssetPack* pack);
+
+    // Returns the texture id, starts loading the smallest levels.
+    int load_texture(const std::string& filename);
+
+    // Largest size in pixels the texture covers on screen this frame.
+    void request(int textureID, float screen_size);
+
+    // Record once per frame outside a render pass, before anything samples
+    // the textures. Like UniformRing the caller must guarantee the GPU is
+    // done with the frame that is being reused.
+    void update(VkCommandBuffer command_buffer);
+
+    // VK_NULL_HANDLE until the first levels are uploaded. Changes whenever
+    // residency does, so fetch it again after every update().
+    const VkImageView get_vulkan_image_view(int textureID) const;
+    const VkSampler get_vulkan_sampler() const;
+
+    // Most detailed level in memory, the level count when nothing is.
+    uint32_t get_resident_level(int textureID) const;
+    VkDeviceSize get_resident_bytes() const;
+
+private:
+    enum class State {
+        OPENING,
+        READY,
+        FAILED,
+    };
+
+    struct Entry {
+        std::string filename;
+        State state = State::OPENING;
+        std::unique_ptr<MappedFile> file;
+        // Holds the levels when the file's format had to be decoded.
+        std::vector<uint8_t> decoded;
+        TextureFile source;
+
+        VkImage image = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkDeviceSize bytes = 0;
+
+        uint32_t resident_level = 0;
+        // Levels at and after this one are always resident.
+        uint32_t tail_level = 0;
+        // Levels that don't fit the staging partition are never streamed in.
+        uint32_t top_level_limit = 0;
+        // Level being faulted in or waiting for staging space.
+        bool streaming = false;
+        VkDeviceSize pending_bytes = 0;
+
+        float demand = 0.0f;
+        uint64_t last_requested = 0;
+    };
+
+    struct Job {
+        int texture = -1;
+        // Set when the file still has to be opened, the tail levels are faulted in with it.
+        std::string filename;
+        uint32_t top_level = 0;
+        TextureLevel level;
+    };
+
+    struct Result {
+        int texture = -1;
+        bool opened = false;
+        uint32_t top_level = 0;
+        std::unique_ptr<MappedFile> file;
+        std::vector<uint8_t> decoded;
+        TextureFile source;
+    };
+
+    struct Upload {
+        int texture = -1;
+        uint32_t top_level = 0;
+    };
+
+    struct Retired {
+        VkImage image = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        uint64_t frame = 0;
+    };
+
+    void _init_staging();
+    void _deinit_staging();
+
+    void _init_sampler();
+    void _deinit_sampler();
+
+    void _worker_main();
+    bool _open(const std::string& filename, Result& result);
+    bool _make_sampleable(Result& result);
+    bool _is_format_supported(uint32_t vk_format) const;
+    void _collect_results();
+    void _process_uploads(VkCommandBuffer command_buffer);
+    void _raise_residency(VkCommandBuffer command_buffer);
+    bool _make_room(VkDeviceSize bytes, int texture, VkCommandBuffer command_buffer);
+    void _retire_images();
+
+    uint32_t _get_wanted_level(const Entry& entry) const;
+    VkDeviceSize _get_level_bytes(const Entry& entry, uint32_t top_level, uint32_t end_level) const;
+    void _replace_image(Entry& entry, uint32_t top_level, VkCommandBuffer command_buffer);
+    void _queue_job(Job job);
+
+    Renderer* _renderer = nullptr;
+
+    std::vector<Entry> _entries;
+    std::unordered_map<std::string, int> _ids;
+    VkDeviceSize _budget_bytes = 0;
+    VkDeviceSize _resident_bytes = 0;
+    // Levels that passed the budget check but aren't uploaded yet.
+    VkDeviceSize _pending_bytes = 0;
+    uint64_t _frame = 0;
+    const AssetPack* _pack = nullptr;
+
+    VkBuffer _staging_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory _staging_memory = VK_NULL_HANDLE;
+    unsigned char* _staging_mapped = nullptr;
+    VkDeviceSize _staging_frame_size = 0;
+    VkDeviceSize _staging_head = 0;
+    uint32_t _frame_count = 1;
+    uint32_t _frame_index = 0;
+
+    VkSampler _sampler = VK_NULL_HANDLE;
+
+    std::deque<Upload> _uploads;
+    std::vector<Retired> _retired;
+
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _jobs_ready;
+    std::deque<Job> _jobs;
+    std::vector<Result> _results;
+    bool _quit = false;
+};
@@ -0,0 +1,227 @@
+#include "transform_hierarchy.h"
+#include "job_system.h"
+
+#include <algorithm>
+
+constexpr uint32_t NO_NODE = UINT32_MAX;
+// Nodes per job, enough that a chunk outweighs claiming it.
+constexpr uint32_t TRANSFORM_UPDATE_CHUNK = 1024;
+
+TransformHierarchy::TransformHierarchy()
+{
+}
+
+TransformHierarchy::~TransformHierarchy()
+{
+}
+
+int TransformHierarchy::create_node(int parentID)
+{
+    uint32_t parent = NO_NODE;
+    if (parentID >= 0) {
+        parent = _handles.find(parentID);
+        if (parent == NO_NODE) {
+            return -1;
+        }
+    }
+
+    int nodeID = _handles.create();
+    if (nodeID < 0) {
+        return -1;
+    }
+
+    // Appending keeps every parent ahead of its children, the depth order waits for update().
+    _parent.push_back(parent);
+    _depth.push_back(parent != NO_NODE ? _depth[parent] + 1 : 0);
+    for (auto& position : _position) {
+        position.push_back(0.0f);
+    }
+    for (uint32_t i = 0; i < 4; ++i) {
+        _rotation[i].push_back(i == 3 ? 1.0f : 0.0f);
+    }
+    _scale.push_back(1.0f);
+    _local.push_back(mat4_identity());
+    _world.push_back(mat4_identity());
+    _local_dirty.push_back(1);
+    _world_dirty.push_back(1);
+    _removed.push_back(0);
+    _order_dirty = true;
+    return nodeID;
+}
+
+void TransformHierarchy::destroy_node(int nodeID)
+{
+    uint32_t dense = _handles.find(nodeID);
+    if (dense == NO_NODE) {
+        return;
+    }
+    _handles.release(dense);
+    _removed[dense] = 1;
+    _order_dirty = true;
+}
+
+void TransformHierarchy::set_local_transform(int nodeID, const Vec3& position, const Quat& rotation, float scale)
+{
+    uint32_t dense = _handles.find(nodeID);
+    if (dense == NO_NODE) {
+        return;
+    }
+    _position[0][dense] = position.x;
+    _position[1][dense] = position.y;
+    _position[2][dense] = position.z;
+    _rotation[0][dense] = rotation.x;
+    _rotation[1][dense] = rotation.y;
+    _rotation[2][dense] = rotation.z;
+    _rotation[3][dense] = rotation.w;
+    _scale[dense] = scale;
+    _local_dirty[dense] = 1;
+}
+
+void TransformHierarchy::update(JobSystem* jobs)
+{
+    if (_order_dirty) {
+        _sort_by_depth();
+    }
+
+    // A level only reads the level above it, which is finished by then.
+    for (size_t level = 0; level + 1 < _level_begin.size(); ++level) {
+        uint32_t begin = _level_begin[level];
+        uint32_t count = _level_begin[level + 1] - begin;
+        if (jobs != nullptr) {
+            jobs->parallel_for(count, TRANSFORM_UPDATE_CHUNK, [this, begin](uint32_t first, uint32_t last) {
+                _update_range(begin + first, begin + last);
+            });
+        }
+        else {
+            _update_range(begin, begin + count);
+        }
+    }
+    std::fill(_local_dirty.begin(), _local_dirty.end(), (uint8_t)0);
+}
+
+const Mat4& TransformHierarchy::get_world_matrix(int nodeID) const
+{
+    static const Mat4 identity = mat4_identity();
+    uint32_t dense = _handles.find(nodeID);
+    return dense != NO_NODE ? _world[dense] : identity;
+}
+
+uint32_t TransformHierarchy::get_node_count() const
+{
+    return _handles.size();
+}
+
+uint32_t TransformHierarchy::get_level_count() const
+{
+    return _level_begin.empty() ? 0 : (uint32_t)_level_begin.size() - 1;
+}
+
+void TransformHierarchy::_sort_by_depth()
+{
+    // Parents come first, so one forward pass carries removal down through the subtrees.
+    uint32_t count = _handles.size();
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!_removed[i] && _parent[i] != NO_NODE && _removed[_parent[i]]) {
+            _handles.release(i);
+            _removed[i] = 1;
+        }
+    }
+
+    // Counting sort of the survivors, stable so parents stay ahead of their children within a level too.
+    uint32_t level_count = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!_removed[i]) {
+            level_count = std::max(level_count, _depth[i] + 1);
+        }
+    }
+    _level_begin.assign(level_count + 1, 0);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!_removed[i]) {
+            ++_level_begin[_depth[i] + 1];
+        }
+    }
+    for (uint32_t level = 0; level < level_count; ++level) {
+        _level_begin[level + 1] += _level_begin[level];
+    }
+
+    std::vector<uint32_t> fill(_level_begin.begin(), _level_begin.end() - 1);
+    std::vector<uint32_t> old_of_new(_level_begin.back());
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!_removed[i]) {
+            old_of_new[fill[_depth[i]]++] = i;
+        }
+    }
+    _reorder(old_of_new);
+    _order_dirty = false;
+}
+
+void TransformHierarchy::_reorder(const std::vector<uint32_t>& old_of_new)
+{
+    std::vector<uint32_t> new_of_old(_parent.size(), NO_NODE);
+    for (uint32_t i = 0; i < (uint32_t)old_of_new.size(); ++i) {
+        new_of_old[old_of_new[i]] = i;
+    }
+
+    _handles.reorder(old_of_new);
+    reorder_array(_parent, old_of_new);
+    reorder_array(_depth, old_of_new);
+    for (auto& position : _position) {
+        reorder_array(position, old_of_new);
+    }
+    for (auto& rotation : _rotation) {
+        reorder_array(rotation, old_of_new);
+    }
+    reorder_array(_scale, old_of_new);
+    reorder_array(_local, old_of_new);
+    reorder_array(_world, old_of_new);
+    reorder_array(_local_dirty, old_of_new);
+    reorder_array(_world_dirty, old_of_new);
+    reorder_array(_removed, old_of_new);
+
+    for (uint32_t i = 0; i < _handles.size(); ++i) {
+        if (_parent[i] != NO_NODE) {
+            _parent[i] = new_of_old[_parent[i]];
+        }
+    }
+}
+
+void TransformHierarchy::_update_range(uint32_t begin, uint32_t end)
+{
+    // Parents were handled a level up, their world flag passes down.
+    for (uint32_t i = begin; i < end; ++i) {
+        _world_dirty[i] = _local_dirty[i] | (_parent[i] != NO_NODE ? _world_dirty[_parent[i]] : 0);
+    }
+
+    // Local matrices of a run of dirty nodes go through the batched kernel together.
+    uint32_t i = begin;
+    while (i < end) {
+        if (!_local_dirty[i]) {
+            ++i;
+            continue;
+        }
+        uint32_t run_end = i + 1;
+        while (run_end < end && _local_dirty[run_end]) {
+            ++run_end;
+        }
+        TransformArrays transforms = {
+            { &_position[0][i], &_position[1][i], &_position[2][i] },
+            { &_rotation[0][i], &_rotation[1][i], &_rotation[2][i], &_rotation[3][i] },
+            &_scale[i]
+        };
+        compose_matrices(&_local[i], transforms, run_end - i);
+        i = run_end;
+    }
+
+    // Nodes only moved by a parent keep their local matrix.
+    for (i = begin; i < end; ++i) {
+        if (!_world_dirty[i]) {
+            continue;
+        }
+        if (_parent[i] != NO_NODE) {
+            multiply_matrices(&_world[i], &_world[_parent[i]], &_local[i], 1);
+        }
+        else {
+            _world[i] = _local[i];
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "handle_table.h"
+#include "simd_math.h"
+
+class JobSystem;
+
+// Parent relative transforms kept as flat arrays sorted by depth, every
+// parent ahead of its children. Setting a local transform marks the node
+// dirty, update() walks the levels top down, recomposes the local matrices
+// of dirty nodes and re-multiplies world matrices for them and everything
+// under them. Nodes of one level don't depend on each other, so each level
+// is split across the job system. Creating and destroying nodes only marks
+// the change, the next update() drops destroyed subtrees and re-sorts in
+// one pass.
+class TransformHierarchy {
+public:
+    TransformHierarchy();
+    ~TransformHierarchy();
+
+    // parentID -1 makes a root. Nodes start at the identity.
+    int create_node(int parentID);
+    // Destroys the node and everything below it. Ids below the node stay
+    // valid until the next update().
+    void destroy_node(int nodeID);
+    void set_local_transform(int nodeID, const Vec3& position, const Quat& rotation, float scale);
+
+    // Once per frame before reading world matrices. jobs may be null to run on the calling thread.
+    void update(JobSystem* jobs);
+
+    const Mat4& get_world_matrix(int nodeID) const;
+    uint32_t get_node_count() const;
+    uint32_t get_level_count() const;
+
+private:
+    void _sort_by_depth();
+    void _reorder(const std::vector<uint32_t>& old_of_new);
+    void _update_range(uint32_t begin, uint32_t end);
+
+    // Hierarchies run past the 16 bit slots used for other handles.
+    HandleTable<20> _handles;
+
+    // Dense arrays, one entry per live node. _parent is a dense index.
+    std::vector<uint32_t> _parent;
+    std::vector<uint32_t> _depth;
+    std::vector<float> _position[3];
+    std::vector<float> _rotation[4];
+    std::vector<float> _scale;
+    std::vector<Mat4> _local;
+    std::vector<Mat4> _world;
+    // Set with a new local transform, world dirty also covers nodes under one.
+    std::vector<uint8_t> _local_dirty;
+    std::vector<uint8_t> _world_dirty;
+    // Destroyed, dropped with the subtree on the next update().
+    std::vector<uint8_t> _removed;
+
+    // First dense index of each depth, plus the end.
+    std::vector<uint32_t> _level_begin;
+    bool _order_dirty = false;
+};
@@ -0,0 +1,137 @@
+#include "uniform_ring.h"
+#include "renderer.h"
+#include "shared.h"
+
+#include <algorithm>
+
+static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+UniformRing::UniformRing(Renderer* renderer, VkDeviceSize frame_size, uint32_t frame_count)
+{
+    _renderer = renderer;
+    _frame_count = frame_count;
+
+    const VkPhysicalDeviceLimits& limits = _renderer->get_vulkan_physical_device_properties().limits;
+    _alignment = std::max<VkDeviceSize>(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment);
+    _alignment = std::max<VkDeviceSize>(_alignment, 1);
+    _atom_size = std::max<VkDeviceSize>(limits.nonCoherentAtomSize, 1);
+
+    // Every partition starts on an alignment that is valid both as dynamic offset and flush offset.
+    _frame_size = align_up(frame_size, std::max(_alignment, _atom_size));
+
+    _init_buffer();
+    _init_memory();
+}
+
+UniformRing::~UniformRing()
+{
+    _deinit_memory();
+    _deinit_buffer();
+}
+
+void UniformRing::begin_frame()
+{
+    _frame_index = (_frame_index + 1) % _frame_count;
+    _head = 0;
+    _flushed_head = 0;
+}
+
+void* UniformRing::allocate(VkDeviceSize size, uint32_t* dynamic_offset)
+{
+    VkDeviceSize offset = align_up(_head, _alignment);
+    if (offset + size > _frame_size) {
+        assert(0 && "Uniform ring frame partition exhausted");
+        return nullptr;
+    }
+    _head = offset + size;
+
+    VkDeviceSize buffer_offset = _frame_index * _frame_size + offset;
+    if (dynamic_offset != nullptr) {
+        *dynamic_offset = (uint32_t)buffer_offset;
+    }
+    return _mapped + buffer_offset;
+}
+
+void UniformRing::flush()
+{
+    if (_coherent || _head == _flushed_head) {
+        return;
+    }
+
+    VkDeviceSize frame_base = _frame_index * _frame_size;
+    VkDeviceSize begin = _flushed_head / _atom_size * _atom_size;
+    VkDeviceSize end = std::min(align_up(_head, _atom_size), _frame_size);
+
+    VkMappedMemoryRange range{};
+    range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range.memory = _memory;
+    range.offset = frame_base + begin;
+    range.size = end - begin;
+    error_check(vkFlushMappedMemoryRanges(_renderer->get_vulkan_device(), 1, &range));
+
+    _flushed_head = _head;
+}
+
+const VkBuffer UniformRing::get_vulkan_buffer() const
+{
+    return _buffer;
+}
+
+const VkDeviceSize UniformRing::get_frame_size() const
+{
+    return _frame_size;
+}
+
+const VkDeviceSize UniformRing::get_alignment() const
+{
+    return _alignment;
+}
+
+void UniformRing::_init_buffer()
+{
+    VkBufferCreateInfo buffer_create_info{};
+    buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_create_info.size = _frame_size * _frame_count;
+    buffer_create_info.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    error_check(vkCreateBuffer(_renderer->get_vulkan_device(), &buffer_create_info, nullptr, &_buffer));
+}
+
+void UniformRing::_deinit_buffer()
+{
+    vkDestroyBuffer(_renderer->get_vulkan_device(), _buffer, nullptr);
+}
+
+void UniformRing::_init_memory()
+{
+    VkMemoryRequirements memory_requirements{};
+    vkGetBufferMemoryRequirements(_renderer->get_vulkan_device(), _buffer, &memory_requirements);
+
+    const VkPhysicalDeviceMemoryProperties& memory_properties = _renderer->get_vulkan_physical_device_memory_properties();
+    uint32_t memory_index = find_memory_type_index(&memory_properties, &memory_requirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+    _coherent = (memory_properties.memoryTypes[memory_index].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+    VkMemoryAllocateInfo memory_allocate_info{};
+    memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    memory_allocate_info.allocationSize = memory_requirements.size;
+    memory_allocate_info.memoryTypeIndex = memory_index;
+
+    error_check(vkAllocateMemory(_renderer->get_vulkan_device(), &memory_allocate_info, nullptr, &_memory));
+    error_check(vkBindBufferMemory(_renderer->get_vulkan_device(), _buffer, _memory, 0));
+
+    // Mapped once for the lifetime of the ring.
+    void* mapped = nullptr;
+    error_check(vkMapMemory(_renderer->get_vulkan_device(), _memory, 0, VK_WHOLE_SIZE, 0, &mapped));
+    _mapped = (unsigned char*)mapped;
+}
+
+void UniformRing::_deinit_memory()
+{
+    vkUnmapMemory(_renderer->get_vulkan_device(), _memory);
+    vkFreeMemory(_renderer->get_vulkan_device(), _memory, nullptr);
+    _mapped = nullptr;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "platform.h"
+
+class Renderer;
+
+// Persistently mapped ring of uniform/storage memory, split into one
+// partition per frame in flight. Per-draw data is written straight into
+// the mapping and bound through dynamic descriptor offsets.
+class UniformRing {
+public:
+    UniformRing(Renderer* renderer, VkDeviceSize frame_size, uint32_t frame_count);
+    ~UniformRing();
+
+    // Move to the next frame partition. The caller must guarantee the GPU
+    // is done with the partition that is being reused.
+    void begin_frame();
+
+    // Returns a pointer into mapped memory and the dynamic offset to bind,
+    // or nullptr when the frame partition is exhausted.
+    void* allocate(VkDeviceSize size, uint32_t* dynamic_offset);
+
+    // Flush everything written this frame, only does work on non coherent memory.
+    void flush();
+
+    const VkBuffer get_vulkan_buffer() const;
+    const VkDeviceSize get_frame_size() const;
+    const VkDeviceSize get_alignment() const;
+
+private:
+    void _init_buffer();
+    void _deinit_buffer();
+
+    void _init_memory();
+    void _deinit_memory();
+
+    Renderer* _renderer = nullptr;
+
+    VkBuffer _buffer = VK_NULL_HANDLE;
+    VkDeviceMemory _memory = VK_NULL_HANDLE;
+    unsigned char* _mapped = nullptr;
+
+    VkDeviceSize _frame_size = 0;
+    VkDeviceSize _alignment = 1;
+    VkDeviceSize _atom_size = 1;
+    uint32_t _frame_count = 1;
+    uint32_t _frame_index = 0;
+
+    VkDeviceSize _head = 0;
+    VkDeviceSize _flushed_head = 0;
+
+    bool _coherent = false;
+};
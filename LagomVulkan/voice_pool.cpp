@@ -0,0 +1,173 @@
+#include "voice_pool.h"
+
+#include <assert.h>
+#include <cstdlib>
+#include <iostream>
+
+// Handle layout: voice index + 1 in the low 16 bits, generation in the high 16.
+static SoundHandle make_handle(uint32_t index, uint16_t generation)
+{
+    SoundHandle handle;
+    handle.id = ((uint32_t)generation << 16) | (index + 1);
+    return handle;
+}
+
+VoicePool::VoicePool(uint32_t voice_count)
+{
+    assert(voice_count > 0 && voice_count < 0xFFFF);
+    _voices.resize(voice_count);
+
+    alGetError();
+    for (auto& voice : _voices) {
+        alGenSources(1, &voice.source);
+        // Distance attenuation is computed on our side.
+        alSourcef(voice.source, AL_ROLLOFF_FACTOR, 0.0f);
+        alSourcei(voice.source, AL_SOURCE_RELATIVE, AL_TRUE);
+        alSource3f(voice.source, AL_POSITION, 0.0f, 0.0f, 0.0f);
+    }
+    ALenum error = alGetError();
+    if (error != AL_NO_ERROR) {
+        std::cout << "Error: " << error << " ";
+        assert(0 && "Unable to alGenSources for the voice pool");
+        std::exit(-1);
+    }
+}
+
+VoicePool::~VoicePool()
+{
+    for (auto& voice : _voices) {
+        alSourceStop(voice.source);
+        alDeleteSources(1, &voice.source);
+    }
+}
+
+SoundHandle VoicePool::play(ALuint buffer, float gain, int priority, bool loop)
+{
+    // Prefer a free voice, otherwise the lowest priority, quietest, oldest one.
+    Voice* chosen = nullptr;
+    for (auto& voice : _voices) {
+        if (!voice.active) {
+            chosen = &voice;
+            break;
+        }
+        if (chosen == nullptr ||
+            voice.priority < chosen->priority ||
+            (voice.priority == chosen->priority && voice.audibility < chosen->audibility) ||
+            (voice.priority == chosen->priority && voice.audibility == chosen->audibility && voice.start_order < chosen->start_order)) {
+            chosen = &voice;
+        }
+    }
+
+    if (chosen->active) {
+        // Don't cut off something that matters more than the new sound.
+        if (chosen->priority > priority || (chosen->priority == priority && chosen->audibility > gain)) {
+            return SoundHandle();
+        }
+        _release(*chosen);
+    }
+
+    alSourcei(chosen->source, AL_BUFFER, (ALint)buffer);
+    alSourcef(chosen->source, AL_GAIN, gain);
+    alSourcei(chosen->source, AL_LOOPING, loop ? AL_TRUE : AL_FALSE);
+    alSourcePlay(chosen->source);
+
+    chosen->active = true;
+    chosen->priority = priority;
+    chosen->audibility = gain;
+    chosen->start_order = _start_counter++;
+    return make_handle((uint32_t)(chosen - _voices.data()), chosen->generation);
+}
+
+void VoicePool::stop(SoundHandle sound)
+{
+    Voice* voice = _find_voice(sound);
+    if (voice != nullptr) {
+        _release(*voice);
+    }
+}
+
+bool VoicePool::is_playing(SoundHandle sound) const
+{
+    return _find_voice(sound) != nullptr;
+}
+
+void VoicePool::set_gain(SoundHandle sound, float gain)
+{
+    Voice* voice = _find_voice(sound);
+    if (voice != nullptr) {
+        alSourcef(voice->source, AL_GAIN, gain);
+        voice->audibility = gain;
+    }
+}
+
+void VoicePool::set_position(SoundHandle sound, float x, float y, float z)
+{
+    Voice* voice = _find_voice(sound);
+    if (voice != nullptr) {
+        if (!voice->positional) {
+            alSourcei(voice->source, AL_SOURCE_RELATIVE, AL_FALSE);
+            voice->positional = true;
+        }
+        alSource3f(voice->source, AL_POSITION, x, y, z);
+    }
+}
+
+void VoicePool::update()
+{
+    for (auto& voice : _voices) {
+        if (!voice.active) {
+            continue;
+        }
+        ALint state = AL_STOPPED;
+        alGetSourcei(voice.source, AL_SOURCE_STATE, &state);
+        if (state == AL_STOPPED) {
+            _release(voice);
+        }
+    }
+}
+
+ALuint VoicePool::get_source(SoundHandle sound) const
+{
+    const Voice* voice = _find_voice(sound);
+    return voice != nullptr ? voice->source : 0;
+}
+
+uint32_t VoicePool::get_voice_count() const
+{
+    return (uint32_t)_voices.size();
+}
+
+VoicePool::Voice* VoicePool::_find_voice(SoundHandle sound)
+{
+    return const_cast<Voice*>(static_cast<const VoicePool*>(this)->_find_voice(sound));
+}
+
+const VoicePool::Voice* VoicePool::_find_voice(SoundHandle sound) const
+{
+    uint32_t index = (sound.id & 0xFFFF) - 1;
+    uint16_t generation = (uint16_t)(sound.id >> 16);
+    if (sound.id == 0 || index >= _voices.size()) {
+        return nullptr;
+    }
+    const Voice& voice = _voices[index];
+    if (!voice.active || voice.generation != generation) {
+        return nullptr;
+    }
+    return &voice;
+}
+
+void VoicePool::_release(Voice& voice)
+{
+    alSourceStop(voice.source);
+    alSourcei(voice.source, AL_BUFFER, 0);
+    if (voice.positional) {
+        alSourcei(voice.source, AL_SOURCE_RELATIVE, AL_TRUE);
+        alSource3f(voice.source, AL_POSITION, 0.0f, 0.0f, 0.0f);
+        voice.positional = false;
+    }
+    voice.active = false;
+    // Generation 0 is skipped so a live handle is never 0.
+    if (++voice.generation == 0) {
+        voice.generation = 1;
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <al.h>
+#include <stdint.h>
+#include <vector>
+#include "audio.h"
+
+// Fixed set of OpenAL sources created up front. play() hands out a free
+// voice or steals the least important one, so triggering sounds never
+// creates or deletes sources. Handles carry a generation and go stale
+// once their voice is reused. Voices play listener-relative at the origin
+// until given a position; OpenAL's own distance attenuation is turned off.
+class VoicePool {
+public:
+    // Needs a current AL context.
+    VoicePool(uint32_t voice_count);
+    ~VoicePool();
+
+    VoicePool(const VoicePool&) = delete;
+    VoicePool& operator=(const VoicePool&) = delete;
+
+    // Returns an invalid handle if every voice is busy with something more important.
+    SoundHandle play(ALuint buffer, float gain, int priority, bool loop);
+    void stop(SoundHandle sound);
+    bool is_playing(SoundHandle sound) const;
+    void set_gain(SoundHandle sound, float gain);
+    // Places the voice in world space for panning.
+    void set_position(SoundHandle sound, float x, float y, float z);
+
+    // Returns finished voices to the pool.
+    void update();
+
+    // Source of a live handle, 0 if it went stale.
+    ALuint get_source(SoundHandle sound) const;
+    uint32_t get_voice_count() const;
+
+private:
+    struct Voice {
+        ALuint source = 0;
+        uint16_t generation = 1;
+        bool active = false;
+        int priority = 0;
+        // Current gain, the rough loudness when comparing voices.
+        float audibility = 0.0f;
+        uint64_t start_order = 0;
+        // World positioned rather than listener relative, set by the first set_position.
+        bool positional = false;
+    };
+
+    Voice* _find_voice(SoundHandle sound);
+    const Voice* _find_voice(SoundHandle sound) const;
+    void _release(Voice& voice);
+
+    std::vector<Voice> _voices;
+    uint64_t _start_counter = 0;
+};
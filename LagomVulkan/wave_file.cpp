@@ -0,0 +1,77 @@
+#include "wave_file.h"
+
+#include <string.h>
+
+static uint16_t read_u16(const uint8_t* bytes)
+{
+    return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+static uint32_t read_u32(const uint8_t* bytes)
+{
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+static bool is_tag(const uint8_t* bytes, const char* tag)
+{
+    return memcmp(bytes, tag, 4) == 0;
+}
+
+bool parse_wave(const uint8_t* data, size_t size, WaveFile* wave)
+{
+    if (size < 12 || !is_tag(data, "RIFF") || !is_tag(data + 8, "WAVE")) {
+        return false;
+    }
+
+    // Trust the file size over the RIFF size, some writers never patch it.
+    size_t riff_end = size;
+    uint32_t riff_size = read_u32(data + 4);
+    if (riff_size >= 4 && (size_t)riff_size + 8 < riff_end) {
+        riff_end = (size_t)riff_size + 8;
+    }
+
+    bool has_format = false;
+    bool has_data = false;
+    size_t offset = 12;
+    while (offset + 8 <= riff_end && !(has_format && has_data)) {
+        const uint8_t* chunk = data + offset;
+        uint32_t chunk_size = read_u32(chunk + 4);
+        const uint8_t* body = chunk + 8;
+        size_t available = riff_end - offset - 8;
+
+        if (is_tag(chunk, "fmt ")) {
+            if (chunk_size < 16 || chunk_size > available) {
+                return false;
+            }
+            wave->format_tag = read_u16(body + 0);
+            wave->channels = read_u16(body + 2);
+            wave->sample_rate = read_u32(body + 4);
+            wave->block_align = read_u16(body + 12);
+            wave->bits_per_sample = read_u16(body + 14);
+            if (wave->format_tag == WAVE_TAG_EXTENSIBLE) {
+                // cbSize, valid bits, channel mask, then the sub format GUID whose first two bytes are the tag.
+                if (chunk_size < 40) {
+                    return false;
+                }
+                wave->channel_mask = read_u32(body + 20);
+                wave->format_tag = read_u16(body + 24);
+            }
+            has_format = true;
+        }
+        else if (is_tag(chunk, "data")) {
+            // Truncated files keep whatever whole sample frames made it to disk.
+            wave->samples = body;
+            wave->sample_bytes = chunk_size < available ? chunk_size : (uint32_t)available;
+            has_data = true;
+        }
+
+        // Chunks are padded to an even size.
+        offset += 8 + (size_t)chunk_size + (chunk_size & 1);
+    }
+
+    if (!has_format || !has_data || wave->channels == 0 || wave->block_align == 0) {
+        return false;
+    }
+    wave->sample_bytes -= wave->sample_bytes % wave->block_align;
+    return true;
+}
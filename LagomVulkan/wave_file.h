@@ -0,0 +1,46 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+constexpr uint16_t WAVE_TAG_PCM = 0x0001;
+constexpr uint16_t WAVE_TAG_IEEE_FLOAT = 0x0003;
+constexpr uint16_t WAVE_TAG_EXTENSIBLE = 0xFFFE;
+
+// Channel mask bits of WAVE_FORMAT_EXTENSIBLE, channels are stored in bit order.
+constexpr uint32_t WAVE_SPEAKER_FRONT_LEFT = 0x1;
+constexpr uint32_t WAVE_SPEAKER_FRONT_RIGHT = 0x2;
+constexpr uint32_t WAVE_SPEAKER_FRONT_CENTER = 0x4;
+constexpr uint32_t WAVE_SPEAKER_LOW_FREQUENCY = 0x8;
+constexpr uint32_t WAVE_SPEAKER_BACK_LEFT = 0x10;
+constexpr uint32_t WAVE_SPEAKER_BACK_RIGHT = 0x20;
+constexpr uint32_t WAVE_SPEAKER_FRONT_LEFT_OF_CENTER = 0x40;
+constexpr uint32_t WAVE_SPEAKER_FRONT_RIGHT_OF_CENTER = 0x80;
+constexpr uint32_t WAVE_SPEAKER_BACK_CENTER = 0x100;
+constexpr uint32_t WAVE_SPEAKER_SIDE_LEFT = 0x200;
+constexpr uint32_t WAVE_SPEAKER_SIDE_RIGHT = 0x400;
+constexpr uint32_t WAVE_SPEAKER_TOP_CENTER = 0x800;
+constexpr uint32_t WAVE_SPEAKER_TOP_FRONT_LEFT = 0x1000;
+constexpr uint32_t WAVE_SPEAKER_TOP_FRONT_CENTER = 0x2000;
+constexpr uint32_t WAVE_SPEAKER_TOP_FRONT_RIGHT = 0x4000;
+constexpr uint32_t WAVE_SPEAKER_TOP_BACK_LEFT = 0x8000;
+constexpr uint32_t WAVE_SPEAKER_TOP_BACK_CENTER = 0x10000;
+constexpr uint32_t WAVE_SPEAKER_TOP_BACK_RIGHT = 0x20000;
+
+// Format and sample range of a RIFF/WAVE file. samples points into the
+// memory that was parsed, nothing is copied.
+struct WaveFile {
+    // PCM or IEEE float, extensible files report their sub format.
+    uint16_t format_tag = 0;
+    uint16_t channels = 0;
+    uint32_t sample_rate = 0;
+    uint16_t block_align = 0;
+    uint16_t bits_per_sample = 0;
+    // WAVE_SPEAKER_* bits of the channels in order, 0 when the file doesn't say.
+    uint32_t channel_mask = 0;
+    const uint8_t* samples = nullptr;
+    uint32_t sample_bytes = 0;
+};
+
+// Walks the RIFF chunk list in any order, skipping chunks it doesn't know.
+// All fields are read as fixed-width little-endian values.
+bool parse_wave(const uint8_t* data, size_t size, WaveFile* wave);
@@ -1,3 +1,4 @@
+#include "BUILD_OPTIONS.h"
 #include "window.h"
 #include "renderer.h"
 #include "shared.h"
@@ -90,6 +91,31 @@ const VkExtent2D Window::get_vulkan_surface_size() const
     return {_surface_size_x, _surface_size_y};
 }
 
+const VkImage Window::get_vulkan_active_swapchain_image() const
+{
+    return _swapchain_images[_active_swapchain_image_id];
+}
+
+const VkSurfaceFormatKHR Window::get_vulkan_surface_format() const
+{
+    return _surface_format;
+}
+
+const VkFormat Window::get_vulkan_depth_stencil_format() const
+{
+    return _depth_stencil_format;
+}
+
+const VkImage Window::get_vulkan_depth_stencil_image() const
+{
+    return _depth_stencil_image;
+}
+
+const VkImageView Window::get_vulkan_depth_sample_view() const
+{
+    return _depth_sample_view;
+}
+
 void Window::_init_surface() {
     _init_os_surface();
     VkPhysicalDevice gpu = _renderer->get_vulkan_physical_device();
@@ -167,6 +193,14 @@ void Window::_init_swapchain()
     swapchain_create_info.imageExtent.height = _surface_size_y;
     swapchain_create_info.imageArrayLayers = 1;
     swapchain_create_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+#if BUILD_ENABLE_DYNAMIC_RESOLUTION
+    // The scaled scene is blitted into the swapchain image.
+    if (!(_surface_capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT)) {
+        assert(0 && "Swapchain images can't be blit destinations");
+        std::exit(-1);
+    }
+    swapchain_create_info.imageUsage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+#endif
     swapchain_create_info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
     swapchain_create_info.queueFamilyIndexCount = 0;
     swapchain_create_info.pQueueFamilyIndices = nullptr;
@@ -233,7 +267,11 @@ void Window::_init_depth_stencil_image()
         for (int i = 0; i < try_formats.size(); ++i) {
             VkFormatProperties format_properties{};
             vkGetPhysicalDeviceFormatProperties(_renderer->get_vulkan_physical_device(), try_formats[i], &format_properties);
-            if (format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+            VkFormatFeatureFlags required_features = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT;
+#if BUILD_ENABLE_HIZ_OCCLUSION_CULLING
+            required_features |= VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+#endif
+            if ((format_properties.optimalTilingFeatures & required_features) == required_features) {
                 _depth_stencil_format = try_formats[i];
             }
         }
@@ -262,6 +300,9 @@ void Window::_init_depth_stencil_image()
     image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
     image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
     image_create_info.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+#if BUILD_ENABLE_HIZ_OCCLUSION_CULLING
+    image_create_info.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+#endif
     image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     image_create_info.queueFamilyIndexCount = VK_QUEUE_FAMILY_IGNORED;
     image_create_info.pQueueFamilyIndices = nullptr;
@@ -296,10 +337,19 @@ void Window::_init_depth_stencil_image()
     image_view_create_info.subresourceRange.layerCount = 1;
 
     error_check(vkCreateImageView(_renderer->get_vulkan_device(), &image_view_create_info, nullptr, &_depth_stencil_image_view));
+
+#if BUILD_ENABLE_HIZ_OCCLUSION_CULLING
+    // Sampled views may only contain a single aspect.
+    image_view_create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+    error_check(vkCreateImageView(_renderer->get_vulkan_device(), &image_view_create_info, nullptr, &_depth_sample_view));
+#endif
 }
 
 void Window::_deinit_depth_stencil_image()
 {
+    if (_depth_sample_view != VK_NULL_HANDLE) {
+        vkDestroyImageView(_renderer->get_vulkan_device(), _depth_sample_view, nullptr);
+    }
     vkDestroyImageView(_renderer->get_vulkan_device(), _depth_stencil_image_view, nullptr);
     vkFreeMemory(_renderer->get_vulkan_device(), _depth_stencil_image_memory, nullptr);
     vkDestroyImage(_renderer->get_vulkan_device(), _depth_stencil_image, nullptr);
@@ -317,6 +367,11 @@ void Window::_init_render_pass()
     attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
     attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
     attachments[0].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+#if BUILD_ENABLE_HIZ_OCCLUSION_CULLING
+    // Depth is kept and read by the Hi-Z pyramid build after the pass.
+    attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachments[0].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+#endif
 
     attachments[1].flags = 0;
     attachments[1].format = _surface_format.format;
@@ -347,6 +402,19 @@ void Window::_init_render_pass()
     render_pass_create_info.subpassCount = (uint32_t)sub_passes.size();
     render_pass_create_info.pSubpasses = sub_passes.data();
 
+#if BUILD_ENABLE_HIZ_OCCLUSION_CULLING
+    // Make the depth writes and final layout transition visible to the Hi-Z build.
+    VkSubpassDependency depth_dependency{};
+    depth_dependency.srcSubpass = 0;
+    depth_dependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+    depth_dependency.srcStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    depth_dependency.dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    depth_dependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    depth_dependency.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    render_pass_create_info.dependencyCount = 1;
+    render_pass_create_info.pDependencies = &depth_dependency;
+#endif
+
     error_check(vkCreateRenderPass(_renderer->get_vulkan_device(), &render_pass_create_info, nullptr, &_render_pass));
 }
 
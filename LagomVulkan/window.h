@@ -21,6 +21,12 @@ public:
     const VkRenderPass get_vulkan_render_pass() const;
     const VkFramebuffer get_vulkan_active_framebuffer() const;
     const VkExtent2D get_vulkan_surface_size() const;
+    const VkImage get_vulkan_active_swapchain_image() const;
+    const VkSurfaceFormatKHR get_vulkan_surface_format() const;
+    const VkFormat get_vulkan_depth_stencil_format() const;
+    const VkImage get_vulkan_depth_stencil_image() const;
+    // Depth aspect only view for sampling, VK_NULL_HANDLE unless the depth buffer is kept.
+    const VkImageView get_vulkan_depth_sample_view() const;
 
 private:
     void _init_os_window();
@@ -74,6 +80,7 @@ private:
     VkImage _depth_stencil_image = VK_NULL_HANDLE;
     VkDeviceMemory _depth_stencil_image_memory = VK_NULL_HANDLE;
     VkImageView _depth_stencil_image_view = VK_NULL_HANDLE;
+    VkImageView _depth_sample_view = VK_NULL_HANDLE;
 
     bool _stencil_available = false;
 